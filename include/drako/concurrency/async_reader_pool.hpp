@@ -2,16 +2,33 @@
 #ifndef DRAKO_ASYNC_READER_POOL_HPP
 #define DRAKO_ASYNC_READER_POOL_HPP
 
+#include "drako/concurrency/io_uring_reader.hpp"
+#include "drako/concurrency/job_scheduler.hpp"
+#include "drako/concurrency/lockfree_priority_queue.hpp"
 #include "drako/concurrency/lockfree_ringbuffer.hpp"
-#include "drako/core/container/static_vector.hpp"
 
 #include <rio/input_file_handle.hpp>
 
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
-#include <iostream>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <numeric>
 #include <optional>
 #include <span>
+#include <system_error>
 #include <thread>
 #include <type_traits>
 #include <vector>
@@ -21,6 +38,47 @@ namespace drako
     class AsyncReaderPoolInterface
     {
     public:
+        /// @brief Urgency of a read, more urgent requests are served first.
+        enum class Priority : std::uint8_t
+        {
+            immediate, // data needed to complete the current frame
+            normal,
+            prefetch, // data that could be needed in the future
+        };
+
+        /// @brief Context where the completion callback of a request is executed.
+        enum class Executor : std::uint8_t
+        {
+            poller,    // thread that calls poll()
+            io_worker, // I/O thread that completed the read, the callback must be short and non-blocking
+            scheduler, // job scheduler provided to the pool
+        };
+
+        /// @brief Identifier of a submitted request, delivered with its completion.
+        enum class Ticket : std::uint64_t
+        {
+        };
+
+        struct Request;
+
+        /// @brief Outcome of a request.
+        struct Completion
+        {
+            /// @brief Completed request
+            const Request* request;
+
+            /// @brief Ticket returned by the submission
+            Ticket ticket;
+
+            /// @brief Number of bytes read, less than requested if the end of the file was reached
+            std::size_t bytes;
+
+            /// @brief Error reported by the system, if any
+            std::error_code error;
+        };
+
+        using Callback = std::function<void(const Completion&)>;
+
         struct Request
         {
             /// @brief Source open handle of the file
@@ -31,51 +89,128 @@ namespace drako
 
             /// @brief Bytes offset from the start of the file
             std::size_t offset;
+
+            /// @brief Urgency of the request
+            Priority priority = Priority::normal;
+
+            /// @brief Invoked with the completion instead of delivering it through poll(), optional
+            Callback callback = {};
+
+            /// @brief Where the callback is executed
+            Executor executor = Executor::poller;
         };
 
-        virtual bool submit(const Request*) noexcept;
-        virtual bool retrive(Request*) noexcept;
+        virtual ~AsyncReaderPoolInterface() = default;
+
+        /// @brief Schedules a read.
+        ///
+        /// @return Ticket of the request, or nothing if it couldn't be scheduled.
+        ///
+        /// @note The request must stay alive until its completion has been delivered.
+        ///
+        [[nodiscard]] virtual std::optional<Ticket> submit(const Request*) noexcept = 0;
+
+        /// @brief Retrieves a batch of completions.
+        ///
+        /// Completions of requests with a callback bound to the poller are consumed
+        /// by executing the callback, so they aren't stored in the destination.
+        ///
+        /// @return Number of completions, stored in a prefix of the destination.
+        ///
+        /// @warning Must be called from a single thread at a time.
+        ///
+        [[nodiscard]] virtual std::size_t poll(std::span<Completion>) = 0;
     };
 
 
-    class AsyncReaderPool : AsyncReaderPoolInterface
+    class AsyncReaderPool final : public AsyncReaderPoolInterface
     {
     public:
+        /// @brief Mechanism used by the workers to perform the reads.
+        enum class Backend : std::uint8_t
+        {
+            threads,  // blocking reads, one at a time for each worker
+            io_uring, // batches of asynchronous reads, each worker owns a ring (Linux only)
+        };
+
         struct Args
         {
             /// @brief Number of worker threads.
             std::size_t workers;
 
-            /// @brief Capacity of the input buffer of each worker.
+            /// @brief Expected number of pending requests for each worker.
             std::size_t submit_queue_size;
 
             /// @brief Capacity of the output buffer of each worker.
             std::size_t output_queue_size;
+
+            /// @brief Preferred backend, the thread pool is used as fallback when it's not available.
+            Backend backend = Backend::io_uring;
+
+            /// @brief Max number of reads in flight for each worker, ignored by the thread pool.
+            std::uint32_t queue_depth = 64;
+
+            /// @brief Destination buffers registered in advance with the kernel, if supported.
+            std::span<const std::span<std::byte>> registered_buffers = {};
+
+            /// @brief Source files registered in advance with the kernel, if supported.
+            std::span<const rio::Handle> registered_files = {};
+
+            /// @brief Executor of the callbacks bound to Executor::scheduler.
+            JobScheduler* scheduler = nullptr;
+
+            /// @brief Max distance as bytes between reads of the same file that are merged.
+            std::size_t merge_max_gap = 4 * 1024;
+
+            /// @brief Max size as bytes of a merged read, zero disables merging.
+            std::size_t merge_max_size = 128 * 1024;
+        };
+
+        /// @brief Counters of the reads performed by the pool.
+        struct Stats
+        {
+            /// @brief Requests served by a read shared with other requests.
+            std::uint64_t merged;
+
+            /// @brief Reads issued to the system.
+            std::uint64_t issued;
         };
 
         explicit AsyncReaderPool(const Args& args) //std::size_t workers, std::size_t capacity)
+            : _submitted{ 2 * args.workers, args.submit_queue_size / 2 }
+            , _scheduler{ args.scheduler }
+            , _merge_max_gap{ args.merge_max_gap }
+            , _merge_max_size{ args.merge_max_size }
         {
             assert(args.workers > 0);
             assert(args.submit_queue_size > 0);
             assert(args.output_queue_size > 0);
 
-            for (auto i = 0; i < args.workers; ++i)
-                _submit_queues.emplace_back(args.submit_queue_size);
+            _output_queues.reserve(args.workers);
+            for (std::size_t i = 0; i < args.workers; ++i)
+                _output_queues.push_back(std::make_unique<_queue>(args.output_queue_size));
 
-            for (auto i = 0; i < args.workers; ++i)
-                _output_queues.emplace_back(args.output_queue_size);
+#if defined(__linux__)
+            if (args.backend == Backend::io_uring)
+                _setup_rings(args);
+#endif
 
             // create background threads
             _workers.reserve(args.workers);
-            for (auto i = 0; i < args.workers; ++i)
-                _workers.push_back(std::thread{
-                    _run, std::ref(_done),
-                    std::ref(_submit_queues[i]), std::ref(_output_queues[i]) });
+            for (std::size_t i = 0; i < args.workers; ++i)
+#if defined(__linux__)
+                if (!std::empty(_rings))
+                    _workers.emplace_back(&AsyncReaderPool::_run_ring, this,
+                        std::ref(*_rings[i]), std::ref(*_output_queues[i]));
+                else
+#endif
+                    _workers.emplace_back(&AsyncReaderPool::_run, this, std::ref(*_output_queues[i]));
         }
 
         ~AsyncReaderPool() noexcept
         {
             _done.test_and_set(std::memory_order::release);
+            _submitted.wake_consumers();
             for (auto& w : _workers)
                 w.join();
         }
@@ -100,20 +235,61 @@ namespace drako
         }
         */
 
-        [[nodiscard]] bool submit(const Request* r) noexcept
+        /// @brief Schedules a read.
+        ///
+        /// Requests are served in order of priority by the first worker that becomes idle,
+        /// so the load is spread across the workers.
+        ///
+        [[nodiscard]] std::optional<Ticket> submit(const Request* r) noexcept override
         {
-            //static thread_local std::size_t worker = 0;
-            //return _submit(worker++ % std::size(_workers), r);
-            return _submit(0, r);
+            assert(r);
+            assert(r->executor != Executor::scheduler || _scheduler); // no executor available
+            const auto ticket = Ticket{ _next_ticket.fetch_add(1, std::memory_order::relaxed) };
+            try
+            {
+                _submitted.push(r->priority, { r, ticket });
+                return ticket;
+            }
+            catch (const std::bad_alloc&)
+            {
+                return std::nullopt;
+            }
+        }
+
+        [[nodiscard]] std::size_t poll(std::span<Completion> completions) override
+        {
+            // rotate the first worker visited, so that no output queue is starved
+            const auto  workers = std::size(_output_queues);
+            const auto  first   = _next_poll++ % workers;
+            std::size_t count   = 0;
+            for (std::size_t k = 0; k < workers && count < std::size(completions); ++k)
+            {
+                const auto n = _output_queues[(first + k) % workers]->deque_bulk(completions.subspan(count));
+                for (const auto& c : completions.subspan(count, n))
+                    if (c.request->callback)
+                        std::invoke(c.request->callback, c);
+                    else
+                        completions[count++] = c;
+            }
+            return count;
         }
 
-        [[nodiscard]] bool retrieve(Request* r) noexcept
+        /// @brief Counters of the reads performed so far.
+        [[nodiscard]] Stats stats() const noexcept
         {
-            //static thread_local std::size_t worker = 0;
-            //return _retrive(worker++ % std::size(_workers), r);
-            //return _retrive(0, r);
+            return { .merged = _merged.load(std::memory_order::relaxed),
+                .issued      = _issued.load(std::memory_order::relaxed) };
         }
 
+        /// @brief Backend actually in use.
+        [[nodiscard]] Backend backend() const noexcept
+        {
+#if defined(__linux__)
+            if (!std::empty(_rings))
+                return Backend::io_uring;
+#endif
+            return Backend::threads;
+        }
 
     private:
         /*
@@ -137,54 +313,417 @@ namespace drako
         static_assert(std::is_nothrow_copy_constructible_v<_packet>);
         */
 
-        using _queue = drako::lockfree::RingBuffer<const Request*>;
+        struct _pending
+        {
+            const Request* request;
+            Ticket         ticket;
+        };
 
-        StaticVector<_queue, 4>  _submit_queues;
-        StaticVector<_queue, 4>  _output_queues;
-        std::vector<std::thread> _workers;
-        std::atomic_flag         _done; // since c++20 is initialized to clear state
+        // reads of the same file merged into a single one
+        struct _merged_read
+        {
+            std::span<const _pending> parts; // sorted by offset
+            std::size_t               offset;
+            std::size_t               length;
+        };
 
-        static void _run(std::atomic_flag& done, _queue& in, _queue& out)
+        struct _result
         {
-            while (!done.test(std::memory_order::acquire))
+            std::size_t     bytes;
+            std::error_code error;
+        };
+
+        using _queue          = drako::lockfree::RingBuffer<Completion>;
+        using _priority_queue = drako::lockfree::PriorityQueue<_pending, Priority>;
+
+        static constexpr const std::size_t _batch_size = 32;
+
+        _priority_queue            _submitted; // shared by all workers
+        std::vector<std::thread>   _workers;
+        std::atomic_flag           _done; // since c++20 is initialized to clear state
+        JobScheduler*              _scheduler;
+        std::atomic<std::uint64_t> _next_ticket = 0;
+        std::size_t                _next_poll   = 0; // owned by the polling thread
+        const std::size_t          _merge_max_gap;
+        const std::size_t          _merge_max_size;
+        std::atomic<std::uint64_t> _merged = 0;
+        std::atomic<std::uint64_t> _issued = 0;
+        std::vector<std::unique_ptr<_queue>> _output_queues; // one for each worker
+#if defined(__linux__)
+        std::vector<std::unique_ptr<IoUringReader>> _rings; // one for each worker, empty if not supported
+#endif
+
+        [[nodiscard]] bool _stopped() const noexcept { return _done.test(std::memory_order::acquire); }
+
+        // thread pool backend, each worker performs blocking reads
+        void _run(_queue& out)
+        {
+            std::array<_pending, _batch_size>     batch;
+            std::array<_merged_read, _batch_size> runs;
+            std::array<Completion, _batch_size>   completed;
+            std::vector<std::byte>                scratch; // destination of merged reads
+            const auto                            stop = [this]() { return _stopped(); };
+
+            // idle workers park inside the queue instead of burning a core
+            for (std::size_t n; (n = _submitted.pop_min_bulk_wait(batch, stop)) > 0;)
             {
-                for (const Request* request; in.deque(request);)
+                std::size_t count = 0;
+                for (const auto& run : std::span{ runs }.first(_coalesce(std::span{ batch }.first(n), runs)))
+                    if (std::size(run.parts) > 1 && _resize(scratch, run.length))
+                    {
+                        const auto dst = std::span{ scratch }.first(run.length);
+                        _scatter(run, dst, _read(run.parts.front().request->src, dst, run.offset),
+                            std::span{ completed }.subspan(count));
+                        count += std::size(run.parts);
+                    }
+                    else
+                        for (const auto& p : run.parts)
+                        {
+                            const auto& r       = *p.request;
+                            completed[count++] = _complete(p, _read(r.src, r.dst, r.offset));
+                            _issued.fetch_add(1, std::memory_order::relaxed);
+                        }
+
+                // publish the whole batch of completions at once
+                _publish(out, std::span{ completed }.first(_dispatch(std::span{ completed }.first(count))));
+            }
+        }
+
+        [[nodiscard]] static _result _read(rio::Handle src, std::span<std::byte> dst, std::size_t offset) noexcept
+        {
+            const auto  size  = std::size(dst);
+            std::size_t bytes = 0;
+            while (bytes < size)
+            {
+                const auto position = offset + bytes;
+#if defined(_WIN32)
+                OVERLAPPED o{};
+                o.Offset     = static_cast<DWORD>(position);
+                o.OffsetHigh = static_cast<DWORD>(static_cast<std::uint64_t>(position) >> 32);
+
+                DWORD      n     = 0;
+                const auto chunk = static_cast<DWORD>(std::min<std::size_t>(size - bytes, MAXDWORD));
+                if (!::ReadFile(src, std::data(dst) + bytes, chunk, &n, &o))
                 {
-                    //packet.src.read(packet.dst, packet.bytes);
-                    std::clog << "Thread " << std::this_thread::get_id()
-                              << ": read " << request->dst.size_bytes() << " bytes.\n";
+                    if (const auto e = ::GetLastError(); e != ERROR_HANDLE_EOF)
+                        return { .bytes = bytes, .error = { static_cast<int>(e), std::system_category() } };
+                    break;
+                }
+#else
+                const auto n = ::pread(src, std::data(dst) + bytes, size - bytes, static_cast<off_t>(position));
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return { .bytes = bytes, .error = { errno, std::system_category() } };
+                }
+#endif
+                if (n == 0) // end of file
+                    break;
+                bytes += static_cast<std::size_t>(n);
+            }
+            return { .bytes = bytes, .error = {} };
+        }
 
-                    //std::invoke(request.callback);
-                    assert(out.enque(request));
+        [[nodiscard]] static Completion _complete(const _pending& p, const _result& r) noexcept
+        {
+            return { .request = p.request, .ticket = p.ticket, .bytes = r.bytes, .error = r.error };
+        }
+
+        // groups reads of the same file that are close to each other, returns the number of runs
+        [[nodiscard]] std::size_t _coalesce(std::span<_pending> batch, std::span<_merged_read> runs) const noexcept
+        {
+            std::sort(std::begin(batch), std::end(batch), [](const auto& a, const auto& b) {
+                const auto &x = *a.request, &y = *b.request;
+                return std::less<>{}(x.src, y.src) || (x.src == y.src && x.offset < y.offset);
+            });
+
+            std::size_t count = 0;
+            for (std::size_t i = 0, j; i < std::size(batch); i = j)
+            {
+                const auto& first = *batch[i].request;
+                auto        end   = first.offset + std::size(first.dst);
+                for (j = i + 1; j < std::size(batch); ++j)
+                {
+                    const auto& r       = *batch[j].request;
+                    const auto  new_end = std::max(end, r.offset + std::size(r.dst));
+                    if (r.src != first.src || r.offset > end + _merge_max_gap || new_end - first.offset > _merge_max_size)
+                        break;
+                    end = new_end;
                 }
+                runs[count++] = { .parts = batch.subspan(i, j - i), .offset = first.offset, .length = end - first.offset };
+            }
+            return count;
+        }
 
-                // TODO: this should be supported in c++20 to avoid busy wait
-                // done.wait(false, std::memory_order::acquire);
-                std::this_thread::yield();
+        // grows the destination of a merged read, failures fall back to separate reads
+        [[nodiscard]] static bool _resize(std::vector<std::byte>& scratch, std::size_t size) noexcept
+        {
+            try
+            {
+                if (std::size(scratch) < size)
+                    scratch.resize(size);
+                return true;
+            }
+            catch (const std::bad_alloc&)
+            {
+                return false;
             }
         }
 
-        [[nodiscard]] bool _submit(const std::size_t worker, const Request* r)
+        // copies the data of a merged read to the destinations of its requests
+        void _scatter(const _merged_read& run, std::span<const std::byte> data,
+            const _result& result, std::span<Completion> completed) noexcept
         {
-            assert(worker < std::size(_workers));
-            assert(r);
+            for (std::size_t i = 0; i < std::size(run.parts); ++i)
+            {
+                const auto& r     = *run.parts[i].request;
+                const auto  begin = r.offset - run.offset;
+                const auto  bytes = result.bytes > begin ? std::min(std::size(r.dst), result.bytes - begin) : 0;
+                std::memcpy(std::data(r.dst), std::data(data) + begin, bytes);
+
+                // requests fully served before the failure are still successful
+                const auto error = (bytes == std::size(r.dst)) ? std::error_code{} : result.error;
+                completed[i]     = _complete(run.parts[i], { .bytes = bytes, .error = error });
+            }
+            _merged.fetch_add(std::size(run.parts), std::memory_order::relaxed);
+            _issued.fetch_add(1, std::memory_order::relaxed);
+        }
 
-            return _submit_queues[worker].enque(r);
+        // runs the callbacks that don't belong to the poller, returns the number of completions left
+        [[nodiscard]] std::size_t _dispatch(std::span<Completion> completed)
+        {
+            std::size_t count = 0;
+            for (const auto& c : completed)
+            {
+                const auto& r = *c.request;
+                if (!r.callback || r.executor == Executor::poller)
+                    completed[count++] = c;
+                else if (r.executor == Executor::scheduler)
+                    try
+                    {
+                        _scheduler->submit([c]() { std::invoke(c.request->callback, c); });
+                    }
+                    catch (const std::bad_alloc&) // better late than never
+                    {
+                        std::invoke(r.callback, c);
+                    }
+                else
+                    std::invoke(r.callback, c);
+            }
+            return count;
         }
 
-        [[nodiscard]] bool _retrive(const std::size_t worker, const Request* r)
+        void _publish(_queue& out, std::span<const Completion> completed)
         {
-            assert(worker < std::size(_workers));
-            assert(r);
+            for (std::size_t sent = 0; sent < std::size(completed);)
+                if (const auto k = out.enque_bulk(completed.subspan(sent)); k > 0)
+                    sent += k;
+                else if (_stopped()) // nobody is going to retrieve the completions
+                    return;
+                else
+                    std::this_thread::yield();
+        }
 
-            return _output_queues[worker].deque(r);
+#if defined(__linux__)
+        void _setup_rings(const Args& args) noexcept
+        {
+            static_assert(std::is_convertible_v<rio::Handle, int>, "expected a file descriptor");
+            const std::vector<int> files(std::begin(args.registered_files), std::end(args.registered_files));
+            try
+            {
+                for (std::size_t i = 0; i < args.workers; ++i)
+                {
+                    auto& ring = _rings.emplace_back(std::make_unique<IoUringReader>(args.queue_depth));
+                    if (!std::empty(args.registered_buffers))
+                        ring->register_buffers(args.registered_buffers);
+                    if (!std::empty(files))
+                        ring->register_files(files);
+                }
+            }
+            catch (const std::exception&) // not supported by the kernel or not allowed
+            {
+                _rings.clear();
+            }
         }
+
+        // io_uring backend, each worker keeps its ring full and reaps completions in batches
+        void _run_ring(IoUringReader& ring, _queue& out)
+        {
+            // read in flight, the kernel hands back the address of its slot
+            struct _slot
+            {
+                std::vector<_pending>  parts;   // requests served by the read
+                std::vector<std::byte> scratch; // destination of a merged read
+                rio::Handle            src;
+                std::span<std::byte>   dst;
+                std::size_t            offset;
+                std::size_t            done; // bytes already read
+            };
+
+            std::array<_pending, _batch_size>                  batch;
+            std::array<_merged_read, _batch_size>              runs;
+            std::array<IoUringReader::Read, _batch_size>       reads;
+            std::array<IoUringReader::Completion, _batch_size> reaped;
+            std::array<Completion, _batch_size>                completed;
+            const auto                                         stop = [this]() { return _stopped(); };
+
+            std::vector<_slot>         slots(ring.capacity());
+            std::vector<std::uint32_t> free_slots(ring.capacity());
+            std::iota(std::rbegin(free_slots), std::rend(free_slots), std::uint32_t{ 0 });
+            for (auto& slot : slots)
+                slot.parts.reserve(_batch_size);
+
+            const auto acquire = [&](std::span<const _pending> parts, std::size_t offset) -> _slot& {
+                auto& slot = slots[free_slots.back()];
+                free_slots.pop_back();
+                slot.parts.assign(std::begin(parts), std::end(parts));
+                slot.src    = parts.front().request->src;
+                slot.offset = offset;
+                slot.done   = 0;
+                return slot;
+            };
+            const auto release = [&](_slot& slot) {
+                free_slots.push_back(static_cast<std::uint32_t>(&slot - std::data(slots)));
+            };
+
+            // the kernel reads at most max_read_size bytes at once and can stop short,
+            // so a slot keeps issuing reads until end of file like the thread backend
+            const auto next_read = [](_slot& slot) -> IoUringReader::Read {
+                const auto remaining = std::size(slot.dst) - slot.done;
+                return { .fd = slot.src,
+                    .dst       = slot.dst.subspan(slot.done, std::min(remaining, IoUringReader::max_read_size)),
+                    .offset    = slot.offset + slot.done,
+                    .user_data = &slot };
+            };
+
+            std::size_t count = 0; // completions not yet published
+            const auto  flush = [&]() {
+                _publish(out, std::span{ completed }.first(_dispatch(std::span{ completed }.first(count))));
+                count = 0;
+            };
+
+            // buffers of the reads in flight are written by the kernel,
+            // so the worker can leave only after all of them have completed
+            for (std::size_t in_flight = 0;;)
+            {
+                const auto  space = std::min<std::size_t>(_batch_size, ring.capacity() - in_flight);
+                std::size_t n     = 0;
+                if (in_flight == 0) // nothing to reap, park until new requests arrive
+                {
+                    if ((n = _submitted.pop_min_bulk_wait(std::span{ batch }.first(space), stop)) == 0)
+                        return;
+                }
+                else if (space > 0 && !_stopped())
+                    n = _submitted.try_pop_min_bulk(std::span{ batch }.first(space));
+
+                // merging never needs more slots than requests
+                std::size_t m = 0;
+                for (const auto& run : std::span{ runs }.first(_coalesce(std::span{ batch }.first(n), runs)))
+                {
+                    if (std::size(run.parts) > 1)
+                    {
+                        auto& slot = acquire(run.parts, run.offset);
+                        if (_resize(slot.scratch, run.length))
+                        {
+                            slot.dst   = std::span{ slot.scratch }.first(run.length);
+                            reads[m++] = next_read(slot);
+                            continue;
+                        }
+                        release(slot);
+                    }
+                    for (const auto& p : run.parts)
+                    {
+                        auto& slot = acquire({ &p, 1 }, p.request->offset);
+                        slot.dst   = p.request->dst;
+                        reads[m++] = next_read(slot);
+                    }
+                }
+                [[maybe_unused]] const auto queued = ring.submit(std::span{ reads }.first(m));
+                assert(queued == m); // the space was reserved in advance
+                in_flight += m;
+
+                // block on the kernel only when there was nothing new to submit
+                const auto  k       = ring.reap(reaped, n == 0 ? 1 : 0);
+                std::size_t resumed = 0; // reads of the remainder of short reads
+                for (const auto& c : std::span{ reaped }.first(k))
+                {
+                    auto& slot = *static_cast<_slot*>(const_cast<void*>(c.user_data));
+                    if (c.result > 0)
+                    {
+                        slot.done += static_cast<std::size_t>(c.result);
+                        if (slot.done < std::size(slot.dst))
+                        {
+                            reads[resumed++] = next_read(slot);
+                            continue;
+                        }
+                    }
+                    const _result result = { .bytes = slot.done,
+                        .error                      = { c.result >= 0 ? 0 : -c.result, std::system_category() } };
+
+                    if (std::size(completed) - count < std::size(slot.parts))
+                        flush();
+                    if (std::size(slot.parts) > 1)
+                    {
+                        const _merged_read run = { .parts = slot.parts, .offset = slot.offset, .length = std::size(slot.dst) };
+                        _scatter(run, slot.dst, result, std::span{ completed }.subspan(count));
+                        count += std::size(slot.parts);
+                    }
+                    else
+                    {
+                        completed[count++] = _complete(slot.parts.front(), result);
+                        _issued.fetch_add(1, std::memory_order::relaxed);
+                    }
+                    release(slot);
+                }
+                // the completed reads left room in the ring for the resumed ones
+                [[maybe_unused]] const auto requeued = ring.submit(std::span{ reads }.first(resumed));
+                assert(requeued == resumed);
+                in_flight -= k - resumed;
+                flush();
+            }
+        }
+#endif
     };
 
 
     /// @brief Mock class for testing without actual I/O operations
-    class AsyncReaderPoolMock : AsyncReaderPoolInterface
+    ///
+    /// Every request completes as soon as it's submitted, reporting all the bytes as read.
+    ///
+    class AsyncReaderPoolMock final : public AsyncReaderPoolInterface
     {
+    public:
+        [[nodiscard]] std::optional<Ticket> submit(const Request* r) noexcept override
+        {
+            assert(r);
+            const auto ticket = Ticket{ _next_ticket++ };
+            try
+            {
+                _completed.push_back({ .request = r, .ticket = ticket, .bytes = std::size(r->dst), .error = {} });
+                return ticket;
+            }
+            catch (const std::bad_alloc&)
+            {
+                return std::nullopt;
+            }
+        }
+
+        [[nodiscard]] std::size_t poll(std::span<Completion> completions) override
+        {
+            std::size_t count = 0, consumed = 0;
+            for (; consumed < std::size(_completed) && count < std::size(completions); ++consumed)
+                if (const auto& c = _completed[consumed]; c.request->callback)
+                    std::invoke(c.request->callback, c); // every executor is emulated by the poller
+                else
+                    completions[count++] = c;
+            _completed.erase(std::begin(_completed), std::begin(_completed) + consumed);
+            return count;
+        }
+
+    private:
+        std::vector<Completion> _completed;
+        std::uint64_t           _next_ticket = 0;
     };
 
 } // namespace drako
@@ -2,9 +2,12 @@
 #ifndef DRAKO_CONCURRENT_LIST_HPP
 #define DRAKO_CONCURRENT_LIST_HPP
 
-#include <atomic>
+#include "drako/concurrency/memory_reclamation.hpp"
 
-#include "core/compiler_macros.hpp"
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
 
 namespace drako::concurrency
 {
@@ -24,30 +27,154 @@ namespace drako::concurrency
     // CLASS TEMPLATE
     // Lock-free linearizable list based on Harris-Michael algorithm.
     //
+    // Elements are kept sorted and unique. Removal first marks the link of the node
+    // as logically deleted and then unlinks it; unlinked nodes are retired to
+    // an epoch domain since concurrent traversals may still be reading them.
+    //
     template <typename T>
     class lockfree_list final
     {
     public:
 
-        explicit lockfree_list() noexcept;
-        ~lockfree_list() noexcept;
-
-        lockfree_list(const lockfree_list&) = delete;
-        lockfree_list& lockfree_list(const lockfree_list&) = delete;
-
-        void insert() noexcept;
+        explicit lockfree_list(lockfree::EpochDomain& domain = lockfree::EpochDomain::global()) noexcept
+            : _domain{ domain } {}
 
-        void discard() noexcept;
+        // No other thread can access the list when it's destroyed.
+        ~lockfree_list() noexcept
+        {
+            for (auto n = _ptr(_head.load(std::memory_order::relaxed)); n != nullptr;)
+                delete std::exchange(n, _ptr(n->next.load(std::memory_order::relaxed)));
+        }
 
-        void remove() noexcept;
-
-        DRAKO_NODISCARD
-            bool contains(const T& value) noexcept;
+        lockfree_list(const lockfree_list&) = delete;
+        lockfree_list& operator=(const lockfree_list&) = delete;
+
+        // Inserts a value, returns false if it's already in the list.
+        bool insert(const T& value)
+        {
+            const auto guard = _domain.pin();
+
+            _node* n = nullptr;
+            for (;;)
+            {
+                auto [prev, curr] = _find(value, guard);
+                if (curr != nullptr && curr->value == value)
+                {
+                    delete n;
+                    return false;
+                }
+
+                if (n == nullptr)
+                    n = new _node{ value, _link(curr) };
+                else
+                    n->next.store(_link(curr), std::memory_order::relaxed);
+
+                auto expected = _link(curr);
+                if (prev->compare_exchange_strong(expected, _link(n),
+                    std::memory_order::release, std::memory_order::relaxed))
+                    return true;
+            }
+        }
+
+        // Removes a value, returns false if it isn't in the list.
+        bool remove(const T& value)
+        {
+            const auto guard = _domain.pin();
+            for (;;)
+            {
+                auto [prev, curr] = _find(value, guard);
+                if (curr == nullptr || !(curr->value == value))
+                    return false;
+
+                // logical deletion
+                auto next = curr->next.load(std::memory_order::acquire);
+                if (_marked(next))
+                    continue; // another thread is removing the node
+                if (!curr->next.compare_exchange_strong(next, next | _mark,
+                    std::memory_order::acq_rel, std::memory_order::relaxed))
+                    continue;
+
+                // physical deletion, on failure let a traversal do the cleanup
+                auto expected = _link(curr);
+                if (prev->compare_exchange_strong(expected, next,
+                    std::memory_order::acq_rel, std::memory_order::relaxed))
+                    _domain.retire(guard, curr);
+                else
+                    _find(value, guard);
+                return true;
+            }
+        }
+
+        // Checks whether a value is in the list, never modifies the list.
+        [[nodiscard]] bool contains(const T& value) const noexcept
+        {
+            const auto guard = _domain.pin();
+
+            auto curr = _ptr(_head.load(std::memory_order::acquire));
+            while (curr != nullptr && curr->value < value)
+                curr = _ptr(curr->next.load(std::memory_order::acquire));
+
+            return curr != nullptr && curr->value == value
+                && !_marked(curr->next.load(std::memory_order::acquire));
+        }
 
     private:
 
-        std::atomic<T*> _head;
-        std::atomic<T*> _tail;
+        struct _node
+        {
+            const T                    value;
+            std::atomic<std::uintptr_t> next; // pointer to the next node | deletion mark
+        };
+
+        static constexpr const std::uintptr_t _mark = 1;
+
+        static_assert(alignof(_node) > 1, "Low bit of node pointers is used as deletion mark.");
+
+        [[nodiscard]] static bool _marked(std::uintptr_t link) noexcept { return link & _mark; }
+
+        [[nodiscard]] static _node* _ptr(std::uintptr_t link) noexcept
+        {
+            return reinterpret_cast<_node*>(link & ~_mark);
+        }
+
+        [[nodiscard]] static std::uintptr_t _link(_node* n) noexcept
+        {
+            return reinterpret_cast<std::uintptr_t>(n);
+        }
+
+        // Finds the first node not less than the value and the link that points to it,
+        // unlinking marked nodes along the way.
+        std::pair<std::atomic<std::uintptr_t>*, _node*> _find(const T& value, const lockfree::EpochDomain::Guard& guard)
+        {
+        retry:
+            auto prev = &_head;
+            auto curr = _ptr(prev->load(std::memory_order::acquire));
+            while (curr != nullptr)
+            {
+                const auto next = curr->next.load(std::memory_order::acquire);
+                if (_marked(next))
+                {
+                    // fails if prev has been marked or changed
+                    auto expected = _link(curr);
+                    if (!prev->compare_exchange_strong(expected, next & ~_mark,
+                        std::memory_order::acq_rel, std::memory_order::relaxed))
+                        goto retry;
+
+                    _domain.retire(guard, curr);
+                    curr = _ptr(next);
+                    continue;
+                }
+                if (!(curr->value < value))
+                    break;
+
+                prev = &curr->next;
+                curr = _ptr(next);
+            }
+            return { prev, curr };
+        }
+
+        std::atomic<std::uintptr_t> _head = 0;
+        lockfree::EpochDomain&      _domain;
     };
 
 } // namespace drako::concurrency
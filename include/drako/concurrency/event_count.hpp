@@ -0,0 +1,160 @@
+#pragma once
+#ifndef DRAKO_EVENT_COUNT_HPP
+#define DRAKO_EVENT_COUNT_HPP
+
+/// @file
+/// @brief  Blocking wait for consumers of lock-free containers.
+/// @author Grassi Edoardo
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace drako
+{
+    /// @brief Hints the processor that the caller is inside a spin-wait loop.
+    inline void cpu_relax() noexcept
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield" ::: "memory");
+#else
+        std::atomic_signal_fence(std::memory_order::seq_cst);
+#endif
+    }
+
+
+    /// @brief Condition variable for lock-free algorithms.
+    ///
+    /// Consumers register themselves before checking their condition for the last time
+    /// and then park on std::atomic::wait (a futex on Linux, WaitOnAddress on Windows).
+    /// Producers only pay for a fence and a load unless somebody is actually sleeping.
+    ///
+    /// Usage on the consumer side:
+    ///     ec.await([&]() { return queue.deque(value); });
+    ///
+    /// Usage on the producer side:
+    ///     queue.enque(value);
+    ///     ec.notify_one();
+    ///
+    class EventCount
+    {
+    public:
+        /// @brief Number of polls of the condition before parking the thread.
+        static constexpr const std::size_t default_spins = 64;
+
+        explicit EventCount() noexcept = default;
+
+        EventCount(const EventCount&) = delete;
+        EventCount& operator=(const EventCount&) = delete;
+
+        /// @brief Registers the calling thread as a waiter.
+        ///
+        /// The condition must be checked again after this call, then the wait
+        /// must be completed with either cancel_wait() or commit_wait().
+        ///
+        /// @return Key to be passed to commit_wait().
+        ///
+        [[nodiscard]] std::uint32_t prepare_wait() noexcept
+        {
+            const auto state = _state.fetch_add(1, std::memory_order::seq_cst);
+            // orders the registration before the following check of the condition
+            std::atomic_thread_fence(std::memory_order::seq_cst);
+            return static_cast<std::uint32_t>(state >> _epoch_shift);
+        }
+
+        /// @brief Unregisters the calling thread, the condition was satisfied after all.
+        void cancel_wait() noexcept { _state.fetch_sub(1, std::memory_order::relaxed); }
+
+        /// @brief Parks the calling thread until a notification issued after prepare_wait().
+        void commit_wait(std::uint32_t key) noexcept
+        {
+            for (auto state = _state.load(std::memory_order::acquire);
+                 static_cast<std::uint32_t>(state >> _epoch_shift) == key;
+                 state = _state.load(std::memory_order::acquire))
+                _state.wait(state, std::memory_order::acquire);
+            _state.fetch_sub(1, std::memory_order::relaxed);
+        }
+
+        /// @brief Wakes up a waiting thread, if any.
+        ///
+        /// @note Must be called after the condition has been made true.
+        ///
+        void notify_one() noexcept
+        {
+            if (_bump())
+                _state.notify_one();
+        }
+
+        /// @brief Wakes up all the waiting threads.
+        void notify_all() noexcept
+        {
+            if (_bump())
+                _state.notify_all();
+        }
+
+        /// @brief Blocks until the condition is satisfied.
+        ///
+        /// The condition is polled for a short time before parking the thread,
+        /// to avoid a round trip through the kernel when the wait is short.
+        ///
+        /// @param[in] ready Condition, evaluated again after each wake up.
+        /// @param[in] spins Number of polls before parking.
+        ///
+        template <typename Predicate>
+        void await(Predicate ready, std::size_t spins = default_spins)
+        {
+            for (std::size_t i = 0; i < spins; ++i)
+            {
+                if (ready())
+                    return;
+                cpu_relax();
+            }
+
+            while (!ready())
+            {
+                const auto key = prepare_wait();
+                if (ready())
+                {
+                    cancel_wait();
+                    return;
+                }
+                commit_wait(key);
+            }
+        }
+
+        /// @brief Number of threads that are parked or about to park.
+        [[nodiscard]] std::size_t waiters() const noexcept
+        {
+            return static_cast<std::size_t>(_state.load(std::memory_order::relaxed) & _waiters_mask);
+        }
+
+    private:
+        // high half holds the epoch of notifications, low half the number of waiters
+        static constexpr const int           _epoch_shift  = 32;
+        static constexpr const std::uint64_t _waiters_mask = (std::uint64_t{ 1 } << _epoch_shift) - 1;
+
+        std::atomic<std::uint64_t> _state = 0;
+
+        // advances the epoch, returns false if there is nobody to wake up
+        [[nodiscard]] bool _bump() noexcept
+        {
+            // orders the publication of the condition before the check of the waiters
+            std::atomic_thread_fence(std::memory_order::seq_cst);
+            if ((_state.load(std::memory_order::relaxed) & _waiters_mask) == 0)
+                return false;
+            _state.fetch_add(std::uint64_t{ 1 } << _epoch_shift, std::memory_order::acq_rel);
+            return true;
+        }
+    };
+
+} // namespace drako
+
+#endif // !DRAKO_EVENT_COUNT_HPP
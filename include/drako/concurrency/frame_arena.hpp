@@ -0,0 +1,204 @@
+#pragma once
+#ifndef DRAKO_FRAME_ARENA_HPP
+#define DRAKO_FRAME_ARENA_HPP
+
+/// @file
+/// @brief  Linear arenas for temporary allocations that live for a bounded number of frames.
+/// @author Grassi Edoardo
+
+#include "drako/concurrency/lockfree_linear_allocator.hpp"
+#include "drako/concurrency/thread_index.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace drako
+{
+    /// @brief Set of linear arenas recycled in round robin, one for each buffered frame.
+    ///
+    /// Threads reserve large chunks from the arena of the current frame and then
+    /// bump-allocate inside them without synchronization. Memory allocated during
+    /// a frame stays valid until the arena is recycled, that is for as many
+    /// calls to advance() as the number of buffered frames.
+    ///
+    class FrameArena
+    {
+    public:
+        struct Args
+        {
+            /// @brief Number of buffered frames.
+            std::size_t frames;
+
+            /// @brief Bytes reserved for each frame.
+            std::size_t frame_size;
+
+            /// @brief Bytes reserved by a thread each time its local chunk is exhausted.
+            std::size_t chunk_size;
+        };
+
+        struct Stats
+        {
+            /// @brief Bytes reserved during the current frame.
+            std::size_t used;
+
+            /// @brief Max number of bytes reserved during a single frame.
+            std::size_t high_water_mark;
+        };
+
+        explicit FrameArena(const Args& args)
+            : _chunk_size{ args.chunk_size }
+            , _cursors{ std::make_unique<_cursor[]>(thread_index_limit) }
+        {
+            assert(args.frames > 0);
+            assert(args.chunk_size > 0 && args.chunk_size <= args.frame_size);
+
+            _frames.reserve(args.frames);
+            for (std::size_t i = 0; i < args.frames; ++i)
+                _frames.push_back(std::make_unique<concurrency::lockfree_linear_allocator>(args.frame_size));
+        }
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        /// @brief Allocates memory that lives until the arena of the current frame is recycled.
+        ///
+        /// @return Pointer to the allocated memory, or nullptr if the arena of the current frame is exhausted.
+        ///
+        [[nodiscard]] void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) noexcept
+        {
+            const auto frame = _frame.load(std::memory_order::acquire);
+            auto&      arena = *_frames[frame % std::size(_frames)];
+
+            const auto t = this_thread_index();
+            if (t == thread_index_limit || size > _chunk_size / 2) [[unlikely]]
+                return arena.allocate(size, alignment); // no local chunk, or the request would waste most of it
+
+            auto& c = _cursors[t];
+            if (c.frame != frame) // local chunk belongs to a recycled arena
+                c = { nullptr, nullptr, frame };
+
+            for (;;)
+            {
+                const auto address = reinterpret_cast<std::uintptr_t>(c.head);
+                const auto begin   = (address + alignment - 1) & ~(alignment - 1);
+                if (c.head != nullptr && begin + size <= reinterpret_cast<std::uintptr_t>(c.end))
+                {
+                    c.head += (begin - address) + size;
+                    return c.head - size;
+                }
+
+                // local chunk is exhausted, grab another one from the shared arena
+                const auto chunk = static_cast<std::byte*>(arena.allocate(_chunk_size, alignof(std::max_align_t)));
+                if (chunk == nullptr)
+                    return arena.allocate(size, alignment); // the tail of the arena may still fit
+                c.head = chunk;
+                c.end  = chunk + _chunk_size;
+            }
+        }
+
+        /// @brief Begins a new frame, recycling the arena of the oldest buffered frame in O(1).
+        ///
+        /// @warning Must not be called concurrently with allocate().
+        ///
+        void advance() noexcept
+        {
+            const auto frame = _frame.load(std::memory_order::relaxed);
+            auto&      done  = *_frames[frame % std::size(_frames)];
+            _high_water_mark = std::max(_high_water_mark, done.used());
+
+            _frames[(frame + 1) % std::size(_frames)]->release();
+            _frame.store(frame + 1, std::memory_order::release);
+        }
+
+        /// @brief Checks whether a pointer was returned by the arena.
+        [[nodiscard]] bool owns(const void* p) const noexcept
+        {
+            return std::any_of(std::cbegin(_frames), std::cend(_frames),
+                [p](const auto& f) { return f->owns(p); });
+        }
+
+        /// @brief Number of frames begun since the construction of the arena.
+        [[nodiscard]] std::uint64_t frame() const noexcept
+        {
+            return _frame.load(std::memory_order::relaxed);
+        }
+
+        /// @brief Memory usage statistics.
+        [[nodiscard]] Stats stats() const noexcept
+        {
+            const auto used = _frames[frame() % std::size(_frames)]->used();
+            return { used, std::max(_high_water_mark, used) };
+        }
+
+    private:
+        /// @brief Chunk reserved by a single thread.
+        struct alignas(std::hardware_destructive_interference_size) _cursor
+        {
+            std::byte*    head  = nullptr;
+            std::byte*    end   = nullptr;
+            std::uint64_t frame = 0; // frame in which the chunk was reserved
+        };
+
+        const std::size_t _chunk_size;
+
+        std::vector<std::unique_ptr<concurrency::lockfree_linear_allocator>> _frames;
+        std::unique_ptr<_cursor[]>                                           _cursors; // indexed by thread
+
+        std::atomic<std::uint64_t> _frame           = 0;
+        std::size_t                _high_water_mark = 0;
+    };
+
+
+    /// @brief Standard allocator that takes memory from a FrameArena.
+    ///
+    /// Falls back to the global heap when the arena is exhausted;
+    /// deallocation is a no-op for memory that comes from the arena.
+    ///
+    template <typename T>
+    class FrameAllocator
+    {
+    public:
+        using value_type = T;
+
+        FrameAllocator(FrameArena& arena) noexcept
+            : _arena{ &arena } {}
+
+        template <typename U>
+        FrameAllocator(const FrameAllocator<U>& other) noexcept
+            : _arena{ other._arena } {}
+
+        [[nodiscard]] T* allocate(std::size_t n)
+        {
+            if (const auto p = _arena->allocate(n * sizeof(T), alignof(T)); p != nullptr)
+                return static_cast<T*>(p);
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{ alignof(T) }));
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            if (!_arena->owns(p))
+                ::operator delete(p, n * sizeof(T), std::align_val_t{ alignof(T) });
+        }
+
+        template <typename U>
+        [[nodiscard]] bool operator==(const FrameAllocator<U>& other) const noexcept
+        {
+            return _arena == other._arena;
+        }
+
+    private:
+        template <typename U>
+        friend class FrameAllocator;
+
+        FrameArena* _arena;
+    };
+
+} // namespace drako
+
+#endif // !DRAKO_FRAME_ARENA_HPP
@@ -0,0 +1,350 @@
+#pragma once
+#ifndef DRAKO_IO_URING_READER_HPP
+#define DRAKO_IO_URING_READER_HPP
+
+/// @file
+/// @brief  Batched asynchronous file reads on top of Linux io_uring.
+/// @author Grassi Edoardo
+
+#if defined(__linux__)
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <vector>
+
+namespace drako
+{
+    /// @brief Single-threaded io_uring instance specialized for reads.
+    ///
+    /// Reads are queued in the submission ring and handed to the kernel
+    /// with a single syscall, completions are reaped in batches straight
+    /// from the shared completion ring. The raw syscalls are used, so there
+    /// is no dependency on liburing.
+    ///
+    /// @warning All the members must be called from the same thread.
+    ///
+    class IoUringReader
+    {
+    public:
+        /// @brief Max number of bytes transferred by a single read, longer reads are truncated by the kernel.
+        static constexpr const std::size_t max_read_size = 0x7fff'f000;
+
+        struct Read
+        {
+            /// @brief Open file descriptor of the source file.
+            int fd;
+
+            /// @brief Destination memory buffer, at most max_read_size bytes.
+            std::span<std::byte> dst;
+
+            /// @brief Bytes offset from the start of the file.
+            std::uint64_t offset;
+
+            /// @brief Opaque value returned with the completion.
+            const void* user_data;
+        };
+
+        struct Completion
+        {
+            /// @brief Value provided with the read.
+            const void* user_data;
+
+            /// @brief Number of bytes read, or the negated errno value on failure.
+            ///
+            /// Like read(2), the result can be less than the size of the destination
+            /// even before the end of the file.
+            ///
+            std::int32_t result;
+        };
+
+        /// @brief Constructor.
+        ///
+        /// @param[in] entries Max number of reads in flight, rounded up to a power of 2 by the kernel.
+        ///
+        /// @throw std::system_error If io_uring or its read operations aren't supported,
+        ///                           or resources are exhausted.
+        ///
+        explicit IoUringReader(std::uint32_t entries)
+        {
+            assert(entries > 0);
+
+            io_uring_params params{};
+            _ring = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            if (_ring < 0)
+                throw std::system_error(errno, std::system_category());
+
+            try
+            {
+                _map(params);
+                _probe_reads();
+            }
+            catch (...)
+            {
+                _unmap();
+                ::close(_ring);
+                throw;
+            }
+        }
+
+        ~IoUringReader() noexcept
+        {
+            _unmap();
+            ::close(_ring);
+        }
+
+        IoUringReader(const IoUringReader&) = delete;
+        IoUringReader& operator=(const IoUringReader&) = delete;
+
+        /// @brief Max number of reads that can be in flight.
+        [[nodiscard]] std::uint32_t capacity() const noexcept { return _sq.entries; }
+
+        /// @brief Registers the destination buffers, reads that target them avoid the page pinning on every call.
+        ///
+        /// @throw std::system_error On failure.
+        ///
+        void register_buffers(std::span<const std::span<std::byte>> buffers)
+        {
+            std::vector<iovec> iov(std::size(buffers));
+            std::transform(std::begin(buffers), std::end(buffers), std::begin(iov),
+                [](auto b) { return iovec{ .iov_base = std::data(b), .iov_len = std::size(b) }; });
+            _register(IORING_REGISTER_BUFFERS, std::data(iov), static_cast<unsigned>(std::size(iov)));
+            _buffers.assign(std::begin(buffers), std::end(buffers));
+        }
+
+        /// @brief Registers the source files, reads from them skip the lookup of the descriptor.
+        ///
+        /// @throw std::system_error On failure.
+        ///
+        void register_files(std::span<const int> fds)
+        {
+            _register(IORING_REGISTER_FILES, std::data(fds), static_cast<unsigned>(std::size(fds)));
+            _files.assign(std::begin(fds), std::end(fds));
+        }
+
+        /// @brief Queues a batch of reads and submits them with a single syscall.
+        ///
+        /// @return Number of reads queued, always a prefix of the source. Can be less
+        ///         than requested if the submission ring is full.
+        ///
+        [[nodiscard]] std::size_t submit(std::span<const Read> reads) noexcept
+        {
+            const auto head  = std::atomic_ref{ *_sq.head }.load(std::memory_order::acquire);
+            auto       tail  = *_sq.tail;
+            const auto space = _sq.entries - (tail - head);
+            const auto count = std::min<std::size_t>(space, std::size(reads));
+
+            for (std::size_t i = 0; i < count; ++i, ++tail)
+            {
+                const auto index = tail & _sq.mask;
+                _prepare(_sqes[index], reads[i]);
+                _sq.array[index] = index;
+            }
+            std::atomic_ref{ *_sq.tail }.store(tail, std::memory_order::release);
+
+            _unsubmitted += static_cast<std::uint32_t>(count);
+            if (_unsubmitted > 0)
+                _enter(0, 0);
+            return count;
+        }
+
+        /// @brief Reaps a batch of completions.
+        ///
+        /// @param[out] completions  Destination for the completions.
+        /// @param[in]  min_complete Number of completions to wait for, zero to poll.
+        ///
+        /// @return Number of completions reaped, stored in a prefix of the destination.
+        ///
+        [[nodiscard]] std::size_t reap(std::span<Completion> completions, std::uint32_t min_complete = 0) noexcept
+        {
+            if (min_complete > 0 && _ready() < min_complete)
+                _enter(min_complete, IORING_ENTER_GETEVENTS);
+
+            auto       head  = *_cq.head;
+            const auto tail  = std::atomic_ref{ *_cq.tail }.load(std::memory_order::acquire);
+            std::size_t count = 0;
+            for (; head != tail && count < std::size(completions); ++head, ++count)
+            {
+                const auto& cqe    = _cqes[head & _cq.mask];
+                completions[count] = { .user_data = reinterpret_cast<const void*>(cqe.user_data), .result = cqe.res };
+            }
+            // release the slots to the kernel all at once
+            std::atomic_ref{ *_cq.head }.store(head, std::memory_order::release);
+            return count;
+        }
+
+    private:
+        struct _submission_ring
+        {
+            std::uint32_t* head;
+            std::uint32_t* tail;
+            std::uint32_t* array;
+            std::uint32_t  mask;
+            std::uint32_t  entries;
+        };
+
+        struct _completion_ring
+        {
+            std::uint32_t* head;
+            std::uint32_t* tail;
+            std::uint32_t  mask;
+        };
+
+        int              _ring = -1;
+        void*            _sq_map   = MAP_FAILED;
+        std::size_t      _sq_bytes = 0;
+        void*            _cq_map   = MAP_FAILED;
+        std::size_t      _cq_bytes = 0;
+        io_uring_sqe*    _sqes       = static_cast<io_uring_sqe*>(MAP_FAILED);
+        std::size_t      _sqes_bytes = 0;
+        io_uring_cqe*    _cqes       = nullptr;
+        _submission_ring _sq{};
+        _completion_ring _cq{};
+        std::uint32_t    _unsubmitted = 0; // published to the ring but not yet consumed by the kernel
+
+        std::vector<std::span<std::byte>> _buffers; // registered buffers
+        std::vector<int>                  _files;   // registered files
+
+        void _map(const io_uring_params& p)
+        {
+            constexpr auto prot  = PROT_READ | PROT_WRITE;
+            constexpr auto flags = MAP_SHARED | MAP_POPULATE;
+
+            _sq_bytes = p.sq_off.array + p.sq_entries * sizeof(std::uint32_t);
+            _cq_bytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            if (p.features & IORING_FEAT_SINGLE_MMAP) // both rings share a single mapping
+                _sq_bytes = _cq_bytes = std::max(_sq_bytes, _cq_bytes);
+
+            _sq_map = ::mmap(nullptr, _sq_bytes, prot, flags, _ring, IORING_OFF_SQ_RING);
+            if (_sq_map == MAP_FAILED)
+                throw std::system_error(errno, std::system_category());
+
+            if (p.features & IORING_FEAT_SINGLE_MMAP)
+                _cq_map = _sq_map;
+            else if (_cq_map = ::mmap(nullptr, _cq_bytes, prot, flags, _ring, IORING_OFF_CQ_RING); _cq_map == MAP_FAILED)
+                throw std::system_error(errno, std::system_category());
+
+            _sqes_bytes = p.sq_entries * sizeof(io_uring_sqe);
+            if (const auto m = ::mmap(nullptr, _sqes_bytes, prot, flags, _ring, IORING_OFF_SQES); m != MAP_FAILED)
+                _sqes = static_cast<io_uring_sqe*>(m);
+            else
+                throw std::system_error(errno, std::system_category());
+
+            const auto sq = static_cast<std::byte*>(_sq_map);
+            _sq.head      = reinterpret_cast<std::uint32_t*>(sq + p.sq_off.head);
+            _sq.tail      = reinterpret_cast<std::uint32_t*>(sq + p.sq_off.tail);
+            _sq.array     = reinterpret_cast<std::uint32_t*>(sq + p.sq_off.array);
+            _sq.mask      = *reinterpret_cast<std::uint32_t*>(sq + p.sq_off.ring_mask);
+            _sq.entries   = *reinterpret_cast<std::uint32_t*>(sq + p.sq_off.ring_entries);
+
+            const auto cq = static_cast<std::byte*>(_cq_map);
+            _cq.head      = reinterpret_cast<std::uint32_t*>(cq + p.cq_off.head);
+            _cq.tail      = reinterpret_cast<std::uint32_t*>(cq + p.cq_off.tail);
+            _cq.mask      = *reinterpret_cast<std::uint32_t*>(cq + p.cq_off.ring_mask);
+            _cqes         = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        }
+
+        void _unmap() noexcept
+        {
+            if (_sqes != MAP_FAILED)
+                ::munmap(_sqes, _sqes_bytes);
+            if (_cq_map != MAP_FAILED && _cq_map != _sq_map)
+                ::munmap(_cq_map, _cq_bytes);
+            if (_sq_map != MAP_FAILED)
+                ::munmap(_sq_map, _sq_bytes);
+        }
+
+        void _register(unsigned opcode, const void* args, unsigned count)
+        {
+            if (::syscall(__NR_io_uring_register, _ring, opcode, args, count) < 0)
+                throw std::system_error(errno, std::system_category());
+        }
+
+        // kernels before 5.6 set up rings but fail every IORING_OP_READ with EINVAL,
+        // they don't support the probe either
+        void _probe_reads()
+        {
+            constexpr const unsigned ops = IORING_OP_READ + 1;
+
+            alignas(io_uring_probe) std::byte storage[sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op)] = {};
+            const auto probe = ::new (static_cast<void*>(storage)) io_uring_probe{};
+            _register(IORING_REGISTER_PROBE, probe, ops);
+
+            if (probe->last_op < IORING_OP_READ || !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED))
+                throw std::system_error(std::make_error_code(std::errc::operation_not_supported));
+        }
+
+        // hands the queued entries to the kernel, optionally waiting for completions
+        void _enter(std::uint32_t min_complete, std::uint32_t flags) noexcept
+        {
+            for (;;)
+            {
+                const auto r = ::syscall(__NR_io_uring_enter, _ring, _unsubmitted, min_complete, flags, nullptr, 0);
+                if (r >= 0)
+                {
+                    _unsubmitted -= static_cast<std::uint32_t>(r);
+                    return;
+                }
+                if (errno != EINTR) // EAGAIN and EBUSY leave the entries queued for the next call
+                    return;
+            }
+        }
+
+        [[nodiscard]] std::uint32_t _ready() const noexcept
+        {
+            return std::atomic_ref{ *_cq.tail }.load(std::memory_order::acquire) - *_cq.head;
+        }
+
+        void _prepare(io_uring_sqe& sqe, const Read& r) const noexcept
+        {
+            assert(std::size(r.dst) <= max_read_size);
+
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode    = IORING_OP_READ;
+            sqe.fd        = r.fd;
+            sqe.addr      = reinterpret_cast<std::uintptr_t>(std::data(r.dst));
+            sqe.len       = static_cast<std::uint32_t>(std::size(r.dst));
+            sqe.off       = r.offset;
+            sqe.user_data = reinterpret_cast<std::uintptr_t>(r.user_data);
+
+            if (const auto b = _find_buffer(r.dst); b.has_value())
+            {
+                sqe.opcode    = IORING_OP_READ_FIXED;
+                sqe.buf_index = *b;
+            }
+            if (const auto f = std::find(std::begin(_files), std::end(_files), r.fd); f != std::end(_files))
+            {
+                sqe.fd = static_cast<std::int32_t>(f - std::begin(_files));
+                sqe.flags |= IOSQE_FIXED_FILE;
+            }
+        }
+
+        [[nodiscard]] std::optional<std::uint16_t> _find_buffer(std::span<const std::byte> dst) const noexcept
+        {
+            for (std::size_t i = 0; i < std::size(_buffers); ++i)
+                if (std::data(dst) >= std::data(_buffers[i])
+                    && std::data(dst) + std::size(dst) <= std::data(_buffers[i]) + std::size(_buffers[i]))
+                    return static_cast<std::uint16_t>(i);
+            return std::nullopt;
+        }
+    };
+
+} // namespace drako
+
+#endif // defined(__linux__)
+
+#endif // !DRAKO_IO_URING_READER_HPP
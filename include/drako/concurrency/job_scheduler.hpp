@@ -0,0 +1,476 @@
+#pragma once
+#ifndef DRAKO_JOB_SCHEDULER_HPP
+#define DRAKO_JOB_SCHEDULER_HPP
+
+/// @file
+/// @brief  Work-stealing scheduler for short lived jobs.
+/// @author Grassi Edoardo
+
+#include "drako/concurrency/event_count.hpp"
+#include "drako/concurrency/lockfree_dequeue.hpp"
+#include "drako/concurrency/lockfree_mrmw_queue.hpp"
+#include "drako/concurrency/lockfree_pool_allocator.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace drako
+{
+    /// @brief Tracks the completion of a group of jobs.
+    ///
+    /// Fibers can suspend on a counter without blocking the worker thread,
+    /// they are rescheduled as soon as the counter reaches zero.
+    ///
+    /// The counter can be destroyed as soon as it's observed done: the last job
+    /// doesn't access it after the completion has been published.
+    ///
+    class JobCounter
+    {
+    public:
+        explicit JobCounter() noexcept = default;
+
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        /// @brief Number of jobs that haven't completed yet.
+        [[nodiscard]] std::size_t pending() const noexcept
+        {
+            return _state.load(std::memory_order::acquire) >> 1;
+        }
+
+        /// @brief Checks whether all the jobs have completed.
+        [[nodiscard]] bool done() const noexcept { return _state.load(std::memory_order::acquire) == 0; }
+
+    private:
+        friend class JobScheduler;
+
+        // intrusive node of a fiber suspended on the counter
+        struct _waiter
+        {
+            std::coroutine_handle<> fiber;
+            _waiter*                next;
+        };
+
+        // the lowest bit of the state guards the list of waiters, the others hold the pending jobs;
+        // keeping both in the same word lets the last job take the list in the same step
+        // that brings the count to zero, so no fiber can be registered after it
+        static constexpr const std::size_t _locked = 1;
+        static constexpr const std::size_t _one    = 2;
+
+        std::atomic<std::size_t> _state   = 0;
+        _waiter*                 _waiters = nullptr; // guarded by the lock bit
+    };
+
+
+    /// @brief Executes jobs on a pool of worker threads.
+    ///
+    /// Each worker owns a work-stealing queue: jobs submitted from a worker
+    /// are pushed on its own queue, while jobs submitted from external threads
+    /// go through a shared injection queue. Idle workers steal from the peer
+    /// with the most pending jobs.
+    ///
+    class JobScheduler
+    {
+    public:
+        using Job = std::function<void()>;
+
+        /// @brief Job implemented as a coroutine that can suspend on a JobCounter.
+        ///
+        /// A suspended fiber releases the worker thread, which is free to execute other jobs;
+        /// the fiber is scheduled again when the counter it waits on reaches zero.
+        ///
+        class Fiber
+        {
+        public:
+            struct promise_type
+            {
+                JobScheduler* scheduler = nullptr;
+                JobCounter*   counter   = nullptr;
+
+                [[nodiscard]] Fiber get_return_object() noexcept
+                {
+                    return Fiber{ std::coroutine_handle<promise_type>::from_promise(*this) };
+                }
+
+                // the fiber starts only when it's submitted to a scheduler
+                [[nodiscard]] std::suspend_always initial_suspend() const noexcept { return {}; }
+
+                // the frame is released as soon as the fiber completes
+                [[nodiscard]] std::suspend_never final_suspend() const noexcept { return {}; }
+
+                void return_void() const noexcept
+                {
+                    if (counter)
+                        scheduler->_signal(*counter);
+                }
+
+                [[noreturn]] void unhandled_exception() const noexcept { std::terminate(); }
+            };
+
+            Fiber(const Fiber&) = delete;
+            Fiber& operator=(const Fiber&) = delete;
+
+            Fiber(Fiber&& other) noexcept
+                : _handle{ std::exchange(other._handle, nullptr) } {}
+
+            Fiber& operator=(Fiber&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    if (_handle)
+                        _handle.destroy();
+                    _handle = std::exchange(other._handle, nullptr);
+                }
+                return *this;
+            }
+
+            ~Fiber() noexcept
+            {
+                if (_handle) // never submitted
+                    _handle.destroy();
+            }
+
+        private:
+            friend class JobScheduler;
+
+            explicit Fiber(std::coroutine_handle<promise_type> h) noexcept
+                : _handle{ h } {}
+
+            std::coroutine_handle<promise_type> _handle;
+        };
+
+        struct Args
+        {
+            /// @brief Number of worker threads.
+            std::size_t workers;
+
+            /// @brief Capacity of the local queue of each worker.
+            std::size_t queue_size;
+        };
+
+        explicit JobScheduler(const Args& args)
+            : _jobs{ args.workers * args.queue_size }
+            , _injected{ args.workers * args.queue_size }
+        {
+            assert(args.workers > 0);
+            assert(args.queue_size > 0);
+
+            _contexts.reserve(args.workers);
+            for (std::size_t i = 0; i < args.workers; ++i)
+                _contexts.push_back(std::make_unique<thread_context>(*this, i, args.queue_size));
+
+            // start workers only after all the queues are available for stealing
+            for (auto& c : _contexts)
+                c->thread = std::thread{ &JobScheduler::_run, this, std::ref(*c) };
+        }
+
+        /// @brief Stops the workers.
+        ///
+        /// @note Jobs that didn't start execution are discarded.
+        ///
+        ~JobScheduler() noexcept
+        {
+            _done.test_and_set(std::memory_order::release);
+            _idle.notify_all();
+            for (auto& c : _contexts)
+                c->thread.join();
+
+            for (auto& c : _contexts)
+                for (_job* j; c->jobs.deque(j);)
+                    _destroy(j);
+            for (_job* j; _injected.deque(j);)
+                _destroy(j);
+        }
+
+        JobScheduler(const JobScheduler&) = delete;
+        JobScheduler& operator=(const JobScheduler&) = delete;
+
+        /// @brief Schedules a job for execution.
+        ///
+        /// @note Jobs must not throw exceptions.
+        ///
+        void submit(Job job) { _submit(_create(std::move(job), nullptr)); }
+
+        /// @brief Schedules a job for execution and tracks it with a counter.
+        ///
+        /// @note Jobs must not throw exceptions.
+        ///
+        void submit(Job job, JobCounter& counter)
+        {
+            // the counter is left untouched if the allocation throws
+            const auto j = _create(std::move(job), &counter);
+            counter._state.fetch_add(JobCounter::_one, std::memory_order::relaxed);
+            _submit(j);
+        }
+
+        /// @brief Schedules a fiber for execution.
+        void submit(Fiber fiber) { _submit(std::exchange(fiber._handle, nullptr), nullptr); }
+
+        /// @brief Schedules a fiber for execution and tracks its completion with a counter.
+        void submit(Fiber fiber, JobCounter& counter)
+        {
+            counter._state.fetch_add(JobCounter::_one, std::memory_order::relaxed);
+            _submit(std::exchange(fiber._handle, nullptr), &counter);
+        }
+
+        /// @brief Suspends the calling fiber until all the jobs tracked by the counter have completed.
+        ///
+        /// Usage: co_await scheduler.suspend_until(counter);
+        ///
+        [[nodiscard]] auto suspend_until(JobCounter& counter) noexcept
+        {
+            return _counter_awaiter{ counter };
+        }
+
+        /// @brief Blocks until all the jobs tracked by the counter have completed.
+        ///
+        /// The calling thread executes pending jobs while waiting,
+        /// so it's safe to wait from inside a job.
+        ///
+        void wait(const JobCounter& counter)
+        {
+            auto context = _this_thread_context();
+            while (!counter.done())
+                if (!_try_execute(context))
+                    std::this_thread::yield();
+        }
+
+        /// @brief Number of worker threads.
+        [[nodiscard]] std::size_t workers() const noexcept { return std::size(_contexts); }
+
+    private:
+        struct _job
+        {
+            Job         task;
+            JobCounter* counter;
+        };
+
+        class _counter_awaiter
+        {
+        public:
+            explicit _counter_awaiter(JobCounter& c) noexcept
+                : _counter{ c } {}
+
+            [[nodiscard]] bool await_ready() const noexcept { return _counter.done(); }
+
+            [[nodiscard]] bool await_suspend(std::coroutine_handle<> fiber) noexcept
+            {
+                auto& counter = _counter;
+                _node.fiber   = fiber;
+
+                // the node is registered only while jobs are pending, under the lock bit,
+                // so the job that completes last is guaranteed to find it
+                auto state = counter._state.load(std::memory_order::acquire);
+                for (;;)
+                {
+                    if (state == 0) // completed in the meantime, resume immediately
+                        return false;
+
+                    if (state & JobCounter::_locked)
+                    {
+                        cpu_relax();
+                        state = counter._state.load(std::memory_order::acquire);
+                    }
+                    else if (counter._state.compare_exchange_weak(state, state | JobCounter::_locked,
+                                 std::memory_order::acquire, std::memory_order::acquire))
+                        break;
+                }
+
+                _node.next       = counter._waiters;
+                counter._waiters = &_node;
+
+                // the fiber can be resumed by another thread, and the counter destroyed,
+                // as soon as the lock is released: nothing can be accessed afterwards
+                counter._state.fetch_sub(JobCounter::_locked, std::memory_order::release);
+                return true;
+            }
+
+            void await_resume() const noexcept {}
+
+        private:
+            JobCounter&         _counter;
+            JobCounter::_waiter _node;
+        };
+
+        /// @brief Execution state owned by a single worker thread.
+        struct alignas(std::hardware_destructive_interference_size) thread_context
+        {
+            explicit thread_context(JobScheduler& s, std::size_t i, std::size_t queue_size)
+                : scheduler{ s }, index{ i }, jobs{ queue_size } {}
+
+            JobScheduler&            scheduler;
+            const std::size_t        index;
+            lockfree::DEQueue<_job*> jobs;
+            std::thread              thread;
+        };
+
+        std::vector<std::unique_ptr<thread_context>> _contexts;
+
+        lockfree::Pool<_job>         _jobs;     // storage for job descriptors
+        lockfree::MR_MW_Queue<_job*> _injected; // jobs submitted from external threads
+        std::atomic_flag             _done;     // since c++20 is initialized to clear state
+        EventCount                   _idle;     // parks workers that have nothing to execute
+
+        inline static thread_local thread_context* _local_context = nullptr;
+
+        [[nodiscard]] thread_context* _this_thread_context() const noexcept
+        {
+            const auto c = _local_context;
+            return (c != nullptr && &c->scheduler == this) ? c : nullptr;
+        }
+
+        [[nodiscard]] _job* _create(Job&& task, JobCounter* counter)
+        {
+            return std::construct_at(_jobs.allocate(1), std::move(task), counter);
+        }
+
+        void _destroy(_job* j) noexcept
+        {
+            std::destroy_at(j);
+            _jobs.deallocate(j, 1);
+        }
+
+        void _submit(_job* j)
+        {
+            const auto context = _this_thread_context();
+            if (!context || !context->jobs.enque(j))
+            {
+                // queues are full, help draining them until there is space
+                while (!_injected.enque(j))
+                    if (!_try_execute(context))
+                        std::this_thread::yield();
+            }
+            _idle.notify_one();
+        }
+
+        // checks whether any job is available for an idle worker
+        [[nodiscard]] bool _has_work() const noexcept
+        {
+            if (!_injected.empty())
+                return true;
+            for (const auto& c : _contexts)
+                if (!c->jobs.empty())
+                    return true;
+            return false;
+        }
+
+        [[nodiscard]] _job* _pop_injected() noexcept
+        {
+            _job* j = nullptr;
+            return _injected.deque(j) ? j : nullptr;
+        }
+
+        [[nodiscard]] _job* _steal(const thread_context* thief) noexcept
+        {
+            // pick the busiest peer as the first victim
+            std::size_t victim = 0, max_size = 0;
+            for (std::size_t i = 0; i < std::size(_contexts); ++i)
+                if (const auto s = _contexts[i]->jobs.size(); s > max_size)
+                    victim = i, max_size = s;
+
+            if (max_size == 0)
+                return nullptr;
+
+            // then fall back to the other peers in round robin order
+            for (std::size_t k = 0; k < std::size(_contexts); ++k)
+            {
+                const auto& c = _contexts[(victim + k) % std::size(_contexts)];
+                if (c.get() == thief)
+                    continue;
+
+                if (_job* j; c->jobs.steal(j))
+                    return j;
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] bool _try_execute(thread_context* context)
+        {
+            _job* j = nullptr;
+            if (context == nullptr || !context->jobs.deque(j))
+                if (j = _pop_injected(); j == nullptr)
+                    j = _steal(context);
+
+            if (j == nullptr)
+                return false;
+
+            std::invoke(j->task);
+            if (j->counter)
+                _signal(*j->counter);
+            _destroy(j);
+            return true;
+        }
+
+        void _submit(std::coroutine_handle<Fiber::promise_type> fiber, JobCounter* counter)
+        {
+            assert(fiber);
+            fiber.promise().scheduler = this;
+            fiber.promise().counter   = counter;
+            submit([fiber]() { fiber.resume(); });
+        }
+
+        // notifies the completion of a job tracked by the counter
+        void _signal(JobCounter& counter)
+        {
+            auto state = counter._state.load(std::memory_order::relaxed);
+            for (;;)
+            {
+                assert(state >= JobCounter::_one);
+                if (state == JobCounter::_one)
+                {
+                    // last job: take the lock while reaching zero, so the counter isn't observed done
+                    // until the waiters have been collected
+                    if (counter._state.compare_exchange_weak(state, JobCounter::_locked,
+                            std::memory_order::acq_rel, std::memory_order::relaxed))
+                        return _wake(counter);
+                }
+                else if (state < 2 * JobCounter::_one)
+                {
+                    // last job while a fiber is registering, wait for its node
+                    cpu_relax();
+                    state = counter._state.load(std::memory_order::relaxed);
+                }
+                else if (counter._state.compare_exchange_weak(state, state - JobCounter::_one,
+                             std::memory_order::acq_rel, std::memory_order::relaxed))
+                    return;
+            }
+        }
+
+        // reschedules all the fibers suspended on the counter, called with the lock bit held
+        void _wake(JobCounter& counter)
+        {
+            auto w           = counter._waiters;
+            counter._waiters = nullptr;
+
+            // the counter can be destroyed as soon as the lock is released
+            counter._state.fetch_sub(JobCounter::_locked, std::memory_order::release);
+            while (w != nullptr)
+            {
+                // the node lives inside the fiber frame, read it before resuming
+                const auto fiber = w->fiber;
+                w                = w->next;
+                submit([fiber]() { fiber.resume(); });
+            }
+        }
+
+        void _run(thread_context& context)
+        {
+            _local_context = &context;
+            while (!_done.test(std::memory_order::acquire))
+                if (!_try_execute(&context))
+                    _idle.await([this]() { return _has_work() || _done.test(std::memory_order::acquire); });
+            _local_context = nullptr;
+        }
+    };
+
+} // namespace drako
+
+#endif // !DRAKO_JOB_SCHEDULER_HPP
@@ -2,166 +2,504 @@
 #ifndef DRAKO_LOCK_HPP
 #define DRAKO_LOCK_HPP
 
+/// @file
+/// @brief  Lightweight locks for short critical sections.
+/// @author Grassi Edoardo
+
+#include "drako/concurrency/event_count.hpp"
+
+#include <algorithm>
 #include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <thread>
 
-#include "core/compiler_macros.hpp"
-
 namespace drako::concurrency
 {
-    // CLASS
-    // Busy waiting lock based on TTAS locking scheme.
+    /// @brief Counters of contention events, collected only in debug builds.
+    struct lock_stats
+    {
+        std::size_t acquisitions; // total number of acquisitions
+        std::size_t contended;    // acquisitions that found the lock busy
+        std::size_t parked;       // times a thread went to sleep waiting for the lock
+    };
+
+    namespace _detail
+    {
+        // exponential backoff between attempts of a spin-wait loop
+        class _backoff
+        {
+        public:
+            static constexpr const std::uint32_t max_pauses = 64;
+
+            void pause() noexcept
+            {
+                for (std::uint32_t i = 0; i < _pauses; ++i)
+                    cpu_relax();
+                _pauses = std::min(2 * _pauses, max_pauses);
+                ++_rounds;
+            }
+
+            // checks whether the thread has spun long enough to go to sleep
+            [[nodiscard]] bool exhausted(std::uint32_t rounds) const noexcept { return _rounds >= rounds; }
+
+        private:
+            std::uint32_t _pauses = 1;
+            std::uint32_t _rounds = 0;
+        };
+
+#if !defined(NDEBUG)
+        class _lock_counters
+        {
+        public:
+            void acquired(bool contended) noexcept
+            {
+                _acquisitions.fetch_add(1, std::memory_order::relaxed);
+                if (contended)
+                    _contended.fetch_add(1, std::memory_order::relaxed);
+            }
+
+            void parked() noexcept { _parked.fetch_add(1, std::memory_order::relaxed); }
+
+            [[nodiscard]] lock_stats load() const noexcept
+            {
+                return { .acquisitions = _acquisitions.load(std::memory_order::relaxed),
+                    .contended         = _contended.load(std::memory_order::relaxed),
+                    .parked            = _parked.load(std::memory_order::relaxed) };
+            }
+
+        private:
+            std::atomic<std::size_t> _acquisitions = 0;
+            std::atomic<std::size_t> _contended    = 0;
+            std::atomic<std::size_t> _parked       = 0;
+        };
+#endif
+    } // namespace _detail
+
+
+    /// @brief Mutual exclusion lock based on the TTAS scheme.
+    ///
+    /// Waiting threads spin on a cached copy of the state with exponential backoff,
+    /// then park on the lock word if it stays busy for too long.
+    ///
     class spin_lock final
     {
     public:
+        /// @brief Rounds of backoff before a waiting thread is parked.
+        static constexpr const std::uint32_t spin_rounds = 16;
 
-        DRAKO_FORCE_INLINE explicit constexpr spin_lock() noexcept = default;
+        explicit constexpr spin_lock() noexcept = default;
 
         spin_lock(const spin_lock&) = delete;
         spin_lock& operator=(const spin_lock&) = delete;
 
-        // Blocks until current execution context acquires the lock.
-        // Current execution context shouldn't already hold the lock, otherwise behaviour is undefined.
-        //
-        DRAKO_FORCE_INLINE void lock() noexcept
+        /// @brief Blocks until the calling thread acquires the lock.
+        ///
+        /// @warning The calling thread must not already hold the lock.
+        ///
+        void lock() noexcept
         {
-            for (;;)
+            if (_state.exchange(_locked, std::memory_order::acquire) == _unlocked) [[likely]]
             {
-                // spin on cached memory to avoid memory bus contention
-                while (!_lock.load(std::memory_order_acquire));
-
-                // try acquisition
-                if (_lock.exchange(false, std::memory_order_acq_rel))
-                {
-                    return;
-                }
+                _count(false);
+                return;
             }
+            _lock_contended();
         }
 
-        // Tries once to acquire the lock.
-        //
-        DRAKO_NODISCARD DRAKO_FORCE_INLINE bool try_lock() noexcept
+        /// @brief Tries once to acquire the lock.
+        ///
+        /// @return True if the lock was acquired, false otherwise.
+        ///
+        [[nodiscard]] bool try_lock() noexcept
         {
-            // set locked state and return previous
-            return _lock.exchange(false, std::memory_order_acq_rel);
+            // test before the exchange to avoid stealing the cache line from the owner
+            if (_state.load(std::memory_order::relaxed) != _unlocked
+                || _state.exchange(_locked, std::memory_order::acquire) != _unlocked)
+                return false;
+            _count(false);
+            return true;
         }
 
-        // Releases the lock.
-        // Current execution context must hold the lock, otherwise behaviour is undefined.
-        //
-        DRAKO_FORCE_INLINE void unlock() noexcept
+        /// @brief Releases the lock.
+        ///
+        /// @warning The calling thread must hold the lock.
+        ///
+        void unlock() noexcept
         {
-            // set unlocked state and broadcast memory update
-            _lock.store(true, std::memory_order_release);
+            if (_state.exchange(_unlocked, std::memory_order::release) == _parked)
+                _state.notify_one();
         }
 
+#if !defined(NDEBUG)
+        /// @brief Contention counters, available only in debug builds.
+        [[nodiscard]] lock_stats stats() const noexcept { return _stats.load(); }
+#endif
+
     private:
+        static constexpr const std::uint32_t _unlocked = 0;
+        static constexpr const std::uint32_t _locked   = 1;
+        static constexpr const std::uint32_t _parked   = 2; // locked with sleeping waiters
 
-        // true = unlocked, false = locked
-        std::atomic<bool> _lock{ true };
+        std::atomic<std::uint32_t> _state = _unlocked;
+#if !defined(NDEBUG)
+        _detail::_lock_counters _stats;
+#endif
+
+        void _lock_contended() noexcept
+        {
+            // spin on the cached state to avoid memory bus contention
+            for (_detail::_backoff b; !b.exhausted(spin_rounds); b.pause())
+                if (_state.load(std::memory_order::relaxed) == _unlocked
+                    && _state.exchange(_locked, std::memory_order::acquire) == _unlocked)
+                {
+                    _count(true);
+                    return;
+                }
+
+            // the lock is held for long, sleep until the owner releases it
+            while (_state.exchange(_parked, std::memory_order::acquire) != _unlocked)
+            {
+#if !defined(NDEBUG)
+                _stats.parked();
+#endif
+                _state.wait(_parked, std::memory_order::relaxed);
+            }
+            _count(true);
+        }
+
+        void _count([[maybe_unused]] bool contended) noexcept
+        {
+#if !defined(NDEBUG)
+            _stats.acquired(contended);
+#endif
+        }
     };
 
 
-    // CLASS
-    // Busy waiting lock that supports multiple acquisitions from the same thread.
+    /// @brief Lock that supports multiple acquisitions from the same thread.
     class reentrant_spin_lock final
     {
     public:
+        explicit reentrant_spin_lock() noexcept = default;
 
-        explicit constexpr reentrant_spin_lock() noexcept = default;
+        reentrant_spin_lock(const reentrant_spin_lock&) = delete;
+        reentrant_spin_lock& operator=(const reentrant_spin_lock&) = delete;
 
-        // Blocks until current execution context acquires the lock.
-        // 
-        inline void lock() noexcept
+        /// @brief Blocks until the calling thread acquires the lock.
+        void lock() noexcept
         {
-            auto id = std::this_thread::get_id();
-            if (_owner.load(std::memory_order_acquire) == id)
+            const auto id = std::this_thread::get_id();
+            if (_owner.load(std::memory_order::relaxed) == id)
             {
                 ++_counter;
+                return;
             }
-            for (;;)
-            {
-                while (_owner.load() != std::thread::id());
-
-                if (_owner.exchange(id, std::memory_order_acq_rel) == std::thread::id())
-                {
-                    return;
-                }
-            }
+            _lock.lock();
+            _owner.store(id, std::memory_order::relaxed);
+            _counter = 1;
         }
 
-        DRAKO_NODISCARD inline bool try_lock() noexcept
+        /// @brief Tries once to acquire the lock.
+        ///
+        /// @return True if the lock was acquired, false otherwise.
+        ///
+        [[nodiscard]] bool try_lock() noexcept
         {
-            
+            const auto id = std::this_thread::get_id();
+            if (_owner.load(std::memory_order::relaxed) == id)
+            {
+                ++_counter;
+                return true;
+            }
+            if (!_lock.try_lock())
+                return false;
+            _owner.store(id, std::memory_order::relaxed);
+            _counter = 1;
+            return true;
         }
 
-        // Releases the lock.
-        // Current execution context must hold the lock, otherwise behaviour is undefined.
-        //
-        inline void unlock() noexcept
+        /// @brief Releases one acquisition of the lock.
+        ///
+        /// @warning The calling thread must hold the lock.
+        ///
+        void unlock() noexcept
         {
-            --_counter;
-            if (_counter == 0)
+            assert(_owner.load(std::memory_order::relaxed) == std::this_thread::get_id());
+            assert(_counter > 0);
+            if (--_counter == 0)
             {
-                _owner.store(std::thread::id(), std::memory_order_release);
+                _owner.store(std::thread::id{}, std::memory_order::relaxed);
+                _lock.unlock();
             }
         }
 
-    private:
+#if !defined(NDEBUG)
+        /// @brief Contention counters, available only in debug builds.
+        [[nodiscard]] lock_stats stats() const noexcept { return _lock.stats(); }
+#endif
 
-        std::atomic<std::thread::id>    _owner{};
-        uint32_t                        _counter{ 0 };
+    private:
+        spin_lock                    _lock;
+        std::atomic<std::thread::id> _owner{}; // only the owner can observe its own id
+        std::uint32_t                _counter = 0;
     };
 
 
+    /// @brief Reader-writer lock that gives precedence to writers.
+    ///
+    /// Readers share the lock with a single atomic increment, which makes it
+    /// suitable for read-mostly tables. New readers are held back as soon as
+    /// a writer is waiting, so that writers can't starve.
+    ///
     class read_write_lock final
     {
     public:
+        /// @brief Rounds of backoff before a waiting thread is parked.
+        static constexpr const std::uint32_t spin_rounds = 16;
+
+        explicit constexpr read_write_lock() noexcept = default;
+
+        read_write_lock(const read_write_lock&) = delete;
+        read_write_lock& operator=(const read_write_lock&) = delete;
+
+        /// @brief Blocks until the calling thread acquires exclusive ownership.
+        void lock() noexcept
+        {
+            if (try_lock()) [[likely]]
+                return;
+
+            _writers.fetch_add(1, std::memory_order::relaxed);
+            _wait([this](std::uint32_t s) { return (s & ~_parked) != 0; },
+                [this](std::uint32_t s) { return _try_set(s, s | _writer); });
+            _writers.fetch_sub(1, std::memory_order::relaxed);
+        }
+
+        /// @brief Tries once to acquire exclusive ownership.
+        [[nodiscard]] bool try_lock() noexcept
+        {
+            auto s = _state.load(std::memory_order::relaxed);
+            if ((s & ~_parked) != 0 || !_try_set(s, s | _writer))
+                return false;
+            _count(false);
+            return true;
+        }
+
+        /// @brief Releases exclusive ownership.
+        void unlock() noexcept
+        {
+            const auto s = _state.exchange(0, std::memory_order::release);
+            assert(s & _writer);
+            if (s & _parked)
+                _state.notify_all();
+        }
+
+        /// @brief Blocks until the calling thread acquires shared ownership.
+        void lock_shared() noexcept
+        {
+            if (try_lock_shared()) [[likely]]
+                return;
+
+            _wait([this](std::uint32_t s) { return _readers_blocked(s); },
+                [this](std::uint32_t s) { return _try_set(s, s + 1); });
+        }
+
+        /// @brief Tries once to acquire shared ownership.
+        [[nodiscard]] bool try_lock_shared() noexcept
+        {
+            auto s = _state.load(std::memory_order::relaxed);
+            if (_readers_blocked(s) || !_try_set(s, s + 1))
+                return false;
+            _count(false);
+            return true;
+        }
+
+        /// @brief Releases shared ownership.
+        void unlock_shared() noexcept
+        {
+            const auto s = _state.fetch_sub(1, std::memory_order::release);
+            assert((s & _readers_mask) > 0);
+
+            // the last reader wakes up the writers
+            if ((s & _readers_mask) == 1 && (s & _parked))
+            {
+                _state.fetch_and(~_parked, std::memory_order::relaxed);
+                _state.notify_all();
+            }
+        }
+
+#if !defined(NDEBUG)
+        /// @brief Contention counters, available only in debug builds.
+        [[nodiscard]] lock_stats stats() const noexcept { return _stats.load(); }
+#endif
 
     private:
-    };
+        static constexpr const std::uint32_t _parked       = std::uint32_t{ 1 } << 31; // some thread is sleeping
+        static constexpr const std::uint32_t _writer       = std::uint32_t{ 1 } << 30; // held exclusively
+        static constexpr const std::uint32_t _readers_mask = _writer - 1;
 
+        std::atomic<std::uint32_t> _state   = 0;
+        std::atomic<std::uint32_t> _writers = 0; // writers waiting for the lock
+#if !defined(NDEBUG)
+        _detail::_lock_counters _stats;
+#endif
 
-    // CLASS
-    // Busy waiting lock that allows multiple threads.
-    class spin_semaphore final
-    {
-    public:
+        [[nodiscard]] bool _readers_blocked(std::uint32_t s) const noexcept
+        {
+            return (s & _writer) || (s & _readers_mask) == _readers_mask
+                   || _writers.load(std::memory_order::relaxed) > 0;
+        }
 
-        DRAKO_FORCE_INLINE explicit spin_semaphore(uint16_t thread_count) noexcept
-            : _capacity(thread_count)
+        [[nodiscard]] bool _try_set(std::uint32_t& expected, std::uint32_t desired) noexcept
         {
-            // TODO: assert _capacity != 0
+            return _state.compare_exchange_weak(expected, desired,
+                std::memory_order::acquire, std::memory_order::relaxed);
         }
 
-        DRAKO_FORCE_INLINE void lock() noexcept
+        // spins with backoff while the lock is busy, then parks on the state word
+        template <typename Busy, typename Acquire>
+        void _wait(Busy busy, Acquire acquire) noexcept
         {
-            for (;;)
+            _detail::_backoff b;
+            for (auto s = _state.load(std::memory_order::relaxed);; s = _state.load(std::memory_order::relaxed))
             {
-                while (_counter.load(std::memory_order_acquire) > _capacity);
+                if (!busy(s))
+                {
+                    if (acquire(s))
+                        break;
+                    continue;
+                }
 
-                if (_counter.fetch_add(1, std::memory_order_acq_rel) <= _capacity)
+                if (!b.exhausted(spin_rounds))
                 {
+                    b.pause();
+                    continue;
+                }
 
+                // announce the sleeper, so that the thread releasing the lock issues a wake up
+                if ((s & _parked) || _try_set(s, s | _parked))
+                {
+                    // the waiting writers may have left in the meantime
+                    if (s |= _parked; !busy(s))
+                        continue;
+#if !defined(NDEBUG)
+                    _stats.parked();
+#endif
+                    _state.wait(s, std::memory_order::relaxed);
                 }
             }
+            _count(true);
+        }
+
+        void _count([[maybe_unused]] bool contended) noexcept
+        {
+#if !defined(NDEBUG)
+            _stats.acquired(contended);
+#endif
         }
+    };
+
+
+    /// @brief Counting semaphore that parks waiting threads.
+    class semaphore final
+    {
+    public:
+        /// @brief Rounds of backoff before a waiting thread is parked.
+        static constexpr const std::uint32_t spin_rounds = 16;
+
+        /// @brief Constructor.
+        ///
+        /// @param[in] count Number of units initially available.
+        ///
+        explicit semaphore(std::uint32_t count) noexcept
+            : _count{ count } {}
+
+        semaphore(const semaphore&) = delete;
+        semaphore& operator=(const semaphore&) = delete;
 
-        DRAKO_NODISCARD DRAKO_FORCE_INLINE bool try_lock() noexcept
+        /// @brief Blocks until a unit is available, then takes it.
+        void acquire() noexcept
         {
+            if (try_acquire()) [[likely]]
+            {
+                _counted(false);
+                return;
+            }
+
+            for (_detail::_backoff b; !b.exhausted(spin_rounds); b.pause())
+                if (try_acquire())
+                {
+                    _counted(true);
+                    return;
+                }
+
+            while (!try_acquire())
+            {
+                const auto key = _available.prepare_wait();
+                if (try_acquire())
+                {
+                    _available.cancel_wait();
+                    break;
+                }
+#if !defined(NDEBUG)
+                _stats.parked();
+#endif
+                _available.commit_wait(key);
+            }
+            _counted(true);
+        }
 
+        /// @brief Takes a unit if one is available.
+        ///
+        /// @return True if a unit was taken, false otherwise.
+        ///
+        [[nodiscard]] bool try_acquire() noexcept
+        {
+            for (auto c = _count.load(std::memory_order::relaxed); c > 0;)
+                if (_count.compare_exchange_weak(c, c - 1, std::memory_order::acquire, std::memory_order::relaxed))
+                    return true;
+            return false;
         }
 
-        DRAKO_FORCE_INLINE void unlock() noexcept
+        /// @brief Returns units to the semaphore, waking up the waiting threads.
+        void release(std::uint32_t count = 1) noexcept
         {
+            assert(count > 0);
+            _count.fetch_add(count, std::memory_order::release);
+            if (count == 1)
+                _available.notify_one();
+            else
+                _available.notify_all();
+        }
 
+        /// @brief Number of units currently available.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] std::uint32_t available() const noexcept
+        {
+            return _count.load(std::memory_order::relaxed);
         }
 
+#if !defined(NDEBUG)
+        /// @brief Contention counters, available only in debug builds.
+        [[nodiscard]] lock_stats stats() const noexcept { return _stats.load(); }
+#endif
 
     private:
+        std::atomic<std::uint32_t> _count;
+        EventCount                 _available;
+#if !defined(NDEBUG)
+        _detail::_lock_counters _stats;
+#endif
 
-        const uint16_t          _capacity;
-        std::atomic<uint16_t>   _counter{ 0 };
+        void _counted([[maybe_unused]] bool contended) noexcept
+        {
+#if !defined(NDEBUG)
+            _stats.acquired(contended);
+#endif
+        }
     };
 
 } // namespace drako::concurrency
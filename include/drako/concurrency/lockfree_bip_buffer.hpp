@@ -0,0 +1,314 @@
+#pragma once
+#ifndef DRAKO_LOCKFREE_BIP_BUFFER_HPP
+#define DRAKO_LOCKFREE_BIP_BUFFER_HPP
+
+/// @file
+/// @brief   Single producer, single consumer rings of variable-length messages.
+/// @author  Grassi Edoardo
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace drako::lockfree
+{
+    /// @brief Single producer, single consumer byte ring that hands out contiguous blocks.
+    ///
+    /// Also known as bip buffer: when a reservation doesn't fit in the tail of the
+    /// buffer, the writer wraps around to the start and records a watermark,
+    /// so that the reader knows where the valid data of the previous lap ends.
+    /// Both sides always work on contiguous spans, so messages are written
+    /// and read in place without any copy.
+    ///
+    class BipBuffer final
+    {
+    public:
+        /// @brief Constructs a buffer with specified capacity.
+        ///
+        /// @param[in] size Capacity as bytes.
+        ///
+        explicit BipBuffer(std::size_t size)
+            : _size{ size }
+            , _data{ std::make_unique_for_overwrite<std::byte[]>(size) }
+        {
+            assert(size > 0);
+        }
+
+        BipBuffer(const BipBuffer&) = delete;
+        BipBuffer& operator=(const BipBuffer&) = delete;
+
+
+        /// @brief Reserves a contiguous block for writing.
+        ///
+        /// The block becomes visible to the reader only after commit().
+        ///
+        /// @param[in] bytes Size of the block.
+        ///
+        /// @return The reserved block, empty if there isn't enough contiguous space.
+        ///
+        /// @note Thread-safe and wait-free for concurrent execution with a single reader thread.
+        ///
+        [[nodiscard]] std::span<std::byte> reserve(std::size_t bytes) noexcept
+        {
+            assert(bytes > 0);
+            assert(_writer.reserved == 0); // previous reservation not yet committed
+
+            const auto tail  = _writer.tail.load(std::memory_order::relaxed);
+            auto       start = _fit(tail, _writer.cached_head, bytes);
+            if (!start) // not enough space, synchronize cache
+            {
+                _writer.cached_head = _reader.head.load(std::memory_order::acquire);
+                if (start = _fit(tail, _writer.cached_head, bytes); !start) // still no space
+                    return {};
+            }
+
+            _writer.start    = *start;
+            _writer.reserved = bytes;
+            return { _data.get() + *start, bytes };
+        }
+
+        /// @brief Publishes a prefix of the reserved block to the reader.
+        ///
+        /// @param[in] bytes Number of bytes actually written, the rest of the reservation is discarded.
+        ///
+        void commit(std::size_t bytes) noexcept
+        {
+            assert(bytes <= _writer.reserved);
+            _writer.reserved = 0;
+            if (bytes == 0)
+                return;
+
+            const auto tail = _writer.tail.load(std::memory_order::relaxed);
+            if (_writer.start != tail) // wrapped around, the reader must skip the rest of the lap
+                _writer.watermark.store(tail, std::memory_order::relaxed);
+
+            // commit transaction
+            _writer.tail.store(_writer.start + bytes, std::memory_order::release);
+        }
+
+
+        /// @brief Acquires the contiguous block of data available to the reader.
+        ///
+        /// Data that wrapped around the end of the buffer is returned by the next call,
+        /// after the current block has been released.
+        ///
+        /// @return Block of committed data, empty if there is none.
+        ///
+        /// @note Thread-safe and wait-free for concurrent execution with a single writer thread.
+        ///
+        [[nodiscard]] std::span<const std::byte> read() noexcept
+        {
+            const auto head = _reader.head.load(std::memory_order::relaxed);
+            if (head == _reader.cached_tail) // there is no data, synchronize cache
+                _reader.cached_tail = _writer.tail.load(std::memory_order::acquire);
+
+            const auto tail = _reader.cached_tail;
+            if (tail >= head) // same lap of the writer
+                _reader.start = head;
+            else if (const auto end = _writer.watermark.load(std::memory_order::relaxed); head < end)
+                return _acquire(head, end);
+            else // end of the previous lap
+                _reader.start = 0;
+            return _acquire(_reader.start, tail);
+        }
+
+        /// @brief Releases a prefix of the block returned by read() to the writer.
+        ///
+        /// @param[in] bytes Number of bytes consumed.
+        ///
+        void release(std::size_t bytes) noexcept
+        {
+            assert(bytes <= _reader.available);
+            _reader.available = 0;
+
+            // commit transaction
+            _reader.head.store(_reader.start + bytes, std::memory_order::release);
+        }
+
+
+        /// @brief Capacity of the buffer as bytes.
+        [[nodiscard]] constexpr std::size_t capacity() const noexcept { return _size; }
+
+    private:
+        struct _reader_cached_state
+        {
+            std::atomic<std::size_t> head        = 0; // offset of the next byte to read
+            std::size_t              cached_tail = 0; // last observed value of the writer offset
+            std::size_t              start       = 0; // offset of the acquired block
+            std::size_t              available   = 0; // size of the acquired block
+        };
+
+        struct _writer_cached_state
+        {
+            std::atomic<std::size_t> tail        = 0; // offset of the next byte to write
+            std::atomic<std::size_t> watermark   = 0; // end of the valid data before the last wrap around
+            std::size_t              cached_head = 0; // last observed value of the reader offset
+            std::size_t              start       = 0; // offset of the reserved block
+            std::size_t              reserved    = 0; // size of the reserved block
+        };
+
+        const std::size_t            _size;
+        std::unique_ptr<std::byte[]> _data;
+
+        /*vvv avoid false cache sharing between reader and writer vvv*/
+
+        alignas(std::hardware_destructive_interference_size)
+            _reader_cached_state _reader;
+
+        alignas(std::hardware_destructive_interference_size)
+            _writer_cached_state _writer;
+
+
+        // offset of a free block of the requested size, if any
+        [[nodiscard]] std::optional<std::size_t> _fit(
+            std::size_t tail, std::size_t head, std::size_t bytes) const noexcept
+        {
+            // the tail must never reach the head from behind, or the buffer would look empty
+            if (tail >= head)
+            {
+                if (_size - tail >= bytes)
+                    return tail;
+                if (head > bytes) // wrap around
+                    return 0;
+                return std::nullopt;
+            }
+            return (head - tail > bytes) ? std::optional{ tail } : std::nullopt;
+        }
+
+        [[nodiscard]] std::span<const std::byte> _acquire(std::size_t start, std::size_t end) noexcept
+        {
+            _reader.start     = start;
+            _reader.available = end - start;
+            return { _data.get() + start, end - start };
+        }
+    };
+
+
+    /// @brief Single producer, single consumer stream of typed commands with variable-length payloads.
+    ///
+    /// Each record is made of a header and a payload, written in place inside a BipBuffer.
+    /// Records are aligned to std::max_align_t, so payloads can hold any trivially copyable type.
+    ///
+    class CommandRing final
+    {
+    public:
+        /// @brief Alignment of the payloads.
+        static constexpr const std::size_t alignment = alignof(std::max_align_t);
+
+        struct Header
+        {
+            /// @brief User defined type of the command.
+            std::uint32_t type;
+
+            /// @brief Size of the payload as bytes.
+            std::uint32_t bytes;
+        };
+
+        /// @brief Constructs a ring with specified capacity.
+        ///
+        /// @param[in] bytes Capacity as bytes, including the headers.
+        ///
+        explicit CommandRing(std::size_t bytes)
+            : _ring{ _align(bytes) } {}
+
+        /// @brief Reserves the payload of a command, to be filled in place.
+        ///
+        /// @param[in] type  Type of the command.
+        /// @param[in] bytes Size of the payload.
+        ///
+        /// @return Destination for the payload, empty if the ring is full.
+        ///
+        [[nodiscard]] std::span<std::byte> reserve(std::uint32_t type, std::size_t bytes) noexcept
+        {
+            const auto record = _ring.reserve(_record_size(bytes));
+            if (std::empty(record))
+                return {};
+
+            const Header header{ .type = type, .bytes = static_cast<std::uint32_t>(bytes) };
+            std::memcpy(std::data(record), &header, sizeof(header));
+            _reserved = std::size(record);
+            return record.subspan(_header_size, bytes);
+        }
+
+        /// @brief Publishes the command reserved by the last call to reserve().
+        void commit() noexcept { _ring.commit(std::exchange(_reserved, 0)); }
+
+        /// @brief Copies a command with a fixed-size payload.
+        ///
+        /// @return True if the command was published, false if the ring is full.
+        ///
+        template <typename Command> // clang-format off
+        requires std::is_trivially_copyable_v<Command>
+        bool push(std::uint32_t type, const Command& command) noexcept // clang-format on
+        {
+            const auto payload = reserve(type, sizeof(Command));
+            if (std::empty(payload))
+                return false;
+
+            std::memcpy(std::data(payload), &command, sizeof(Command));
+            commit();
+            return true;
+        }
+
+        /// @brief Visits in place all the commands published so far, in order.
+        ///
+        /// @param[in] visitor Callable invoked with the type and the payload of each command.
+        ///
+        /// @return The number of commands visited.
+        ///
+        template <typename Visitor> // clang-format off
+        requires std::is_invocable_v<Visitor&, std::uint32_t, std::span<const std::byte>>
+        std::size_t consume(Visitor visitor) // clang-format on
+        {
+            std::size_t count = 0;
+            // at most two blocks, before and after the wrap around
+            for (auto pass = 0; pass < 2; ++pass)
+            {
+                const auto block = _ring.read();
+                if (std::empty(block))
+                    break;
+
+                std::size_t offset = 0;
+                for (; offset < std::size(block); ++count)
+                {
+                    Header header;
+                    std::memcpy(&header, std::data(block) + offset, sizeof(header));
+                    visitor(header.type, block.subspan(offset + _header_size, header.bytes));
+                    offset += _record_size(header.bytes);
+                }
+                _ring.release(offset);
+            }
+            return count;
+        }
+
+        /// @brief Capacity of the ring as bytes.
+        [[nodiscard]] constexpr std::size_t capacity() const noexcept { return _ring.capacity(); }
+
+    private:
+        static constexpr const std::size_t _header_size = (sizeof(Header) + alignment - 1) & ~(alignment - 1);
+
+        BipBuffer   _ring;
+        std::size_t _reserved = 0;
+
+        [[nodiscard]] static constexpr std::size_t _align(std::size_t bytes) noexcept
+        {
+            return (bytes + alignment - 1) & ~(alignment - 1);
+        }
+
+        [[nodiscard]] static constexpr std::size_t _record_size(std::size_t payload) noexcept
+        {
+            return _header_size + _align(payload);
+        }
+    };
+
+} // namespace drako::lockfree
+
+#endif // !DRAKO_LOCKFREE_BIP_BUFFER_HPP
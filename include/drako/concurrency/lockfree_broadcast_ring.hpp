@@ -0,0 +1,258 @@
+#pragma once
+#ifndef DRAKO_LOCKFREE_BROADCAST_RING_HPP
+#define DRAKO_LOCKFREE_BROADCAST_RING_HPP
+
+/// @file
+/// @brief   Single writer, multiple readers broadcast ring buffer.
+/// @author  Grassi Edoardo
+
+#include "drako/concurrency/event_count.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace drako::lockfree
+{
+    /// @brief Ring buffer where every element is delivered to every reader.
+    ///
+    /// Follows the design of the LMAX Disruptor: the writer publishes elements in a
+    /// shared array and each reader walks it with its own cursor, at its own pace.
+    /// A slot is reused only after the slowest reader has moved past it, so the
+    /// writer is gated by the minimum of the cursors. Elements are stored once and
+    /// read in place, instead of being copied in a separate queue for each reader.
+    ///
+    /// Positions are monotonic 64 bits sequences, mapped to slots with a mask,
+    /// so there is no ambiguity between the full and the empty ring.
+    ///
+    /// @tparam T Type of the stored objects.
+    ///
+    /// @warning The set of readers is fixed at construction, a reader that stops
+    ///          consuming eventually blocks the writer.
+    ///
+    template <typename T> // clang-format off
+    requires std::is_default_constructible_v<T> && std::is_copy_assignable_v<T>
+    class BroadcastRing final // clang-format on
+    {
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+            "Required for lock-free property");
+
+    public:
+        using value_type = T;
+        using size_type  = std::size_t;
+
+        /// @brief Constructor.
+        ///
+        /// @param[in] size    Min capacity, rounded up to a power of 2.
+        /// @param[in] readers Number of readers, identified by the indices in [0, readers).
+        ///
+        explicit BroadcastRing(std::size_t size, std::size_t readers)
+            : _mask{ std::bit_ceil(size) - 1 }
+            , _data{ std::make_unique<T[]>(_mask + 1) }
+            , _readers{ std::make_unique<_reader_state[]>(readers) }
+            , _readers_count{ readers }
+        {
+            assert(size > 0);
+            assert(readers > 0);
+        }
+
+        BroadcastRing(const BroadcastRing&) = delete;
+        BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+
+        /// @brief Publishes an element to all the readers.
+        ///
+        /// @param[in] value Source value.
+        ///
+        /// @return True if the value was published, false if the slowest reader is a full lap behind.
+        ///
+        /// @note Thread-safe and wait-free for concurrent execution with the readers.
+        ///
+        bool publish(const T& value) noexcept(std::is_nothrow_copy_assignable_v<T>)
+        {
+            return publish_bulk(std::span{ &value, 1 }) == 1;
+        }
+
+        /// @brief Publishes a batch of elements to all the readers.
+        ///
+        /// All the elements are made visible to the readers at once.
+        ///
+        /// @param[in] values Source values.
+        ///
+        /// @return The number of values published, always a prefix of the source values.
+        ///
+        /// @note Thread-safe and wait-free for concurrent execution with the readers.
+        ///
+        [[nodiscard]] std::size_t publish_bulk(std::span<const T> values) noexcept(std::is_nothrow_copy_assignable_v<T>)
+        {
+            const auto tail  = _writer.tail.load(std::memory_order::relaxed);
+            auto       space = capacity() - (tail - _writer.cached_gate);
+            if (space < std::size(values)) // not enough space, synchronize the gate
+            {
+                _writer.cached_gate = _gate();
+                space               = capacity() - (tail - _writer.cached_gate);
+            }
+
+            const auto count = std::min<std::size_t>(space, std::size(values));
+            for (std::size_t i = 0; i < count; ++i)
+                _data[(tail + i) & _mask] = values[i];
+
+            // commit transaction
+            if (count > 0)
+            {
+                _writer.tail.store(tail + count, std::memory_order::release);
+                _not_empty.notify_all();
+            }
+            return count;
+        }
+
+
+        /// @brief Copies the next element for a reader.
+        ///
+        /// @param[in]  reader Index of the reader.
+        /// @param[out] value  Destination for the element.
+        ///
+        /// @return True if an element has been read, false otherwise.
+        ///
+        /// @note Thread-safe and wait-free for concurrent execution with the writer
+        ///       and the other readers, as long as each reader index is used by a single thread.
+        ///
+        [[nodiscard]] bool read(std::size_t reader, T& value) noexcept(std::is_nothrow_copy_assignable_v<T>)
+        {
+            return read_bulk(reader, std::span{ &value, 1 }) == 1;
+        }
+
+        /// @brief Copies a batch of elements for a reader.
+        ///
+        /// @param[in]  reader Index of the reader.
+        /// @param[out] values Destination for the elements.
+        ///
+        /// @return The number of elements read, always stored in a prefix of the destination.
+        ///
+        [[nodiscard]] std::size_t read_bulk(std::size_t reader, std::span<T> values) noexcept(std::is_nothrow_copy_assignable_v<T>)
+        {
+            auto out = std::begin(values);
+            return consume(reader, [&](const T& v) { *out++ = v; }, std::size(values));
+        }
+
+        /// @brief Visits in place the elements not yet seen by a reader.
+        ///
+        /// The slots are released to the writer only after all the visits,
+        /// so the elements must not be referenced after the call.
+        ///
+        /// @param[in] reader  Index of the reader.
+        /// @param[in] visitor Callable invoked with each element, in publication order.
+        /// @param[in] max     Max number of elements to visit.
+        ///
+        /// @return The number of elements visited.
+        ///
+        template <typename Visitor> // clang-format off
+        requires std::is_invocable_v<Visitor&, const T&>
+        std::size_t consume(std::size_t reader, Visitor visitor, // clang-format on
+            std::size_t max = std::numeric_limits<std::size_t>::max())
+        {
+            assert(reader < _readers_count);
+            auto&      r     = _readers[reader];
+            const auto head  = r.cursor.load(std::memory_order::relaxed);
+            auto       items = r.cached_tail - head;
+            if (items < max) // not enough items, synchronize cache
+            {
+                r.cached_tail = _writer.tail.load(std::memory_order::acquire);
+                items         = r.cached_tail - head;
+            }
+
+            const auto count = std::min<std::uint64_t>(items, max);
+            for (std::uint64_t i = 0; i < count; ++i)
+                visitor(std::as_const(_data[(head + i) & _mask]));
+
+            // commit transaction
+            if (count > 0)
+                r.cursor.store(head + count, std::memory_order::release);
+            return static_cast<std::size_t>(count);
+        }
+
+        /// @brief Visits the elements not yet seen by a reader, waiting while there are none.
+        ///
+        /// @param[in] reader  Index of the reader.
+        /// @param[in] visitor Callable invoked with each element, in publication order.
+        /// @param[in] stop    Condition that interrupts the wait, see wake_readers().
+        ///
+        /// @return The number of elements visited, zero if the wait was interrupted.
+        ///
+        template <typename Visitor, typename Stop>
+        [[nodiscard]] std::size_t consume_wait(std::size_t reader, Visitor visitor, Stop stop)
+        {
+            std::size_t count = 0;
+            _not_empty.await([&]() { return (count = consume(reader, visitor)) > 0 || stop(); });
+            return count;
+        }
+
+        /// @brief Wakes up all the readers so that they can evaluate again their stop condition.
+        void wake_readers() noexcept { _not_empty.notify_all(); }
+
+
+        /// @brief Number of elements not yet seen by a reader.
+        ///
+        /// @warning Not thread-safe.
+        ///
+        [[nodiscard]] std::size_t size(std::size_t reader) const noexcept
+        {
+            assert(reader < _readers_count);
+            return static_cast<std::size_t>(_writer.tail.load() - _readers[reader].cursor.load());
+        }
+
+        /// @brief Capacity of the ring.
+        [[nodiscard]] constexpr std::size_t capacity() const noexcept { return _mask + 1; }
+
+        /// @brief Number of readers.
+        [[nodiscard]] constexpr std::size_t readers() const noexcept { return _readers_count; }
+
+    private:
+        struct alignas(std::hardware_destructive_interference_size) _reader_state
+        {
+            std::atomic<std::uint64_t> cursor      = 0; // sequence of the next item to read
+            std::uint64_t              cached_tail = 0; // last observed sequence of the writer
+        };
+
+        struct _writer_state
+        {
+            std::atomic<std::uint64_t> tail        = 0; // sequence of the next slot to write
+            std::uint64_t              cached_gate = 0; // last observed cursor of the slowest reader
+        };
+
+        const std::size_t                _mask;
+        std::unique_ptr<T[]>             _data;
+        std::unique_ptr<_reader_state[]> _readers; // each on its own cache line
+        const std::size_t                _readers_count;
+
+        /*vvv avoid false cache sharing between readers and writer vvv*/
+
+        alignas(std::hardware_destructive_interference_size)
+            _writer_state _writer;
+
+        alignas(std::hardware_destructive_interference_size)
+            EventCount _not_empty; // parks the readers while there are no new elements
+
+
+        // cursor of the slowest reader
+        [[nodiscard]] std::uint64_t _gate() const noexcept
+        {
+            auto gate = std::numeric_limits<std::uint64_t>::max();
+            for (std::size_t i = 0; i < _readers_count; ++i)
+                gate = std::min(gate, _readers[i].cursor.load(std::memory_order::acquire));
+            return gate;
+        }
+    };
+
+} // namespace drako::lockfree
+
+#endif // !DRAKO_LOCKFREE_BROADCAST_RING_HPP
@@ -2,19 +2,64 @@
 #ifndef DRAKO_LOCKFREE_DEQUEUE_HPP
 #define DRAKO_LOCKFREE_DEQUEUE_HPP
 
+/// @file
+/// @brief  Work-stealing double ended queue based on the Chase-Lev algorithm.
+/// @author Grassi Edoardo
+
 #include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <type_traits>
 
 namespace drako::lockfree
 {
+    /// @brief Work-stealing queue with bounded capacity.
+    ///
+    /// The owner thread inserts and removes elements at the bottom end with LIFO policy,
+    /// while any other thread can steal elements from the top end with FIFO policy.
+    ///
+    /// @tparam T  Type of the objects stored, usually a pointer to a job descriptor.
+    /// @tparam Al Allocator type.
+    ///
     template <typename T, typename Al = std::allocator<T>> // clang-format off
-    requires std::atomic<std::size_t>::is_always_lock_free
+    requires std::atomic<std::size_t>::is_always_lock_free && std::is_trivially_copyable_v<T>
     class DEQueue // clang-format on
     {
         static_assert(ATOMIC_LONG_LOCK_FREE == 2, "Not lockfree.");
 
+        using _slot       = std::atomic<T>;
+        using _slot_alloc = typename std::allocator_traits<Al>::template rebind_alloc<_slot>;
+        using _al_traits  = std::allocator_traits<_slot_alloc>;
+
     public:
-        explicit DEQueue(std::size_t capacity);
+        using value_type = T;
+        using size_type  = std::size_t;
+
+        /// @brief Constructs a queue with specified capacity.
+        ///
+        /// @param[in] capacity Minimum capacity, rounded up to the next power of 2.
+        /// @param[in] alloc    Dedicated allocator.
+        ///
+        explicit DEQueue(std::size_t capacity, const Al& alloc = Al())
+            : _alloc{ alloc }
+            , _size{ std::bit_ceil(capacity) }
+            , _data{ _al_traits::allocate(_alloc, _size) }
+        {
+            assert(capacity > 0);
+            for (std::size_t i = 0; i < _size; ++i)
+                _al_traits::construct(_alloc, _data + i);
+        }
+
+        ~DEQueue() noexcept
+        {
+            assert(_data != nullptr);
+            for (std::size_t i = 0; i < _size; ++i)
+                _al_traits::destroy(_alloc, _data + i);
+            _al_traits::deallocate(_alloc, _data, _size);
+        }
 
         DEQueue(const DEQueue&) = delete;
         DEQueue& operator=(const DEQueue&) = delete;
@@ -23,48 +68,118 @@ namespace drako::lockfree
         DEQueue& operator=(DEQueue&&) = delete;
 
 
-        bool enque(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>)
+        /// @brief Inserts an element at the bottom of the queue.
+        ///
+        /// @return True if the value was inserted, false if the queue is full.
+        ///
+        /// @warning Must be called only by the owner thread.
+        ///
+        bool enque(const T& value) noexcept
         {
-            const auto old_head = _head.load();
-            const auto old_tail = _tail.load();
-            const auto size     = old_head - old_tail;
-            if (size >= _size) // no space left in the buffer
+            const auto bottom = _bottom.load(std::memory_order::relaxed);
+            const auto top    = _top.load(std::memory_order::acquire);
+            if (bottom - top >= static_cast<std::ptrdiff_t>(_size)) // no space left in the buffer
                 [[unlikely]] return false;
 
-            _data[old_head] = value;
-            _head.store(old_head + 1);
+            _data[_index(bottom)].store(value, std::memory_order::relaxed);
+            std::atomic_thread_fence(std::memory_order::release);
+            _bottom.store(bottom + 1, std::memory_order::relaxed);
+            return true;
         }
 
-        bool deque(T& value) noexcept
+        /// @brief Removes the most recently inserted element from the bottom of the queue.
+        ///
+        /// @return True if an item has been removed, false otherwise.
+        ///
+        /// @warning Must be called only by the owner thread.
+        ///
+        [[nodiscard]] bool deque(T& value) noexcept
         {
-            const auto bottom = _head.load();
-            const auto old_top = _tail.load();
+            const auto bottom = _bottom.load(std::memory_order::relaxed) - 1;
+            _bottom.store(bottom, std::memory_order::relaxed);
+            std::atomic_thread_fence(std::memory_order::seq_cst);
+            auto top = _top.load(std::memory_order::relaxed);
 
+            if (top > bottom) // queue was empty, restore previous state
+            {
+                _bottom.store(bottom + 1, std::memory_order::relaxed);
+                return false;
+            }
+
+            value = _data[_index(bottom)].load(std::memory_order::relaxed);
+            if (top == bottom) // last element, race against thieves
+            {
+                const auto won = _top.compare_exchange_strong(top, top + 1,
+                    std::memory_order::seq_cst, std::memory_order::relaxed);
+                _bottom.store(bottom + 1, std::memory_order::relaxed);
+                return won;
+            }
+            return true;
         }
 
-        bool steal(T& value) noexcept
+        /// @brief Removes the least recently inserted element from the top of the queue.
+        ///
+        /// @return True if an item has been stolen, false if the queue
+        ///         is empty or another thread won the race for the element.
+        ///
+        /// @note Thread-safe and lock-free.
+        ///
+        [[nodiscard]] bool steal(T& value) noexcept
         {
-            const auto old_tail = _tail.load();
-            const auto old_head = _head.load();
-            const auto size     = old_head - old_tail;
-            if (size <= 0) // no item to steal
+            auto top = _top.load(std::memory_order::acquire);
+            std::atomic_thread_fence(std::memory_order::seq_cst);
+            const auto bottom = _bottom.load(std::memory_order::acquire);
+            if (top >= bottom) // no item to steal
                 return false;
-            const auto v = _data[old_tail];
-            if (_tail.compare_exchange_strong(old_tail, old_tail + 1))
-            {
-                value = v;
-                return true;
-            }
-            return false;
+
+            const auto v = _data[_index(top)].load(std::memory_order::relaxed);
+            if (!_top.compare_exchange_strong(top, top + 1,
+                    std::memory_order::seq_cst, std::memory_order::relaxed))
+                return false;
+
+            value = v;
+            return true;
         }
 
+        /// @brief Approximate number of elements in the queue.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            const auto bottom = _bottom.load(std::memory_order::relaxed);
+            const auto top    = _top.load(std::memory_order::relaxed);
+            return (bottom > top) ? static_cast<std::size_t>(bottom - top) : 0;
+        }
+
+        /// @brief Checks whether the queue is empty.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+        /// @brief Capacity of the queue.
+        [[nodiscard]] constexpr std::size_t capacity() const noexcept { return _size; }
+
     private:
-        const std::size_t        _size;
-        std::atomic<std::size_t> _head;
-        std::atomic<std::size_t> _tail;
-        T                        _data[100];
+        _slot_alloc       _alloc;
+        const std::size_t _size;
+        _slot*            _data;
+
+        /*vvv avoid false cache sharing between owner and thieves vvv*/
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<std::ptrdiff_t> _top = 0; // next slot to steal
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<std::ptrdiff_t> _bottom = 0; // next slot to fill
+
+        [[nodiscard]] constexpr std::size_t _index(std::ptrdiff_t i) const noexcept
+        {
+            return static_cast<std::size_t>(i) & (_size - 1);
+        }
     };
 
 } // namespace drako::lockfree
 
-#endif // !DRAKO_LOCKFREE_DEQUEUE_HPP
\ No newline at end of file
+#endif // !DRAKO_LOCKFREE_DEQUEUE_HPP
@@ -2,43 +2,46 @@
 #ifndef DRAKO_LOCKFREE_LINEAR_ALLOCATOR_HPP
 #define DRAKO_LOCKFREE_LINEAR_ALLOCATOR_HPP
 
-//
-//  \brief      Thread safe linear allocator implemented without locks.
-//  \author     Grassi Edoardo
-//
+/// @file
+/// @brief  Thread safe linear allocator implemented without locks.
+/// @author Grassi Edoardo
 
 #include <atomic>
-
-#include "drako/core/dk_memory_utility.hpp"
-#include "drako/core/compiler_macros.hpp"
-
-#if DRKAPI_DEBUG
-#   include "drako/development/dk_assertion.hpp"
-#endif
-
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
 
 namespace drako::concurrency
 {
-    // \brief   Thread safe linear allocator.
-    //
-    template <typename TAlloc = std::allocator<void>>
+    /// @brief Thread safe linear allocator.
+    ///
+    /// Memory is handed out by bumping an atomic offset inside a single buffer
+    /// and it's reclaimed all at once by release().
+    ///
     class lockfree_linear_allocator
     {
-        static_assert(std::atomic<void*>::is_always_lock_free, "Required to guarantee lock-free property");
+        static_assert(std::atomic<std::size_t>::is_always_lock_free, "Required to guarantee lock-free property");
 
     public:
+        /// @brief Alignment of the underlying buffer.
+        static constexpr const std::size_t buffer_alignment = std::hardware_destructive_interference_size;
+
+        /// @brief     Constructor.
+        /// @param[in] size Number of bytes of memory reserved for the allocator.
+        ///
+        explicit lockfree_linear_allocator(std::size_t size)
+            : _size{ size }
+            , _buffer{ static_cast<std::byte*>(::operator new(size, std::align_val_t{ buffer_alignment })) }
+        {
+            assert(size > 0);
+        }
 
-        // \brief       Constructor.
-        // \param[in]   size    Number of bytes of memory reserved for the allocator.
-        //
-        explicit lockfree_linear_allocator(
-            const size_t size,
-            TAlloc const& allocator = std::allocator<void>()) noexcept;
-
-        // \brief   Destructor.
-        //
-        ~lockfree_linear_allocator() noexcept;
-
+        ~lockfree_linear_allocator() noexcept
+        {
+            ::operator delete(_buffer, _size, std::align_val_t{ buffer_alignment });
+        }
 
         lockfree_linear_allocator(const lockfree_linear_allocator&) = delete;
         lockfree_linear_allocator& operator=(const lockfree_linear_allocator&) = delete;
@@ -46,158 +49,60 @@ namespace drako::concurrency
         lockfree_linear_allocator(lockfree_linear_allocator&&) = delete;
         lockfree_linear_allocator& operator=(lockfree_linear_allocator&&) = delete;
 
-
-        // \brief       Allocates memory from the allocator.
-        // \param[in]   size    Size of the requested memory in bytes.
-        // \returns     Pointer to the first byte of the allocated memory.
-        // \retval      null    Pointer if the allocation fails.
-        //
-        DRAKO_NODISCARD DRAKO_ALLOCATOR void* allocate(
-            const size_t size) noexcept;
-
-
-        // \brief       Allocates memory from the allocator.
-        // \param[in]   size        Size of the requested memory in bytes.
-        // \param[in]   alignment   Alignment of the memory block (must be a power of 2).
-        // \returns     Pointer to the first byte of the allocated memory.
-        // \retval      null         The allocation failed.
-        //
-        DRAKO_NODISCARD DRAKO_ALLOCATOR void* allocate(
-            const size_t size,
-            const size_t alignment) noexcept;
-
-
-        // \brief   Deallocates all currently allocated memory.
-        //
-        void release() noexcept;
-
-    private:
-
-        TAlloc const& allocator;
-        size_t buffer_size;          // Size of reserved memory block
-        char* _buffer;           // Pointer to the base of the stack
-        std::atomic<char*> _head;    // Pointer to the current top of the stack
-    };
-
-
-    template <typename TAlloc>
-    inline lockfree_linear_allocator<TAlloc>::lockfree_linear_allocator(
-        const size_t size,
-        TAlloc const& allocator) noexcept
-    {
-        DRAKO_PRECON(size > 0);
-        DRAKO_PRECON(allocator != nullptr);
-
-        this->buffer_size = size;
-
-        if constexpr (TAlloc == std::allocator<void>)
-        {
-            this->_buffer = static_cast<char*>(_aligned_malloc(size, memory::DRKAPI_L1_CACHE_SIZE));
-        }
-        else
+        /// @brief Allocates memory from the allocator.
+        ///
+        /// @param[in] size      Size of the requested memory in bytes.
+        /// @param[in] alignment Alignment of the memory block (must be a power of 2).
+        ///
+        /// @return Pointer to the first byte of the allocated memory, or nullptr if there isn't enough space.
+        ///
+        [[nodiscard]] void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) noexcept
         {
-            this->allocator = allocator;
-            this->_buffer = static_cast<char*>(allocator.allocate(size, memory::DRKAPI_L1_CACHE_SIZE));
-        }
+            assert(size > 0);
+            assert(std::has_single_bit(alignment) && alignment <= buffer_alignment);
 
-        if (this->_buffer == nullptr)
-        {
-            std::exit(EXIT_FAILURE);
-        }
-        this->_head = this->_buffer;
+            for (auto offset = _offset.load(std::memory_order::relaxed);;)
+            {
+                const auto begin = (offset + alignment - 1) & ~(alignment - 1);
+                if (begin > _size || _size - begin < size) // not enough memory to satisfy request
+                    return nullptr;
 
-        #if DRKAPI_DEBUG
-        {
-            fill_garbage_memory(this->_buffer, this->buffer_size);
+                if (_offset.compare_exchange_weak(offset, begin + size, std::memory_order::relaxed))
+                    return _buffer + begin;
+                // else CAS reloads new value of offset
+            }
         }
-        #endif
-    }
 
+        /// @brief Deallocates all currently allocated memory.
+        ///
+        /// @warning Must not be called concurrently with allocate().
+        ///
+        void release() noexcept { _offset.store(0, std::memory_order::relaxed); }
 
-    template <typename TAlloc>
-    inline lockfree_linear_allocator<TAlloc>::~lockfree_linear_allocator() noexcept
-    {
-        DRAKO_PRECON(this->_buffer != nullptr);
-        DRAKO_PRECON(this->_head == this->_buffer,
-                     "Some memory is still allocated");
-
-        if constexpr (TAlloc == std::allocator<void>)
-        {
-            _aligned_free(this->_buffer);
-        }
-        else
+        /// @brief Checks whether a pointer was returned by this allocator.
+        [[nodiscard]] bool owns(const void* p) const noexcept
         {
-            this->allocator.deallocate(this->_buffer);
+            const auto address = reinterpret_cast<std::uintptr_t>(p);
+            const auto base    = reinterpret_cast<std::uintptr_t>(_buffer);
+            return address >= base && address < base + _size;
         }
-    }
-
-    template <typename TAlloc>
-    inline void* lockfree_linear_allocator<TAlloc>::allocate(const size_t size) noexcept
-    {
-        DRAKO_PRECON(size > 0);
 
-        for (;;)
+        /// @brief Number of bytes currently allocated, including padding.
+        [[nodiscard]] std::size_t used() const noexcept
         {
-            auto old_head = _head.load();
-            // Check if there is enough memory to satisfy request
-            if ((this->buffer_size - (old_head - _buffer)) >= size)
-            {
-                // Reserve bytes for the allocation
-                auto new_head = old_head + size;
-                #if DRKAPI_DEBUG
-                {
-                    new_head += sizeof(memory::DRKAPI_OVERFLOW_MEMORY);
-                }
-                #endif
-
-                // Try atomic exchange
-                if (_head.compare_exchange_strong(old_head, new_head))
-                {
-                    return old_head;
-                }
-            }
-            else
-            {
-                return nullptr;
-            }
+            const auto offset = _offset.load(std::memory_order::relaxed);
+            return offset < _size ? offset : _size;
         }
-    }
 
+        /// @brief Number of bytes reserved for the allocator.
+        [[nodiscard]] std::size_t capacity() const noexcept { return _size; }
 
-    template <typename TAlloc>
-    inline void* lockfree_linear_allocator<TAlloc>::allocate(const size_t size, const size_t alignment) noexcept
-    {
-        DRAKO_PRECON(size > 0);
-        DRAKO_PRECON(is_valid_alignment(alignment));
-
-        for (;;)
-        {
-            auto old_head = _head.load();
-            auto aligned_ptr = static_cast<char*>(align_up_pointer(old_head, alignment));
-            // Check if there is enough memory to satisfy request
-            if ((size - (aligned_ptr - this->_buffer)) >= this->buffer_size)
-            {
-                auto new_head = aligned_ptr + size;
-                // Try atomic exchange
-                if (_head.compare_exchange_strong(old_head, new_head))
-                {
-                    return aligned_ptr;
-                }
-            }
-            else
-            {
-                return nullptr;
-            }
-        }
-    }
-
+    private:
+        const std::size_t        _size;       // size of reserved memory block
+        std::byte* const         _buffer;     // base of the reserved memory block
+        std::atomic<std::size_t> _offset = 0; // current top of the stack
+    };
 
-    template <typename TAlloc>
-    inline void lockfree_linear_allocator<TAlloc>::release() noexcept
-    {
-        this->_head.store(this->_buffer/*, std::memory_order_release*/);
-    }
-}
+} // namespace drako::concurrency
 
 #endif // !DRAKO_LOCKFREE_LINEAR_ALLOCATOR_HPP
-
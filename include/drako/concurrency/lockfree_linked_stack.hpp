@@ -1,119 +1,143 @@
-//
-// \author  Grassi Edoardo
-//
-
+#pragma once
 #ifndef DRAKO_LOCKFREE_LINKED_STACK_HPP
 #define DRAKO_LOCKFREE_LINKED_STACK_HPP
 
-#include <atomic>
+/// @file
+/// @brief  Unbounded stack based on the Treiber algorithm.
+/// @author Grassi Edoardo
 
-#include "drako/core/drako_compiler.hpp"
-#include "drako/core/lockfree_pool_allocator.hpp"
+#include "drako/concurrency/memory_reclamation.hpp"
+
+#include <atomic>
+#include <new>
+#include <utility>
 
 namespace drako::lockfree
 {
+    /// @brief Thread-safe linearizable container with LIFO policy.
+    ///
+    /// Popped nodes are retired to an epoch domain, so that threads that still
+    /// hold a reference to the old head never access freed memory.
+    ///
     template <typename Ty>
     class linked_stack final
     {
     public:
-
-        explicit linked_stack(const size_t size) noexcept : allocator(size) {}
-        ~linked_stack() noexcept = default;
+        /// @brief Constructs an empty stack.
+        ///
+        /// @param[in] domain Reclamation domain used for popped nodes.
+        ///
+        explicit linked_stack(EpochDomain& domain = EpochDomain::global()) noexcept
+            : _domain{ domain } {}
+
+        /// @warning No other thread can access the stack when it's destroyed.
+        ~linked_stack() noexcept
+        {
+            for (auto n = _head.load(std::memory_order::relaxed); n != nullptr;)
+                delete std::exchange(n, n->next);
+        }
 
         linked_stack(linked_stack const&) = delete;
         linked_stack& operator=(linked_stack const&) = delete;
 
-        linked_stack(linked_stack &&) = delete;
-        linked_stack& operator=(linked_stack &&) = delete;
+        linked_stack(linked_stack&&) = delete;
+        linked_stack& operator=(linked_stack&&) = delete;
 
 
-        DRAKO_NODISCARD bool is_empty() const noexcept;
+        /// @brief Checks whether the stack is empty.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] bool is_empty() const noexcept
+        {
+            return _head.load(std::memory_order::relaxed) == nullptr;
+        }
 
-        bool push(Ty const& data) noexcept;
+        /// @brief Inserts an element on top of the stack.
+        ///
+        /// @return True if the value was inserted, false if memory is exhausted.
+        ///
+        bool push(Ty const& data) noexcept
+        {
+            const auto n = new (std::nothrow) node{ data, nullptr };
+            if (n == nullptr)
+                return false;
+
+            n->next = _head.load(std::memory_order::relaxed);
+            while (!_head.compare_exchange_weak(n->next, n,
+                std::memory_order::release, std::memory_order::relaxed))
+                ;
+            return true;
+        }
 
-        bool pop(Ty& result) noexcept;
+        /// @brief Removes the element on top of the stack.
+        ///
+        /// @return True if an element was removed, false if the stack is empty.
+        ///
+        bool pop(Ty& result) noexcept
+        {
+            const auto guard = _domain.pin();
+
+            // the guard prevents the reclamation of old_head while next is read
+            auto old_head = _head.load(std::memory_order::acquire);
+            do
+            {
+                if (old_head == nullptr)
+                    return false;
+            } while (!_head.compare_exchange_weak(old_head, old_head->next,
+                std::memory_order::acquire, std::memory_order::acquire));
+
+            result = old_head->data;
+            _domain.retire(guard, old_head);
+            return true;
+        }
 
-        bool push_unsafe(Ty const& data) noexcept;
+        /// @brief Inserts an element without synchronization.
+        bool push_unsafe(Ty const& data) noexcept
+        {
+            const auto n = new (std::nothrow) node{ data, _head.load(std::memory_order::relaxed) };
+            if (n == nullptr)
+                return false;
 
-        bool peek_unsafe(Ty& result) noexcept;
+            _head.store(n, std::memory_order::relaxed);
+            return true;
+        }
 
-        bool pop_unsafe(Ty& result) noexcept;
+        /// @brief Reads the element on top of the stack without synchronization.
+        bool peek_unsafe(Ty& result) const noexcept
+        {
+            const auto n = _head.load(std::memory_order::relaxed);
+            if (n == nullptr)
+                return false;
 
-    private:
+            result = n->data;
+            return true;
+        }
+
+        /// @brief Removes the element on top of the stack without synchronization.
+        bool pop_unsafe(Ty& result) noexcept
+        {
+            const auto n = _head.load(std::memory_order::relaxed);
+            if (n == nullptr)
+                return false;
+
+            _head.store(n->next, std::memory_order::relaxed);
+            result = n->data;
+            delete n;
+            return true;
+        }
 
+    private:
         struct node final
         {
             const Ty data;
-            node* next;
-
-            explicit node(Ty const& data_) noexcept : data(data_) {}
+            node*    next;
         };
 
-        std::atomic<Ty*> head = nullptr;
-        memory::lockfree_object_pool<node> allocator;
+        std::atomic<node*> _head = nullptr;
+        EpochDomain&       _domain;
     };
 
-    template<typename Ty>
-    inline bool linked_stack<Ty>::is_empty() const noexcept
-    {
-        return this->head.load(std::memory_order_relaxed) == nullptr;
-    }
-
-    template<typename Ty>
-    inline bool linked_stack<Ty>::push(Ty const& data) noexcept
-    {
-        node* new_node = new (this->allocator.allocate(sizeof(Ty))) node(data);
-        if (new_node == nullptr) { return false; }
-
-        new_node.next = this->head.load();
-        while (!this->head.compare_exchange_weak(new_node.next, new_node));
-        return true;
-    }
-
-    template<typename Ty>
-    inline bool linked_stack<Ty>::pop(Ty& result) noexcept
-    {
-        node* old_head = this->head.load();
-        do
-        {
-            if (old_head == nullptr) { return false; }
-        }
-        while (!head.compare_exchange_weak(old_head, old_head->next));
-
-        result = old_head;
-        this->allocator.deallocate(old_head);
-        return true;
-    }
-
-    template<typename Ty>
-    inline bool linked_stack<Ty>::push_unsafe(Ty const& data) noexcept
-    {
-        node* new_node = new (this->allocator.allocate(sizeof(Ty))) node(data);
-        if (new_node == nullptr) { return false; }
-
-        new_node.next = this->head.load(std::memory_order_relaxed);
-        this->head.store(new_node, std::memory_order_relaxed);
-        return true;
-    }
-
-    template<typename Ty>
-    inline bool linked_stack<Ty>::peek_unsafe(Ty& result) noexcept
-    {
-        auto curr_head = this->head.load(std::memory_order_relaxed);
-        if (curr_head == nullptr) { return false; }
-        result = curr_head;
-        return true;
-    }
-
-    template<typename Ty>
-    inline bool linked_stack<Ty>::pop_unsafe(Ty& result) noexcept
-    {
-        auto curr_head = this->head.load(std::memory_order_relaxed);
-        if (curr_head == nullptr) { return false; }
-        this->head = curr_head.next;
-        result = curr_head;
-        return true;
-    }
-}
+} // namespace drako::lockfree
 
 #endif // !DRAKO_LOCKFREE_LINKED_STACK_HPP
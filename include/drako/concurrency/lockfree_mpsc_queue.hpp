@@ -0,0 +1,271 @@
+#pragma once
+#ifndef DRAKO_LOCKFREE_MPSC_QUEUE_HPP
+#define DRAKO_LOCKFREE_MPSC_QUEUE_HPP
+
+/// @file
+/// @brief   Unbounded multiple producers, single consumer queues.
+/// @author  Grassi Edoardo
+
+#include "drako/concurrency/lockfree_pool_allocator.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace drako::lockfree
+{
+    /// @brief Link embedded in the elements of an intrusive queue.
+    struct IntrusiveQueueHook
+    {
+        std::atomic<IntrusiveQueueHook*> next = nullptr;
+    };
+
+
+    /// @brief Intrusive FIFO container for many writers and a single reader.
+    ///
+    /// Based on the algorithm by Dmitry Vyukov: a push is a single exchange on the
+    /// head of the list followed by the store of the link, so writers are wait-free
+    /// and never contend with the reader. Elements are linked through the hook
+    /// they inherit from, the queue never allocates.
+    ///
+    /// @tparam T Type of the linked elements.
+    ///
+    /// @note An element whose push is still in progress blocks the view of the ones
+    ///       pushed after it, deque() fails until the link is published.
+    ///
+    template <typename T> // clang-format off
+    requires std::derived_from<T, IntrusiveQueueHook>
+    class SR_MW_IntrusiveQueue final // clang-format on
+    {
+    public:
+        explicit SR_MW_IntrusiveQueue() noexcept
+            : _head{ &_stub }, _tail{ &_stub } {}
+
+        SR_MW_IntrusiveQueue(const SR_MW_IntrusiveQueue&) = delete;
+        SR_MW_IntrusiveQueue& operator=(const SR_MW_IntrusiveQueue&) = delete;
+
+        /// @brief Inserts an element in the queue.
+        ///
+        /// @param[in] node Element to insert, must stay alive until it's removed.
+        ///
+        /// @note Thread-safe and wait-free.
+        ///
+        void enque(T* node) noexcept
+        {
+            assert(node);
+            _push(node);
+        }
+
+        /// @brief Removes an element from the queue.
+        ///
+        /// @return Removed element, or nullptr if the queue is empty.
+        ///
+        /// @note Thread-safe for concurrent execution with any number of writers
+        ///       and a single reader thread.
+        ///
+        [[nodiscard]] T* deque() noexcept
+        {
+            auto tail = _tail;
+            auto next = tail->next.load(std::memory_order::acquire);
+            if (tail == &_stub) // skip the placeholder
+            {
+                if (next == nullptr)
+                    return nullptr;
+                _tail = tail = next;
+                next         = next->next.load(std::memory_order::acquire);
+            }
+            if (next != nullptr)
+            {
+                _tail = next;
+                return static_cast<T*>(tail);
+            }
+
+            // tail is the last element, unless a writer is in the middle of a push
+            if (tail != _head.load(std::memory_order::acquire))
+                return nullptr;
+
+            // put back the placeholder, so that the last element can be unlinked
+            _push(&_stub);
+            if (next = tail->next.load(std::memory_order::acquire); next != nullptr)
+            {
+                _tail = next;
+                return static_cast<T*>(tail);
+            }
+            return nullptr;
+        }
+
+        /// @brief Checks whether the queue is empty.
+        ///
+        /// @warning Must be called by the reader thread.
+        ///
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return _tail->next.load(std::memory_order::acquire) == nullptr
+                && _head.load(std::memory_order::acquire) == _tail;
+        }
+
+    private:
+        /*vvv avoid false cache sharing between reader and writers vvv*/
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<IntrusiveQueueHook*> _head; // last inserted element
+
+        alignas(std::hardware_destructive_interference_size)
+            IntrusiveQueueHook* _tail; // next element to remove, owned by the reader
+
+        IntrusiveQueueHook _stub; // placeholder that keeps the list non-empty
+
+        void _push(IntrusiveQueueHook* node) noexcept
+        {
+            node->next.store(nullptr, std::memory_order::relaxed);
+            const auto prev = _head.exchange(node, std::memory_order::acq_rel);
+            prev->next.store(node, std::memory_order::release);
+        }
+    };
+
+
+    /// @brief Unbounded FIFO container for many writers and a single reader.
+    ///
+    /// Wraps an intrusive queue, the nodes are taken from a lock-free pool;
+    /// once the pool is full, the nodes that don't fit are allocated from the heap.
+    /// Meant for commands that are submitted by any thread and drained by the
+    /// owner of a system once per update.
+    ///
+    template <typename T>
+    class SR_MW_Queue final
+    {
+    public:
+        using value_type = T;
+
+        /// @brief Constructor.
+        ///
+        /// @param[in] reserved Number of nodes reserved each time the storage grows.
+        ///
+        explicit SR_MW_Queue(std::size_t reserved = 64)
+            : _nodes{ reserved } {}
+
+        /// @warning No other thread can access the queue when it's destroyed.
+        ~SR_MW_Queue() noexcept
+        {
+            for (_node* n; (n = _queue.deque()) != nullptr;)
+                _destroy(n);
+        }
+
+        SR_MW_Queue(const SR_MW_Queue&) = delete;
+        SR_MW_Queue& operator=(const SR_MW_Queue&) = delete;
+
+        /// @brief Inserts an element in the queue.
+        ///
+        /// @throw std::bad_alloc if memory is exhausted.
+        ///
+        /// @note Thread-safe, lock-free as long as the pool has free nodes.
+        ///
+        template <typename... Args> // clang-format off
+        requires std::is_constructible_v<T, Args...>
+        void enque(Args&&... args) // clang-format on
+        {
+            auto       n      = _nodes.try_allocate();
+            const auto pooled = n != nullptr;
+            if (!pooled)
+                n = std::allocator<_node>{}.allocate(1);
+            try
+            {
+                _queue.enque(std::construct_at(n, pooled, std::forward<Args>(args)...));
+            }
+            catch (...)
+            {
+                _deallocate(n, pooled);
+                throw;
+            }
+        }
+
+        /// @brief Removes an element from the queue.
+        ///
+        /// @param[out] value Destination for the element to remove.
+        ///
+        /// @return True if an element has been removed, false otherwise.
+        ///
+        /// @note Thread-safe for a single reader thread.
+        ///
+        [[nodiscard]] bool deque(T& value) noexcept(std::is_nothrow_move_assignable_v<T>)
+        {
+            const auto n = _queue.deque();
+            if (n == nullptr)
+                return false;
+
+            value = std::move(n->value);
+            _destroy(n);
+            return true;
+        }
+
+        /// @brief Removes all the elements visible to the reader, in order.
+        ///
+        /// @param[in] visitor Callable invoked with each element as rvalue.
+        ///
+        /// @return The number of elements removed.
+        ///
+        /// @note Thread-safe for a single reader thread.
+        ///
+        template <typename Visitor> // clang-format off
+        requires std::is_invocable_v<Visitor&, T&&>
+        std::size_t drain(Visitor visitor) // clang-format on
+        {
+            std::size_t count = 0;
+            for (_node* n; (n = _queue.deque()) != nullptr; ++count)
+            {
+                const std::unique_ptr<_node, _deleter> guard{ n, _deleter{ this } };
+                visitor(std::move(n->value));
+            }
+            return count;
+        }
+
+        /// @brief Checks whether the queue is empty.
+        ///
+        /// @warning Must be called by the reader thread.
+        ///
+        [[nodiscard]] bool empty() const noexcept { return _queue.empty(); }
+
+    private:
+        struct _node : IntrusiveQueueHook
+        {
+            template <typename... Args>
+            explicit _node(bool p, Args&&... args)
+                : value(std::forward<Args>(args)...), pooled{ p } {}
+
+            T    value;
+            bool pooled; // false if allocated from the heap
+        };
+
+        struct _deleter
+        {
+            SR_MW_Queue* queue;
+            void         operator()(_node* n) const noexcept { queue->_destroy(n); }
+        };
+
+        Pool<_node>                 _nodes;
+        SR_MW_IntrusiveQueue<_node> _queue;
+
+        void _destroy(_node* n) noexcept
+        {
+            const auto pooled = n->pooled;
+            std::destroy_at(n);
+            _deallocate(n, pooled);
+        }
+
+        void _deallocate(_node* n, bool pooled) noexcept
+        {
+            if (pooled)
+                _nodes.deallocate(n, 1);
+            else
+                std::allocator<_node>{}.deallocate(n, 1);
+        }
+    };
+
+} // namespace drako::lockfree
+
+#endif // !DRAKO_LOCKFREE_MPSC_QUEUE_HPP
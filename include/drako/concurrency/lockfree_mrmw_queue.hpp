@@ -7,40 +7,69 @@
 /// @author      Grassi Edoardo
 /// @date        Last update: 16-05-2019
 
-#include "drako/concurrency/lockfree_pool_allocator.hpp"
+#include "drako/concurrency/event_count.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
-#include <limits>
-#include <optional>
-#include <tuple>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
 
 namespace drako::lockfree
 {
     /// @brief Thread-safe linearizable container with FIFO policy and bounded capacity.
-    template <typename T>
-    class MR_MW_Queue
+    ///
+    /// Array based implementation where each slot carries a sequence number
+    /// that tells producers and consumers whether it's ready for them,
+    /// so that elements are stored in place without any per-element allocation.
+    ///
+    template <typename T, typename Al = std::allocator<T>> // clang-format off
+    requires std::atomic<std::size_t>::is_always_lock_free
+    class MR_MW_Queue // clang-format on
     {
-        using node_id = std::uint32_t;
-        struct stamped_ref final
+        struct _slot
         {
-            std::uint16_t counter;
-            std::uint16_t index;
+            std::atomic<std::size_t>                      sequence;
+            std::aligned_storage_t<sizeof(T), alignof(T)> storage;
         };
 
-        static constexpr const auto node_id_mask = (std::numeric_limits<node_id>::max() >> 1);
-
-        static_assert(std::atomic<T*>::is_always_lock_free, "Can't guarantee atomicity");
+        using _slot_alloc = typename std::allocator_traits<Al>::template rebind_alloc<_slot>;
+        using _al_traits  = std::allocator_traits<_slot_alloc>;
 
     public:
-        //using allocator = lockfree::Pool<T>;
+        using value_type     = T;
+        using size_type      = std::size_t;
+        using allocator_type = Al;
 
         /// @brief     Constructor.
         /// @param[in] capacity Max number of objects that can be stored inside the queue.
-        explicit MR_MW_Queue(const std::size_t capacity)
-            : _alloc{ capacity }
+        /// @param[in] alloc    Dedicated allocator.
+        explicit MR_MW_Queue(const std::size_t capacity, const Al& alloc = Al())
+            : _alloc{ alloc }
+            , _size{ capacity }
+            , _slots{ _al_traits::allocate(_alloc, capacity) }
         {
             assert(capacity > 0);
+            for (std::size_t i = 0; i < _size; ++i)
+                _al_traits::construct(_alloc, _slots + i, i);
+        }
+
+        ~MR_MW_Queue() noexcept
+        {
+            assert(_slots != nullptr);
+
+            // destroy any item left in the queue
+            const auto head = _head.load();
+            const auto tail = _tail.load();
+            for (auto i = head; i != tail; ++i)
+                std::destroy_at(_value(_slots[i % _size]));
+
+            for (std::size_t i = 0; i < _size; ++i)
+                _al_traits::destroy(_alloc, _slots + i);
+            _al_traits::deallocate(_alloc, _slots, _size);
         }
 
         MR_MW_Queue(const MR_MW_Queue&) noexcept = delete;
@@ -52,83 +81,242 @@ namespace drako::lockfree
 
         /// @brief   Number of objects that the queue can hold.
         ///
-        [[nodiscard]] constexpr size_t capacity() const noexcept
+        [[nodiscard]] constexpr std::size_t capacity() const noexcept { return _size; }
+
+        /// @brief Approximate number of objects in the queue.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] std::size_t size() const noexcept
         {
-            return _alloc.capacity();
+            const auto head = _head.load(std::memory_order::relaxed);
+            const auto tail = _tail.load(std::memory_order::relaxed);
+            return (tail > head) ? tail - head : 0;
         }
 
+        /// @brief Checks whether the queue is empty.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
         /// @brief Adds an object to the tail of the queue.
         ///
         /// @param[in] value     Object to enqueue.
         ///
-        /// @return Returns true if the operation succeeded, false otherwise.
+        /// @return Returns true if the operation succeeded, false if the queue is full.
         ///
         [[nodiscard]] bool enque(const T& value) noexcept
         {
-            _node* new_node = new (_alloc.allocate(sizeof(_node))) _node(value);
-            if (new_node == nullptr) // pool is out of nodes
-                return false;
+            for (auto pos = _tail.load(std::memory_order::relaxed);;)
+            {
+                auto&      slot = _slots[pos % _size];
+                const auto diff = _distance(slot.sequence.load(std::memory_order::acquire), pos);
+                if (diff == 0) // slot is free, try to claim it
+                {
+                    if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order::relaxed))
+                    {
+                        std::construct_at(_value(slot), value);
+                        slot.sequence.store(pos + 1, std::memory_order::release);
+                        _not_empty.notify_one();
+                        return true;
+                    }
+                    // else CAS reloads new value of tail in pos
+                }
+                else if (diff < 0) // slot still holds an object from the previous cycle
+                    return false;
+                else // another producer claimed the slot
+                    pos = _tail.load(std::memory_order::relaxed);
+            }
+        }
+
+        /// @brief Adds a batch of objects to the tail of the queue.
+        ///
+        /// Consecutive slots are claimed with a single atomic operation.
+        ///
+        /// @param[in] values    Objects to enqueue.
+        ///
+        /// @return The number of objects enqueued, always a prefix of the source values.
+        ///
+        [[nodiscard]] std::size_t enque_bulk(std::span<const T> values) noexcept
+        {
+            if (std::empty(values))
+                return 0;
 
-            for (;;)
+            for (auto pos = _tail.load(std::memory_order::relaxed);;)
             {
-                auto last = _tail.load();
-                auto next = last->next.load();
+                // count how many consecutive slots are ready for this cycle
+                std::size_t count = 0;
+                while (count < std::size(values) && count < _size
+                       && _slots[(pos + count) % _size].sequence.load(std::memory_order::acquire) == pos + count)
+                    ++count;
 
-                // try append on the tail
-                if (last->next.compare_exchange_weak(next, new_node))
+                if (count == 0)
                 {
-                    // update tail hint if no other thread already did
-                    _tail.compare_exchange_strong(last, new_node);
-                    return true;
+                    const auto diff = _distance(
+                        _slots[pos % _size].sequence.load(std::memory_order::acquire), pos);
+                    if (diff < 0) // queue is full
+                        return 0;
+                    pos = _tail.load(std::memory_order::relaxed);
+                    continue;
                 }
+
+                if (_tail.compare_exchange_weak(pos, pos + count, std::memory_order::relaxed))
+                {
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        auto& slot = _slots[(pos + i) % _size];
+                        std::construct_at(_value(slot), values[i]);
+                        slot.sequence.store(pos + i + 1, std::memory_order::release);
+                    }
+                    if (count > 1)
+                        _not_empty.notify_all();
+                    else
+                        _not_empty.notify_one();
+                    return count;
+                }
+                // else CAS reloads new value of tail in pos
             }
         }
 
         /// @brief Removes an object from the head of the queue.
         ///
-        /// @param[out] result   Dequeued object.
+        /// @param[out] value    Dequeued object.
         ///
-        /// @return Returns true if the operation succeeded, false otherwise.
+        /// @return Returns true if the operation succeeded, false if the queue is empty.
         ///
         [[nodiscard]] bool deque(T& value) noexcept
         {
-            _node* const first = _head.load();
-            for (;;)
+            for (auto pos = _head.load(std::memory_order::relaxed);;)
             {
-                _node* const next = first->next.load();
-
-                if (next == nullptr) // only sentinel node in the queue
+                auto&      slot = _slots[pos % _size];
+                const auto diff = _distance(slot.sequence.load(std::memory_order::acquire), pos + 1);
+                if (diff == 0) // slot is full, try to claim it
                 {
+                    if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order::relaxed))
+                    {
+                        value = std::move(*_value(slot));
+                        std::destroy_at(_value(slot));
+                        slot.sequence.store(pos + _size, std::memory_order::release);
+                        return true;
+                    }
+                    // else CAS reloads new value of head in pos
+                }
+                else if (diff < 0) // slot hasn't been filled yet
                     return false;
+                else // another consumer claimed the slot
+                    pos = _head.load(std::memory_order::relaxed);
+            }
+        }
+
+        /// @brief Removes a batch of objects from the head of the queue.
+        ///
+        /// Consecutive slots are claimed with a single atomic operation.
+        ///
+        /// @param[out] values   Destination for the dequeued objects.
+        ///
+        /// @return The number of objects dequeued, always stored in a prefix of the destination.
+        ///
+        [[nodiscard]] std::size_t deque_bulk(std::span<T> values) noexcept
+        {
+            if (std::empty(values))
+                return 0;
+
+            for (auto pos = _head.load(std::memory_order::relaxed);;)
+            {
+                // count how many consecutive slots have been filled
+                std::size_t count = 0;
+                while (count < std::size(values) && count < _size
+                       && _slots[(pos + count) % _size].sequence.load(std::memory_order::acquire) == pos + count + 1)
+                    ++count;
+
+                if (count == 0)
+                {
+                    const auto diff = _distance(
+                        _slots[pos % _size].sequence.load(std::memory_order::acquire), pos + 1);
+                    if (diff < 0) // queue is empty
+                        return 0;
+                    pos = _head.load(std::memory_order::relaxed);
+                    continue;
                 }
-                else
+
+                if (_head.compare_exchange_weak(pos, pos + count, std::memory_order::relaxed))
                 {
-                    if (_head.compare_exchange_strong(first, next))
+                    for (std::size_t i = 0; i < count; ++i)
                     {
-                        value = first->value;
-                        // TODO: free 'first' node
-                        return true;
+                        auto& slot = _slots[(pos + i) % _size];
+                        values[i]  = std::move(*_value(slot));
+                        std::destroy_at(_value(slot));
+                        slot.sequence.store(pos + i + _size, std::memory_order::release);
                     }
-                    // else CAS reloads new value of head in first
+                    return count;
                 }
+                // else CAS reloads new value of head in pos
             }
         }
 
-    private:
-        struct _node final
+        /// @brief Removes an object from the head of the queue, waiting while the queue is empty.
+        ///
+        /// The consumer spins for a short time, then parks until a producer publishes new objects.
+        ///
+        /// @param[out] value    Dequeued object.
+        /// @param[in]  stop     Condition that interrupts the wait, see wake_consumers().
+        ///
+        /// @return Returns true if the operation succeeded, false if the wait was interrupted.
+        ///
+        template <typename Stop>
+        [[nodiscard]] bool deque_wait(T& value, Stop stop)
         {
-            const T             value; // Object stored.
-            std::atomic<_node*> next;  // Pointer to the next node in the queue.
+            bool removed = false;
+            _not_empty.await([&]() { return (removed = deque(value)) || stop(); });
+            return removed;
+        }
 
-            explicit _node(const T& value)
-                : value(value), next{ nullptr } {}
-        };
+        /// @brief Removes a batch of objects from the head of the queue, waiting while the queue is empty.
+        ///
+        /// @param[out] values   Destination for the dequeued objects.
+        /// @param[in]  stop     Condition that interrupts the wait, see wake_consumers().
+        ///
+        /// @return The number of objects dequeued, zero if the wait was interrupted.
+        ///
+        template <typename Stop>
+        [[nodiscard]] std::size_t deque_bulk_wait(std::span<T> values, Stop stop)
+        {
+            std::size_t count = 0;
+            _not_empty.await([&]() { return (count = deque_bulk(values)) > 0 || stop(); });
+            return count;
+        }
+
+        /// @brief Wakes up all the parked consumers so that they can evaluate again their stop condition.
+        void wake_consumers() noexcept { _not_empty.notify_all(); }
+
+    private:
+        _slot_alloc       _alloc;
+        const std::size_t _size;
+        _slot*            _slots;
 
-        lockfree::Pool<T>        _alloc;          // lockfree allocator for the queue nodes
-        std::atomic<stamped_ref> _head = nullptr; // pointer to first node
-        std::atomic<stamped_ref> _tail = nullptr; // pointer to last node
+        /*vvv avoid false cache sharing between producers and consumers vvv*/
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<std::size_t> _head = 0; // next position to read
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<std::size_t> _tail = 0; // next position to write
+
+        alignas(std::hardware_destructive_interference_size)
+            EventCount _not_empty; // parks consumers while the queue is empty
+
+        [[nodiscard]] static T* _value(_slot& s) noexcept
+        {
+            return std::launder(reinterpret_cast<T*>(&s.storage));
+        }
+
+        [[nodiscard]] static std::ptrdiff_t _distance(std::size_t sequence, std::size_t pos) noexcept
+        {
+            return static_cast<std::ptrdiff_t>(sequence - pos);
+        }
     };
 
 } // namespace drako::lockfree
 
-#endif // !DRAKO_LOCKFREE_MRMW_QUEUE_HPP
\ No newline at end of file
+#endif // !DRAKO_LOCKFREE_MRMW_QUEUE_HPP
@@ -7,11 +7,16 @@
 /// @author Grassi Edoardo
 /// @date   Last update: 03-09-2019
 
+#include "drako/concurrency/thread_index.hpp"
 #include "drako/core/compiler.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <bit>
 #include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <new>     // std::bad_alloc
 #include <numeric> // std::iota
@@ -21,17 +26,42 @@ namespace drako::lockfree
 {
     /// @brief Thread-safe lock-free pool allocator.
     ///
-    /// @tparam Size        Byte size of a single memory block.
-    /// @tparam Align       Minimum address alignment guaranteed by each memory block.
+    /// Each thread keeps a small magazine of free blocks, so that most requests are
+    /// served without touching the shared free list; magazines are refilled from
+    /// and flushed to the shared list in batches of half their capacity.
     ///
-    template <typename T, std::size_t Size> // clang-format off
-    requires std::atomic<std::uint32_t>::is_always_lock_free && (Size > 0)
+    /// @tparam T            Type of the objects allocated from the pool.
+    /// @tparam Size         Number of memory blocks.
+    /// @tparam MagazineSize Max number of free blocks cached by each thread.
+    ///
+    /// @note Blocks cached by a thread aren't available to the others,
+    ///       so an allocation can fail before all the blocks are in use.
+    ///
+    template <typename T, std::size_t Size, std::size_t MagazineSize = 32> // clang-format off
+    requires std::atomic<std::uint64_t>::is_always_lock_free
+        && (Size > 0) && (Size < std::numeric_limits<std::uint32_t>::max()) && (MagazineSize >= 2)
     class StaticPool // clang-format on
     {
     public:
         // types declarations for std::allocator_traits
         using value_type = T;
 
+        /// @brief Contention statistics.
+        struct Stats
+        {
+            /// @brief Requests served by the magazine of the calling thread.
+            std::size_t cached;
+
+            /// @brief Batches moved from the shared free list to a magazine.
+            std::size_t refills;
+
+            /// @brief Batches moved from a magazine to the shared free list.
+            std::size_t flushes;
+
+            /// @brief Failed attempts to update the shared free list.
+            std::size_t contended;
+        };
+
         explicit StaticPool() noexcept
             : _head{ 0 }
         {
@@ -45,54 +75,102 @@ namespace drako::lockfree
         StaticPool(StaticPool&&) = delete;
         StaticPool& operator=(StaticPool&&) = delete;
 
-        [[nodiscard]] DRAKO_ALLOCATOR T* DRAKO_RESTRICT allocate(std::size_t n)
+        [[nodiscard]] DRAKO_ALLOCATOR T* allocate([[maybe_unused]] std::size_t n)
         {
             assert(n == 1); // we can only allocate single objects
 
-            for (auto head = _head.load();;)
+            if (const auto t = this_thread_index(); t < thread_index_limit) [[likely]]
             {
-                const auto block = block_index(head);
-                if (block == empty_pool_value) // no free blocks left
-                    throw std::bad_alloc{};
-
-                const auto next_tag   = aba_tag(head) + 1;
-                const auto next_block = _list[head].load();
+                auto& m = _magazines[t];
+                if (m.count == 0)
+                {
+                    m.count = _pop(m.blocks, MagazineSize / 2);
+                    if (m.count == 0) // no free blocks left
+                        throw std::bad_alloc{};
+                    _refills.fetch_add(1, std::memory_order::relaxed);
+                }
+                else
+                    m.hits.store(m.hits.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
 
-                const auto new_head = compose_index_and_tag(next_block, next_tag);
-                if (_head.compare_exchange_strong(head, new_head))
-                    return reinterpret_cast<T*>(_pool + block);
+                return _address(m.blocks[--m.count]);
             }
+
+            // too many threads, go straight to the shared list
+            std::uint32_t block;
+            if (_pop(&block, 1) == 0)
+                throw std::bad_alloc{};
+            return _address(block);
         }
 
-        void deallocate(T* DRAKO_RESTRICT p, std::size_t n) noexcept
+        void deallocate(T* DRAKO_RESTRICT p, [[maybe_unused]] std::size_t n) noexcept
         {
             assert(n == 1); // we can only deallocate single objects
             assert(p);
-            assert((p >= _pool) && p < (_pool + Size));
 
-            const auto block = static_cast<std::size_t>(std::distance(_pool, p));
-            for (auto head = _head.load();;)
-            { // try to push our block as the new head of the free list
-                _list[block] = head;
-                if (_head.compare_exchange_strong(head, block))
-                    return;
-                // else the new head value gets loaded by CAS instruction
+            const auto offset = std::distance(_pool, reinterpret_cast<_block*>(p));
+            assert(offset >= 0 && offset < static_cast<std::ptrdiff_t>(Size));
+            const auto block = static_cast<std::uint32_t>(offset);
+
+            if (const auto t = this_thread_index(); t < thread_index_limit) [[likely]]
+            {
+                auto& m = _magazines[t];
+                if (m.count == MagazineSize)
+                { // give back the least recently used half
+                    _push(m.blocks, MagazineSize / 2);
+                    std::move(m.blocks + MagazineSize / 2, m.blocks + MagazineSize, m.blocks);
+                    m.count -= MagazineSize / 2;
+                    _flushes.fetch_add(1, std::memory_order::relaxed);
+                }
+                else
+                    m.hits.store(m.hits.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+
+                m.blocks[m.count++] = block;
+                return;
             }
+            _push(&block, 1);
         }
 
         [[nodiscard]] constexpr std::size_t capacity() const noexcept { return Size; }
 
+        /// @brief Contention statistics collected since the construction of the pool.
+        ///
+        /// @warning The values may be stale as soon as they are returned.
+        ///
+        [[nodiscard]] Stats stats() const noexcept
+        {
+            Stats s{};
+            for (const auto& m : _magazines)
+                s.cached += m.hits.load(std::memory_order::relaxed);
+            s.refills   = _refills.load(std::memory_order::relaxed);
+            s.flushes   = _flushes.load(std::memory_order::relaxed);
+            s.contended = _contended.load(std::memory_order::relaxed);
+            return s;
+        }
+
     private:
         using _block = std::aligned_storage_t<sizeof(T), alignof(T)>;
 
-        static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
-            "Required to guarantee lock-free property.");
-
         static const auto empty_pool_value = std::numeric_limits<std::uint32_t>::max();
 
-        std::atomic<std::uint64_t> _head;       // head of free list of unallocated blocks
+        /// @brief Free blocks cached by a single thread.
+        struct alignas(std::hardware_destructive_interference_size) _magazine
+        {
+            std::uint32_t            blocks[MagazineSize];
+            std::size_t              count = 0;
+            std::atomic<std::size_t> hits  = 0; // written only by the owner thread
+        };
+
+        /*vvv avoid false cache sharing between the shared list and the magazines vvv*/
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<std::uint64_t> _head;       // head of free list of unallocated blocks
+        std::atomic<std::size_t>       _refills = 0;
+        std::atomic<std::size_t>       _flushes = 0;
+        std::atomic<std::size_t>       _contended = 0;
+
         std::atomic<std::uint32_t> _list[Size]; // free list blocks
         _block                     _pool[Size]; // memory blocks
+        _magazine                  _magazines[thread_index_limit];
 
         [[nodiscard]] static std::uint32_t block_index(std::uint64_t head) noexcept
         {
@@ -104,29 +182,309 @@ namespace drako::lockfree
             return static_cast<std::uint32_t>(head >> 32);
         }
 
-        [[nodiscard]] static std::uint64_t compose_index_and_tag(std::uint32_t index, std::uint32_t tag)
+        [[nodiscard]] static std::uint64_t compose_index_and_tag(std::uint32_t index, std::uint32_t tag) noexcept
         {
-            return static_cast<std::uint64_t>(index) & (static_cast<std::uint64_t>(tag) << 32);
+            return static_cast<std::uint64_t>(index) | (static_cast<std::uint64_t>(tag) << 32);
+        }
+
+        [[nodiscard]] T* _address(std::uint32_t block) noexcept
+        {
+            return reinterpret_cast<T*>(_pool + block);
+        }
+
+        // detaches up to max blocks from the shared list with a single CAS
+        [[nodiscard]] std::size_t _pop(std::uint32_t* blocks, std::size_t max) noexcept
+        {
+            for (auto head = _head.load(std::memory_order::acquire);;)
+            {
+                // the chain can't change while head keeps the same tag, since
+                // blocks are removed only from the front of the list
+                std::size_t count = 0;
+                for (auto b = block_index(head); b != empty_pool_value && count < max;
+                     b        = _list[b].load(std::memory_order::relaxed))
+                    blocks[count++] = b;
+
+                if (count == 0) // no free blocks left
+                    return 0;
+
+                const auto next     = _list[blocks[count - 1]].load(std::memory_order::relaxed);
+                const auto new_head = compose_index_and_tag(next, aba_tag(head) + 1);
+                if (_head.compare_exchange_weak(head, new_head,
+                        std::memory_order::acquire, std::memory_order::acquire))
+                    return count;
+
+                // else the new head value gets loaded by CAS instruction
+                _contended.fetch_add(1, std::memory_order::relaxed);
+            }
         }
 
-#if defined(DRKAPI_DEBUG)
-        std::atomic<std::size_t> _debug_allocated_blocks_count;
-#endif
+        // attaches a chain of blocks to the shared list with a single CAS
+        void _push(const std::uint32_t* blocks, std::size_t count) noexcept
+        {
+            assert(count > 0);
+            for (std::size_t i = 0; i + 1 < count; ++i)
+                _list[blocks[i]].store(blocks[i + 1], std::memory_order::relaxed);
+
+            auto& last = _list[blocks[count - 1]];
+            for (auto head = _head.load(std::memory_order::relaxed);;)
+            {
+                last.store(block_index(head), std::memory_order::relaxed);
+                const auto new_head = compose_index_and_tag(blocks[0], aba_tag(head) + 1);
+                if (_head.compare_exchange_weak(head, new_head,
+                        std::memory_order::release, std::memory_order::relaxed))
+                    return;
+
+                // else the new head value gets loaded by CAS instruction
+                _contended.fetch_add(1, std::memory_order::relaxed);
+            }
+        }
     };
 
-    template <typename T, typename Al = std::allocator<T>>
-    class Pool
+    /// @brief Thread-safe lock-free pool allocator with unbounded capacity.
+    ///
+    /// Memory is reserved in chunks of fixed size that are never released until
+    /// the pool is destroyed, so allocated objects keep a stable address while the pool grows.
+    /// Each slot carries a generation counter, bumped every time the slot is released,
+    /// so that handles to recycled slots can be detected.
+    ///
+    /// @tparam T  Type of the objects allocated from the pool.
+    /// @tparam Al Allocator used to reserve the chunks.
+    ///
+    template <typename T, typename Al = std::allocator<T>> // clang-format off
+    requires std::atomic<std::uint64_t>::is_always_lock_free
+    class Pool // clang-format on
     {
+        struct _slot
+        {
+            std::aligned_storage_t<sizeof(T), alignof(T)> storage; // must be the first member
+            std::uint32_t                                 index;
+            std::atomic<std::uint32_t>                    next;       // free list link
+            std::atomic<std::uint32_t>                    generation; // bumped on each release
+        };
+
+        using _slot_alloc = typename std::allocator_traits<Al>::template rebind_alloc<_slot>;
+        using _al_traits  = std::allocator_traits<_slot_alloc>;
+
     public:
         // type declarations for std::allocator_traits
         using value_type = T;
 
-        explicit Pool(std::size_t capacity, Al al = Al());
+        /// @brief Max number of chunks that the pool can reserve.
+        static constexpr const std::size_t max_chunks = 64;
+
+        /// @brief Generation-tagged reference to an object allocated from the pool.
+        struct Handle
+        {
+            std::uint32_t index;
+            std::uint32_t generation;
+
+            [[nodiscard]] friend constexpr bool operator==(const Handle&, const Handle&) noexcept = default;
+        };
+
+        /// @brief Constructor.
+        ///
+        /// @param[in] capacity Number of objects in each chunk, the first chunk is reserved immediately.
+        /// @param[in] al       Allocator used to reserve the chunks.
+        ///
+        explicit Pool(std::size_t capacity, Al al = Al())
+            : _alloc{ al }
+            , _chunk_size{ capacity }
+        {
+            assert(capacity > 0);
+            assert(capacity * max_chunks < empty_pool_value);
+            [[maybe_unused]] const auto reserved = _grow();
+            assert(reserved);
+        }
+
+        /// @warning Objects still allocated from the pool aren't destroyed.
+        ~Pool() noexcept
+        {
+            for (auto& c : _chunks)
+                if (const auto chunk = c.load(std::memory_order::relaxed); chunk != nullptr)
+                    _release(chunk);
+        }
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        Pool(Pool&&) = delete;
+        Pool& operator=(Pool&&) = delete;
+
+        /// @brief Allocates storage for a single object.
+        ///
+        /// @note Reserves a new chunk if there are no free slots left.
+        ///
+        /// @throw std::bad_alloc if all the chunks are in use.
+        ///
+        [[nodiscard]] DRAKO_ALLOCATOR T* allocate([[maybe_unused]] std::size_t n = 1)
+        {
+            assert(n == 1); // we can only allocate single objects
+
+            if (const auto p = try_allocate(); p != nullptr)
+                return p;
+            throw std::bad_alloc{};
+        }
+
+        /// @brief Allocates storage for a single object, if the pool isn't full.
+        ///
+        /// @return Storage for the object, or nullptr if all the chunks are in use.
+        ///
+        /// @throw std::bad_alloc if a new chunk can't be reserved.
+        ///
+        [[nodiscard]] DRAKO_ALLOCATOR T* try_allocate()
+        {
+            for (;;)
+            {
+                for (auto head = _head.load(std::memory_order::acquire);
+                     block_index(head) != empty_pool_value;)
+                {
+                    auto&      slot     = _slot_at(block_index(head));
+                    const auto new_head = compose_index_and_tag(
+                        slot.next.load(std::memory_order::relaxed), aba_tag(head) + 1);
+                    if (_head.compare_exchange_weak(head, new_head,
+                            std::memory_order::acquire, std::memory_order::acquire))
+                        return reinterpret_cast<T*>(&slot.storage);
+                    // else the new head value gets loaded by CAS instruction
+                }
+
+                if (!_grow())
+                    return nullptr;
+            }
+        }
+
+        /// @brief Releases storage previously returned by allocate().
+        void deallocate(T* DRAKO_RESTRICT p, [[maybe_unused]] std::size_t n = 1) noexcept
+        {
+            assert(n == 1); // we can only deallocate single objects
+            assert(p);
+
+            auto& slot = *reinterpret_cast<_slot*>(p);
+            assert(&_slot_at(slot.index) == &slot);
 
-        [[nodiscard]] constexpr std::size_t capacity() const noexcept;
+            slot.generation.fetch_add(1, std::memory_order::relaxed);
+            _push(slot.index, slot.index);
+        }
+
+        /// @brief Builds a handle that references an allocated object.
+        [[nodiscard]] Handle handle(const T* p) const noexcept
+        {
+            assert(p);
+            const auto& slot = *reinterpret_cast<const _slot*>(p);
+            return { slot.index, slot.generation.load(std::memory_order::relaxed) };
+        }
+
+        /// @brief Resolves a handle.
+        ///
+        /// @return Address of the object, or nullptr if the slot has been released since
+        ///         the creation of the handle.
+        ///
+        [[nodiscard]] T* get(Handle h) const noexcept
+        {
+            auto& slot = _slot_at(h.index);
+            return slot.generation.load(std::memory_order::relaxed) == h.generation
+                       ? reinterpret_cast<T*>(&slot.storage)
+                       : nullptr;
+        }
+
+        /// @brief Number of objects that can be allocated without reserving other chunks.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] std::size_t capacity() const noexcept
+        {
+            return _chunks_count.load(std::memory_order::relaxed) * _chunk_size;
+        }
 
     private:
-        std::unique_ptr<T> _pool;
+        static const auto empty_pool_value = std::numeric_limits<std::uint32_t>::max();
+
+        _slot_alloc       _alloc;
+        const std::size_t _chunk_size;
+
+        std::atomic<_slot*>      _chunks[max_chunks] = {}; // chunk directory, filled in order
+        std::atomic<std::size_t> _chunks_count       = 0;
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<std::uint64_t> _head = compose_index_and_tag(empty_pool_value, 0);
+
+        [[nodiscard]] static std::uint32_t block_index(std::uint64_t head) noexcept
+        {
+            return static_cast<std::uint32_t>(head);
+        }
+
+        [[nodiscard]] static std::uint32_t aba_tag(std::uint64_t head) noexcept
+        {
+            return static_cast<std::uint32_t>(head >> 32);
+        }
+
+        [[nodiscard]] static constexpr std::uint64_t compose_index_and_tag(std::uint32_t index, std::uint32_t tag) noexcept
+        {
+            return static_cast<std::uint64_t>(index) | (static_cast<std::uint64_t>(tag) << 32);
+        }
+
+        [[nodiscard]] _slot& _slot_at(std::uint32_t index) const noexcept
+        {
+            // chunks are published before any of their slots enter the free list
+            const auto chunk = _chunks[index / _chunk_size].load(std::memory_order::acquire);
+            assert(chunk != nullptr);
+            return chunk[index % _chunk_size];
+        }
+
+        // attaches a chain of linked slots to the free list
+        void _push(std::uint32_t first, std::uint32_t last) noexcept
+        {
+            auto& tail = _slot_at(last);
+            for (auto head = _head.load(std::memory_order::relaxed);;)
+            {
+                tail.next.store(block_index(head), std::memory_order::relaxed);
+                const auto new_head = compose_index_and_tag(first, aba_tag(head) + 1);
+                if (_head.compare_exchange_weak(head, new_head,
+                        std::memory_order::release, std::memory_order::relaxed))
+                    return;
+                // else the new head value gets loaded by CAS instruction
+            }
+        }
+
+        // reserves a new chunk, returns false if the directory is full
+        [[nodiscard]] bool _grow()
+        {
+            auto n = _chunks_count.load(std::memory_order::acquire);
+            if (n == max_chunks)
+                return false;
+
+            if (_chunks[n].load(std::memory_order::acquire) == nullptr)
+            {
+                const auto chunk = _al_traits::allocate(_alloc, _chunk_size);
+                for (std::size_t i = 0; i < _chunk_size; ++i)
+                {
+                    const auto index = static_cast<std::uint32_t>(n * _chunk_size + i);
+                    _al_traits::construct(_alloc, chunk + i);
+                    chunk[i].index = index;
+                    chunk[i].next.store(index + 1, std::memory_order::relaxed);
+                }
+
+                _slot* expected = nullptr;
+                if (_chunks[n].compare_exchange_strong(expected, chunk,
+                        std::memory_order::acq_rel, std::memory_order::acquire))
+                {
+                    const auto first = static_cast<std::uint32_t>(n * _chunk_size);
+                    _push(first, static_cast<std::uint32_t>(first + _chunk_size - 1));
+                }
+                else // another thread reserved the chunk first
+                    _release(chunk);
+            }
+
+            // help the thread that reserved the chunk to publish it
+            _chunks_count.compare_exchange_strong(n, n + 1, std::memory_order::acq_rel);
+            return true;
+        }
+
+        void _release(_slot* chunk) noexcept
+        {
+            for (std::size_t i = 0; i < _chunk_size; ++i)
+                _al_traits::destroy(_alloc, chunk + i);
+            _al_traits::deallocate(_alloc, chunk, _chunk_size);
+        }
     };
 
 } // namespace drako::lockfree
@@ -5,75 +5,253 @@
 /// @file
 /// @brief   Thread-safe priority queue templates.
 /// @author  Grassi Edoardo
-/// @date    Last edited on 15/05/2019
 
-#include "drako/concurrency/lockfree_pool_allocator.hpp"
+#include "drako/concurrency/event_count.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
 #include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace drako::lockfree
 {
-    template <typename T, typename TPriority>
-    class PriorityQueue final
+    /// @brief Relaxed concurrent priority queue based on the MultiQueue design.
+    ///
+    /// Elements are spread over several sequential heaps, each guarded by a try-lock:
+    /// push inserts in a random heap, pop removes the best element among two random heaps.
+    /// A thread never waits on a busy heap, it just picks another one. Pop order
+    /// approximates the priority order with a rank error that grows with the number of heaps.
+    ///
+    /// @tparam T       Type of the stored objects.
+    /// @tparam P       Type of the priority, elements with lower priority are popped first.
+    /// @tparam Compare Ordering of priorities.
+    ///
+    template <typename T, typename P, typename Compare = std::less<P>> // clang-format off
+    requires std::is_trivially_copyable_v<P> && std::atomic<P>::is_always_lock_free
+    class PriorityQueue final // clang-format on
     {
     public:
-        [[nodiscard]] bool enque(const T& in, const TPriority p) noexcept
+        using value_type    = T;
+        using priority_type = P;
+
+        /// @brief Constructor.
+        ///
+        /// @param[in] queues   Number of internal heaps, usually twice the number of threads.
+        /// @param[in] reserved Number of elements reserved in advance for each heap.
+        ///
+        explicit PriorityQueue(std::size_t queues, std::size_t reserved = 0)
+            : _heaps{ std::make_unique<_heap[]>(queues) }
+            , _heaps_count{ queues }
         {
-            queue_node* new_node = _pool.construct(in, p);
-            if (new_node == nullptr)
-            {
-                return false;
-            }
-            for (;;)
+            assert(queues > 0);
+            for (std::size_t i = 0; i < queues; ++i)
+                _heaps[i].items.reserve(reserved);
+        }
+
+        PriorityQueue(const PriorityQueue&) = delete;
+        PriorityQueue& operator=(const PriorityQueue&) = delete;
+
+        /// @brief Inserts an element.
+        void push(const P& priority, const T& value)
+        {
+            for (auto i = _random(); ; i = _random())
             {
-                auto old_node  = _index[p].load();
-                new_node->next = old_node->next.load();
-                if (_index[p].compare_exchange_strong(old_node, new_node))
+                auto& h = _heaps[i];
+                if (!h.try_lock())
+                    continue;
+
+                try
+                {
+                    h.items.emplace_back(priority, value);
+                }
+                catch (...)
                 {
-                    return true;
+                    h.unlock();
+                    throw;
                 }
+                std::push_heap(std::begin(h.items), std::end(h.items), _heap_compare{});
+                h.publish();
+                h.unlock();
+                _size.fetch_add(1, std::memory_order::relaxed);
+                _not_empty.notify_one();
+                return;
             }
         }
 
-        [[nodiscard]] bool deque(T& out) noexcept
+        /// @brief Removes an element with approximately minimum priority.
+        ///
+        /// @return True if an element was removed, false if the queue is empty.
+        ///
+        [[nodiscard]] bool try_pop_min(T& value)
         {
-            for (queue_node* old_head;;)
+            return try_pop_min_bulk(std::span{ &value, 1 }) == 1;
+        }
+
+        /// @brief Removes a batch of elements with approximately minimum priority.
+        ///
+        /// Elements are taken from the locked heap as long as they are not worse
+        /// than the best element of the other candidate heap.
+        ///
+        /// @return Number of elements removed, stored in a prefix of the destination.
+        ///
+        [[nodiscard]] std::size_t try_pop_min_bulk(std::span<T> values)
+        {
+            std::size_t count = 0;
+            while (count < std::size(values) && _size.load(std::memory_order::relaxed) > 0)
             {
-                old_head = head_node.load();
-                if (old_head == nullptr)
+                // compare the cached top of two random heaps
+                auto a = _random(), b = _random();
+                if (_better(b, a))
+                    std::swap(a, b);
+
+                if (_heaps[a].empty.load(std::memory_order::relaxed))
                 {
-                    return false;
+                    if (const auto i = _any_non_empty(); i.has_value())
+                        a = *i;
+                    else
+                        break; // all heaps appear empty
                 }
-                else
+
+                auto& h = _heaps[a];
+                if (!h.try_lock())
+                    continue;
+
+                const auto& other = _heaps[b];
+                const auto  bounded = !other.empty.load(std::memory_order::relaxed);
+                const auto  limit   = other.top.load(std::memory_order::relaxed);
+                const auto  first   = count;
+                while (!std::empty(h.items) && count < std::size(values)
+                       && (count == first || !bounded || !Compare{}(limit, h.items.front().first)))
                 {
-                    auto old_priority = old_head->priority;
-                    index[old_priority].compare_exchange_strong(old_head, nullptr);
-                    if (head_node.compare_exchange_strong(old_head, old_head->next))
-                    {
-                        out = old_head->value;
-                        return true;
-                    }
+                    std::pop_heap(std::begin(h.items), std::end(h.items), _heap_compare{});
+                    values[count++] = std::move(h.items.back().second);
+                    h.items.pop_back();
                 }
+                h.publish();
+                h.unlock();
+                _size.fetch_sub(count - first, std::memory_order::relaxed);
             }
+            return count;
+        }
+
+        /// @brief Removes a batch of elements, waiting while the queue is empty.
+        ///
+        /// The consumer spins for a short time, then parks until a producer pushes new elements.
+        ///
+        /// @param[in] stop Condition that interrupts the wait, see wake_consumers().
+        ///
+        /// @return Number of elements removed, zero if the wait was interrupted.
+        ///
+        template <typename Stop>
+        [[nodiscard]] std::size_t pop_min_bulk_wait(std::span<T> values, Stop stop)
+        {
+            std::size_t count = 0;
+            _not_empty.await([&]() { return (count = try_pop_min_bulk(values)) > 0 || stop(); });
+            return count;
+        }
+
+        /// @brief Wakes up all the parked consumers so that they can evaluate again their stop condition.
+        void wake_consumers() noexcept { _not_empty.notify_all(); }
+
+        /// @brief Approximate number of elements in the queue.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            const auto s = _size.load(std::memory_order::relaxed);
+            return s > 0 ? static_cast<std::size_t>(s) : 0;
         }
 
+        /// @brief Checks whether the queue is empty.
+        ///
+        /// @warning The value may be stale as soon as it is returned.
+        ///
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
     private:
-        struct queue_node final
+        struct _heap_compare
         {
-            const T                  value;
-            const TPriority          priority;
-            std::atomic<queue_node*> next = nullptr;
+            // std heaps keep the max element on top, so the ordering is reversed
+            [[nodiscard]] bool operator()(const std::pair<P, T>& a, const std::pair<P, T>& b) const
+            {
+                return Compare{}(b.first, a.first);
+            }
+        };
+
+        struct alignas(std::hardware_destructive_interference_size) _heap
+        {
+            std::atomic_flag          locked; // since c++20 is initialized to clear state
+            std::atomic<bool>         empty = true;
+            std::atomic<P>            top   = P{}; // cached priority of the top element
+            std::vector<std::pair<P, T>> items;
+
+            [[nodiscard]] bool try_lock() noexcept
+            {
+                return !locked.test(std::memory_order::relaxed)
+                       && !locked.test_and_set(std::memory_order::acquire);
+            }
+
+            void unlock() noexcept { locked.clear(std::memory_order::release); }
 
-            explicit queue_node(const T& value, const TPriority priority) noexcept
-                : value(value), priority(priority)
-            {}
+            // updates the cached top, must hold the lock
+            void publish() noexcept
+            {
+                if (!std::empty(items))
+                    top.store(items.front().first, std::memory_order::relaxed);
+                empty.store(std::empty(items), std::memory_order::relaxed);
+            }
         };
 
-        lockfree::StaticPool<T>  _pool;
-        std::atomic<queue_node*> _index[10];
-        std::atomic<queue_node*> _head_node = nullptr;
+        std::unique_ptr<_heap[]> _heaps;
+        const std::size_t        _heaps_count;
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<std::ptrdiff_t> _size = 0; // can be transiently negative
+
+        EventCount _not_empty; // parks consumers while the queue is empty
+
+        [[nodiscard]] std::size_t _random() const noexcept
+        {
+            // xorshift generator, state is private to each thread
+            thread_local std::uint64_t state = reinterpret_cast<std::uintptr_t>(&state) | 1;
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return static_cast<std::size_t>(state % _heaps_count);
+        }
+
+        // checks whether heap a holds a better element than heap b
+        [[nodiscard]] bool _better(std::size_t a, std::size_t b) const noexcept
+        {
+            const auto& ha = _heaps[a];
+            const auto& hb = _heaps[b];
+            if (ha.empty.load(std::memory_order::relaxed))
+                return false;
+            if (hb.empty.load(std::memory_order::relaxed))
+                return true;
+            return Compare{}(ha.top.load(std::memory_order::relaxed), hb.top.load(std::memory_order::relaxed));
+        }
+
+        // linear scan used when the sampled heaps are empty
+        [[nodiscard]] std::optional<std::size_t> _any_non_empty() const noexcept
+        {
+            for (std::size_t i = 0; i < _heaps_count; ++i)
+                if (!_heaps[i].empty.load(std::memory_order::relaxed))
+                    return i;
+            return std::nullopt;
+        }
     };
+
 } // namespace drako::lockfree
 
 #endif // !DRAKO_LOCKFREE_PRIORITY_QUEUE
@@ -7,12 +7,16 @@
 #ifndef DRAKO_LOCKFREE_RINGBUFFER_HPP
 #define DRAKO_LOCKFREE_RINGBUFFER_HPP
 
+#include "drako/concurrency/event_count.hpp"
+
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <iterator>
 #include <memory> // std::allocator_traits
 #include <new>
 #include <optional>
+#include <span>
 
 namespace drako::lockfree
 {
@@ -95,14 +99,12 @@ namespace drako::lockfree
             : _alloc{ alloc }
             , _size{ size + 1 } // needed to resolve the ambiguity of full/empty buffer
             , _data{ _al_traits::allocate(_alloc, _size) }
-            , _reader{ .used_slots = 0 }
-            , _writer{ .free_slots = _size - 1 }
         {
             assert(size > 0);
             assert(_reader.head_index == 0);
             assert(_writer.tail_index == 0);
-            assert(_reader.used_slots == 0);
-            assert(_writer.free_slots == size);
+            assert(_reader.cached_tail == 0);
+            assert(_writer.cached_head == 0);
         }
 
         /*
@@ -155,24 +157,60 @@ namespace drako::lockfree
         ///
         bool enque(const T& value) noexcept requires std::is_copy_constructible_v<T>
         {
-            const auto tail = _writer.tail_index.load();
-            if (_writer.free_slots == 0) // there is no space, synchronize cache
+            const auto tail = _writer.tail_index.load(std::memory_order::relaxed);
+            const auto next = _queue_next_slot_index(tail);
+            if (next == _writer.cached_head) // there is no space, synchronize cache
             {
-                const auto head    = _reader.head_index.load();
-                _writer.free_slots = _queue_free_slots_count(head, tail);
-                if (_writer.free_slots == 0) // still no space
+                _writer.cached_head = _reader.head_index.load(std::memory_order::acquire);
+                if (next == _writer.cached_head) // still no space
                     return false;
             }
-            assert(_writer.free_slots > 0);
 
             _al_traits::construct(_alloc, _data + tail, value);
 
             // commit transaction
-            _writer.tail_index.store(_queue_next_slot_index(tail));
-            --_writer.free_slots;
+            _writer.tail_index.store(next, std::memory_order::release);
+            _not_empty.notify_one();
             return true;
         }
 
+        /// @brief Inserts a batch of elements in the queue.
+        ///
+        /// All the inserted elements are published to the reader at once.
+        ///
+        /// @param[in] values Source values.
+        ///
+        /// @return The number of values successfully inserted,
+        ///         always a prefix of the source values.
+        ///
+        /// @note Thread-safe and wait-free for concurrent execution
+        ///       with a single reader thread.
+        ///
+        [[nodiscard]] std::size_t enque_bulk(std::span<const T> values) noexcept
+            requires std::is_copy_constructible_v<T>
+        {
+            const auto tail  = _writer.tail_index.load(std::memory_order::relaxed);
+            auto       space = _queue_free_slots_count(_writer.cached_head, tail);
+            if (space < std::size(values)) // not enough space, synchronize cache
+            {
+                _writer.cached_head = _reader.head_index.load(std::memory_order::acquire);
+                space               = _queue_free_slots_count(_writer.cached_head, tail);
+            }
+
+            const auto count = std::min(space, std::size(values));
+            auto       index = tail;
+            for (std::size_t i = 0; i < count; ++i, index = _queue_next_slot_index(index))
+                _al_traits::construct(_alloc, _data + index, values[i]);
+
+            // commit transaction
+            if (count > 0)
+            {
+                _writer.tail_index.store(index, std::memory_order::release);
+                _not_empty.notify_one();
+            }
+            return count;
+        }
+
 
         /// @brief Inserts a batch of elements in the queue.
         /// @tparam    It    Input iterator type.
@@ -192,7 +230,22 @@ namespace drako::lockfree
             requires std::input_iterator<It>&& std::is_copy_constructible_v<T>
 #endif
         {
-            return 0;
+            const auto tail     = _writer.tail_index.load(std::memory_order::relaxed);
+            _writer.cached_head = _reader.head_index.load(std::memory_order::acquire);
+
+            const auto  space = _queue_free_slots_count(_writer.cached_head, tail);
+            auto        index = tail;
+            std::size_t count = 0;
+            for (; first != last && count < space; ++first, ++count, index = _queue_next_slot_index(index))
+                _al_traits::construct(_alloc, _data + index, *first);
+
+            // commit transaction
+            if (count > 0)
+            {
+                _writer.tail_index.store(index, std::memory_order::release);
+                _not_empty.notify_one();
+            }
+            return count;
         }
 
         /*
@@ -265,25 +318,58 @@ namespace drako::lockfree
         ///
         [[nodiscard]] bool deque(T& value) noexcept
         {
-            const auto head = _reader.head_index.load();
-            if (_reader.used_slots == 0)
+            const auto head = _reader.head_index.load(std::memory_order::relaxed);
+            if (head == _reader.cached_tail) // there are no items, synchronize cache
             {
-                const auto tail    = _writer.tail_index.load();
-                _reader.used_slots = _queue_used_slots_count(head, tail);
-                if (_reader.used_slots == 0)
+                _reader.cached_tail = _writer.tail_index.load(std::memory_order::acquire);
+                if (head == _reader.cached_tail) // still no items
                     return false;
             }
-            assert(_reader.used_slots > 0);
 
             value = std::move(_data[head]);
             _al_traits::destroy(_alloc, _data + head);
 
             // commit transaction
-            _reader.head_index.store(_queue_next_slot_index(head));
-            --_reader.used_slots;
+            _reader.head_index.store(_queue_next_slot_index(head), std::memory_order::release);
             return true;
         }
 
+        /// @brief Removes a batch of elements from the queue.
+        ///
+        /// All the removed slots are released to the writer at once.
+        ///
+        /// @param[out] values Destination for the elements to remove.
+        ///
+        /// @return The number of values successfully removed,
+        ///         always stored in a prefix of the destination.
+        ///
+        /// @note Thread-safe and wait-free for concurrent execution
+        ///       with a single writer thread.
+        ///
+        [[nodiscard]] std::size_t deque_bulk(std::span<T> values) noexcept
+        {
+            const auto head  = _reader.head_index.load(std::memory_order::relaxed);
+            auto       items = _queue_used_slots_count(head, _reader.cached_tail);
+            if (items < std::size(values)) // not enough items, synchronize cache
+            {
+                _reader.cached_tail = _writer.tail_index.load(std::memory_order::acquire);
+                items               = _queue_used_slots_count(head, _reader.cached_tail);
+            }
+
+            const auto count = std::min(items, std::size(values));
+            auto       index = head;
+            for (std::size_t i = 0; i < count; ++i, index = _queue_next_slot_index(index))
+            {
+                values[i] = std::move(_data[index]);
+                _al_traits::destroy(_alloc, _data + index);
+            }
+
+            // commit transaction
+            if (count > 0)
+                _reader.head_index.store(index, std::memory_order::release);
+            return count;
+        }
+
 
 
         /// @brief Removes a batch of elements from the queue.
@@ -304,9 +390,64 @@ namespace drako::lockfree
             requires std::output_iterator<It, T>&& std::is_copy_constructible_v<T>
 #endif
         {
-            return 0;
+            const auto head     = _reader.head_index.load(std::memory_order::relaxed);
+            _reader.cached_tail = _writer.tail_index.load(std::memory_order::acquire);
+
+            const auto  items = _queue_used_slots_count(head, _reader.cached_tail);
+            auto        index = head;
+            std::size_t count = 0;
+            for (; first != last && count < items; ++first, ++count, index = _queue_next_slot_index(index))
+            {
+                *first = std::move(_data[index]);
+                _al_traits::destroy(_alloc, _data + index);
+            }
+
+            // commit transaction
+            if (count > 0)
+                _reader.head_index.store(index, std::memory_order::release);
+            return count;
+        }
+
+
+
+        /// @brief Removes an element from the queue, waiting while the queue is empty.
+        ///
+        /// The reader spins for a short time, then parks until the writer publishes new elements.
+        ///
+        /// @param[out] value Destination for the element to remove.
+        /// @param[in]  stop  Condition that interrupts the wait, see wake_reader().
+        ///
+        /// @return True if an item has been removed, false if the wait was interrupted.
+        ///
+        /// @note Thread-safe for concurrent execution with a single writer thread.
+        ///
+        template <typename Stop>
+        [[nodiscard]] bool deque_wait(T& value, Stop stop)
+        {
+            bool removed = false;
+            _not_empty.await([&]() { return (removed = deque(value)) || stop(); });
+            return removed;
         }
 
+        /// @brief Removes a batch of elements from the queue, waiting while the queue is empty.
+        ///
+        /// @param[out] values Destination for the elements to remove.
+        /// @param[in]  stop   Condition that interrupts the wait, see wake_reader().
+        ///
+        /// @return The number of values removed, zero if the wait was interrupted.
+        ///
+        /// @note Thread-safe for concurrent execution with a single writer thread.
+        ///
+        template <typename Stop>
+        [[nodiscard]] std::size_t deque_bulk_wait(std::span<T> values, Stop stop)
+        {
+            std::size_t count = 0;
+            _not_empty.await([&]() { return (count = deque_bulk(values)) > 0 || stop(); });
+            return count;
+        }
+
+        /// @brief Wakes up the reader so that it can evaluate again its stop condition.
+        void wake_reader() noexcept { _not_empty.notify_all(); }
 
 
         /// @brief Checks whether the queue is empty.
@@ -317,7 +458,7 @@ namespace drako::lockfree
         ///
         [[nodiscard]] constexpr bool empty() const noexcept
         {
-            return _reader.head.load() == _writer.tail.load();
+            return _reader.head_index.load() == _writer.tail_index.load();
         }
 
         /// @brief Number of element in the queue.
@@ -346,14 +487,14 @@ namespace drako::lockfree
     private:
         struct _reader_cached_state
         {
-            std::atomic<std::size_t> head_index = 0; // index of the most recently read item
-            std::size_t              used_slots;     // number of occupied slots in the queue
+            std::atomic<std::size_t> head_index  = 0; // index of the next item to read
+            std::size_t              cached_tail = 0; // last observed value of the writer index
         };
 
         struct _writer_cached_state
         {
-            std::atomic<std::size_t> tail_index = 0; // index of the most recently written item
-            std::size_t              free_slots;     // number of free slots in the queue
+            std::atomic<std::size_t> tail_index  = 0; // index of the next slot to write
+            std::size_t              cached_head = 0; // last observed value of the reader index
         };
 
 
@@ -369,6 +510,9 @@ namespace drako::lockfree
         alignas(std::hardware_destructive_interference_size)
             _writer_cached_state _writer;
 
+        alignas(std::hardware_destructive_interference_size)
+            EventCount _not_empty; // parks the reader while the queue is empty
+
 
         [[nodiscard]] constexpr auto _queue_next_slot_index(
             std::size_t index) const noexcept
@@ -0,0 +1,427 @@
+#pragma once
+#ifndef DRAKO_MEMORY_RECLAMATION_HPP
+#define DRAKO_MEMORY_RECLAMATION_HPP
+
+/// @file
+/// @brief  Safe memory reclamation schemes for lock-free containers.
+/// @author Grassi Edoardo
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace drako::lockfree
+{
+    /// @brief Epoch based memory reclamation.
+    ///
+    /// Threads pin the domain for the duration of an operation on a container;
+    /// nodes unlinked from the container are retired and then freed in batches
+    /// once every thread that was pinned when they were retired has unpinned.
+    ///
+    class EpochDomain
+    {
+    public:
+        /// @brief Function that frees a retired object.
+        using deleter_type = void (*)(void* p, void* context) noexcept;
+
+        /// @brief Scope of a pinned thread, retired nodes can't be freed while it's alive.
+        class Guard
+        {
+        public:
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            ~Guard() noexcept { _domain._unpin(_record); }
+
+        private:
+            friend class EpochDomain;
+
+            explicit Guard(EpochDomain& d, std::size_t r) noexcept
+                : _domain{ d }, _record{ r } {}
+
+            EpochDomain&      _domain;
+            const std::size_t _record;
+        };
+
+        /// @brief Constructs a reclamation domain.
+        ///
+        /// @param[in] max_threads Max number of threads that can be pinned at the same time.
+        /// @param[in] batch_size  Number of retired nodes that triggers a reclamation pass.
+        ///
+        explicit EpochDomain(std::size_t max_threads = 64, std::size_t batch_size = 64)
+            : _records{ std::make_unique<_record[]>(max_threads) }
+            , _records_count{ max_threads }
+            , _batch_size{ batch_size }
+        {
+            assert(max_threads > 0);
+            assert(batch_size > 0);
+
+            // room for a batch and for the nodes that a collection can't free yet
+            for (std::size_t i = 0; i < max_threads; ++i)
+                _records[i].retired.reserve(2 * batch_size);
+        }
+
+        /// @brief Frees all the retired nodes.
+        ///
+        /// @warning No thread can be pinned when the domain is destroyed.
+        ///
+        ~EpochDomain() noexcept
+        {
+            for (std::size_t i = 0; i < _records_count; ++i)
+            {
+                assert(!_records[i].in_use.load());
+                for (const auto& r : _records[i].retired)
+                    r.deleter(r.p, r.context);
+            }
+        }
+
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        /// @brief Domain shared by the whole process.
+        [[nodiscard]] static EpochDomain& global()
+        {
+            static EpochDomain domain{};
+            return domain;
+        }
+
+        /// @brief Pins the current thread, protecting the nodes it reads from reclamation.
+        [[nodiscard]] Guard pin() noexcept { return Guard{ *this, _pin() }; }
+
+        /// @brief Retires a node that has been unlinked from a container.
+        ///
+        /// @param[in] g       Guard of the calling thread.
+        /// @param[in] p       Node to free, allocated with new.
+        ///
+        template <typename T>
+        void retire(const Guard& g, T* p) noexcept
+        {
+            retire(g, p, [](void* p, void*) noexcept { delete static_cast<T*>(p); }, nullptr);
+        }
+
+        /// @brief Retires a node that has been unlinked from a container.
+        ///
+        /// @param[in] g       Guard of the calling thread.
+        /// @param[in] p       Node to free.
+        /// @param[in] deleter Function that frees the node.
+        /// @param[in] context Additional argument for the deleter.
+        ///
+        /// @note A stalled thread prevents reclamation, so the list of retired nodes can
+        ///       outgrow its reserved capacity. If it can't grow, the node is never freed.
+        ///
+        void retire(const Guard& g, void* p, deleter_type deleter, void* context) noexcept
+        {
+            assert(&g._domain == this);
+            assert(p);
+            assert(deleter);
+
+            auto& record = _records[g._record];
+            if (std::size(record.retired) == record.retired.capacity())
+            {
+                _collect(record);
+                if (std::size(record.retired) == record.retired.capacity())
+                {
+                    try
+                    {
+                        record.retired.reserve(2 * record.retired.capacity());
+                    }
+                    catch (const std::bad_alloc&)
+                    {
+                        return; // leaked, freeing it while it may be referenced isn't safe
+                    }
+                }
+            }
+
+            // the stamp must not be older than the epoch of any thread that can still
+            // reach the node, so it's read after the unlink is globally visible
+            std::atomic_thread_fence(std::memory_order::seq_cst);
+            record.retired.push_back({ p, deleter, context, _epoch.load(std::memory_order::relaxed) });
+            if (std::size(record.retired) >= _batch_size)
+                _collect(record);
+        }
+
+    private:
+        struct _retired
+        {
+            void*         p;
+            deleter_type  deleter;
+            void*         context;
+            std::uint64_t epoch; // global epoch observed when the node was retired
+        };
+
+        struct alignas(std::hardware_destructive_interference_size) _record
+        {
+            std::atomic<bool>          in_use = false;
+            std::atomic<std::uint64_t> state  = 0; // (local epoch << 1) | pinned
+            std::vector<_retired>      retired;    // accessed only by the owner of the record
+        };
+
+        std::unique_ptr<_record[]> _records;
+        const std::size_t          _records_count;
+        const std::size_t          _batch_size;
+
+        alignas(std::hardware_destructive_interference_size)
+            std::atomic<std::uint64_t> _epoch = 0;
+
+        inline static thread_local std::size_t _hint = 0; // last record used by this thread
+
+        [[nodiscard]] std::size_t _pin() noexcept
+        {
+            // claim a free record, starting from the one used last time
+            for (auto i = _hint % _records_count;; i = (i + 1) % _records_count)
+            {
+                auto& r = _records[i];
+                if (!r.in_use.load(std::memory_order::relaxed)
+                    && !r.in_use.exchange(true, std::memory_order::acquire))
+                {
+                    _hint = i;
+
+                    // announce the epoch, retry if it moved before the announcement was visible
+                    for (auto e = _epoch.load(std::memory_order::seq_cst);;)
+                    {
+                        r.state.store((e << 1) | 1, std::memory_order::seq_cst);
+                        if (const auto now = _epoch.load(std::memory_order::seq_cst); now == e)
+                            return i;
+                        else
+                            e = now;
+                    }
+                }
+                if (i + 1 == _records_count) // every record is in use
+                    std::this_thread::yield();
+            }
+        }
+
+        void _unpin(std::size_t i) noexcept
+        {
+            auto& r = _records[i];
+            r.state.store(r.state.load(std::memory_order::relaxed) & ~std::uint64_t{ 1 },
+                std::memory_order::release);
+            r.in_use.store(false, std::memory_order::release);
+        }
+
+        void _collect(_record& owner) noexcept
+        {
+            // the epoch can advance only when all pinned threads have observed the current one
+            auto       e       = _epoch.load(std::memory_order::seq_cst);
+            const auto blocked = std::any_of(_records.get(), _records.get() + _records_count,
+                [e](const _record& r) {
+                    const auto s = r.state.load(std::memory_order::seq_cst);
+                    return (s & 1) && (s >> 1) != e;
+                });
+            if (!blocked)
+                _epoch.compare_exchange_strong(e, e + 1, std::memory_order::seq_cst);
+
+            // nodes retired two epochs ago can't be referenced by any thread
+            const auto now = _epoch.load(std::memory_order::seq_cst);
+            const auto end = std::partition(std::begin(owner.retired), std::end(owner.retired),
+                [now](const _retired& r) { return r.epoch + 2 > now; });
+            for (auto it = end; it != std::end(owner.retired); ++it)
+                it->deleter(it->p, it->context);
+            owner.retired.erase(end, std::end(owner.retired));
+        }
+    };
+
+
+    /// @brief Hazard pointers based memory reclamation.
+    ///
+    /// Threads publish the nodes they are about to access; a retired node is freed
+    /// only when no published hazard pointer references it. Compared to epochs,
+    /// a stalled thread can hold back only the nodes it actually protects.
+    ///
+    class HazardDomain
+    {
+    public:
+        /// @brief Function that frees a retired object.
+        using deleter_type = void (*)(void* p, void* context) noexcept;
+
+        /// @brief Number of hazard pointers available to each thread.
+        static constexpr const std::size_t slots_per_thread = 4;
+
+        /// @brief Set of hazard pointers owned by the current thread.
+        class Guard
+        {
+        public:
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            ~Guard() noexcept { _domain._release(_record); }
+
+            /// @brief Loads a pointer and protects it from reclamation.
+            ///
+            /// @param[in] slot Index of the hazard pointer to use.
+            /// @param[in] src  Shared location that holds the pointer.
+            ///
+            template <typename T>
+            [[nodiscard]] T* protect(std::size_t slot, const std::atomic<T*>& src) noexcept
+            {
+                assert(slot < slots_per_thread);
+                auto& hp = _domain._records[_record].hazards[slot];
+                for (auto p = src.load(std::memory_order::relaxed);;)
+                {
+                    hp.store(p, std::memory_order::seq_cst);
+                    // validate that the node wasn't unlinked before being published
+                    if (const auto q = src.load(std::memory_order::seq_cst); q == p)
+                        return p;
+                    else
+                        p = q;
+                }
+            }
+
+            /// @brief Stops protecting the pointer held by a slot.
+            void reset(std::size_t slot) noexcept
+            {
+                assert(slot < slots_per_thread);
+                _domain._records[_record].hazards[slot].store(nullptr, std::memory_order::release);
+            }
+
+        private:
+            friend class HazardDomain;
+
+            explicit Guard(HazardDomain& d, std::size_t r) noexcept
+                : _domain{ d }, _record{ r } {}
+
+            HazardDomain&     _domain;
+            const std::size_t _record;
+        };
+
+        /// @brief Constructs a reclamation domain.
+        ///
+        /// @param[in] max_threads Max number of threads that can hold a guard at the same time.
+        /// @param[in] batch_size  Number of retired nodes that triggers a reclamation pass.
+        ///
+        explicit HazardDomain(std::size_t max_threads = 64, std::size_t batch_size = 64)
+            : _records{ std::make_unique<_record[]>(max_threads) }
+            , _records_count{ max_threads }
+            , _batch_size{ batch_size }
+        {
+            assert(max_threads > 0);
+            assert(batch_size > 0);
+
+            // a scan leaves at most one retired node for each hazard pointer,
+            // so reserving up front makes retire() allocation free
+            const auto hazards = max_threads * slots_per_thread;
+            for (std::size_t i = 0; i < max_threads; ++i)
+            {
+                _records[i].retired.reserve(std::max(batch_size, hazards + 1));
+                _records[i].snapshot = std::make_unique_for_overwrite<void*[]>(hazards);
+            }
+        }
+
+        /// @brief Frees all the retired nodes.
+        ///
+        /// @warning No thread can hold a guard when the domain is destroyed.
+        ///
+        ~HazardDomain() noexcept
+        {
+            for (std::size_t i = 0; i < _records_count; ++i)
+            {
+                assert(!_records[i].in_use.load());
+                for (const auto& r : _records[i].retired)
+                    r.deleter(r.p, r.context);
+            }
+        }
+
+        HazardDomain(const HazardDomain&) = delete;
+        HazardDomain& operator=(const HazardDomain&) = delete;
+
+        /// @brief Acquires the hazard pointers for the current thread.
+        [[nodiscard]] Guard acquire() noexcept { return Guard{ *this, _acquire() }; }
+
+        /// @brief Retires a node that has been unlinked from a container.
+        template <typename T>
+        void retire(const Guard& g, T* p) noexcept
+        {
+            retire(g, p, [](void* p, void*) noexcept { delete static_cast<T*>(p); }, nullptr);
+        }
+
+        /// @brief Retires a node that has been unlinked from a container.
+        void retire(const Guard& g, void* p, deleter_type deleter, void* context) noexcept
+        {
+            assert(&g._domain == this);
+            assert(p);
+            assert(deleter);
+
+            auto& record = _records[g._record];
+            assert(std::size(record.retired) < record.retired.capacity());
+            record.retired.push_back({ p, deleter, context });
+            if (std::size(record.retired) >= _batch_size)
+                _scan(record);
+        }
+
+    private:
+        struct _retired
+        {
+            void*        p;
+            deleter_type deleter;
+            void*        context;
+        };
+
+        struct alignas(std::hardware_destructive_interference_size) _record
+        {
+            std::atomic<bool>  in_use = false;
+            std::atomic<void*> hazards[slots_per_thread]{};
+
+            // accessed only by the owner of the record
+            std::vector<_retired>    retired;
+            std::unique_ptr<void*[]> snapshot; // published hazard pointers, one for each slot of the domain
+        };
+
+        std::unique_ptr<_record[]> _records;
+        const std::size_t          _records_count;
+        const std::size_t          _batch_size;
+
+        inline static thread_local std::size_t _hint = 0; // last record used by this thread
+
+        [[nodiscard]] std::size_t _acquire() noexcept
+        {
+            for (auto i = _hint % _records_count;; i = (i + 1) % _records_count)
+            {
+                auto& r = _records[i];
+                if (!r.in_use.load(std::memory_order::relaxed)
+                    && !r.in_use.exchange(true, std::memory_order::acquire))
+                {
+                    _hint = i;
+                    return i;
+                }
+                if (i + 1 == _records_count) // every record is in use
+                    std::this_thread::yield();
+            }
+        }
+
+        void _release(std::size_t i) noexcept
+        {
+            auto& r = _records[i];
+            for (auto& hp : r.hazards)
+                hp.store(nullptr, std::memory_order::release);
+            r.in_use.store(false, std::memory_order::release);
+        }
+
+        void _scan(_record& owner) noexcept
+        {
+            // snapshot of all the published hazard pointers
+            const auto  first = owner.snapshot.get();
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < _records_count; ++i)
+                for (const auto& hp : _records[i].hazards)
+                    if (const auto p = hp.load(std::memory_order::seq_cst); p != nullptr)
+                        first[count++] = p;
+            const auto last = first + count;
+            std::sort(first, last);
+
+            const auto end = std::partition(std::begin(owner.retired), std::end(owner.retired),
+                [&](const _retired& r) { return std::binary_search(first, last, r.p); });
+            for (auto it = end; it != std::end(owner.retired); ++it)
+                it->deleter(it->p, it->context);
+            owner.retired.erase(end, std::end(owner.retired));
+        }
+    };
+
+} // namespace drako::lockfree
+
+#endif // !DRAKO_MEMORY_RECLAMATION_HPP
@@ -2,15 +2,29 @@
 #ifndef DRAKO_THREAD_HPP
 #define DRAKO_THREAD_HPP
 
+#include <algorithm>
+#include <bitset>
 #include <cstdlib>
+#include <string>
+#include <string_view>
+#include <system_error>
 
-#include "drako/concurrency/thread_context.hpp"
 #include "drako/core/compiler.hpp"
 #include "drako/core/platform.hpp"
 #include "drako/system/system_info.hpp"
 
 #if defined(DRAKO_PLT_WIN32)
 #include <processthreadsapi.h>
+
+#elif defined(DRAKO_PLT_LINUX)
+#include <atomic>
+#include <cerrno>
+#include <memory>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
 #endif
 
 namespace drako::sys
@@ -19,27 +33,97 @@ namespace drako::sys
     class native_thread final
     {
     public:
-        using id_type       = std::size_t;
-        using priority_type = std::size_t;
-        using routine_type  = unsigned long(DRAKO_API_STDCALL)(void* args);
+        using id_type = std::size_t;
+
+#if defined(DRAKO_PLT_WIN32)
+        using routine_type = unsigned long(DRAKO_API_STDCALL)(void* args);
+#elif defined(DRAKO_PLT_LINUX)
+        using routine_type = void*(void* args);
+#endif
+
+        /// @brief Max number of logical processors that can appear in an affinity mask.
+        static constexpr const std::size_t max_cpu_count = 1024;
+
+        /// @brief Set of logical processors, indexed as native_cpu_core::cpu_number.
+        using affinity_mask = std::bitset<max_cpu_count>;
+
+        /// @brief Scheduling policy of a thread.
+        enum class scheduling
+        {
+            normal,  // time sharing, maps to SCHED_OTHER
+            realtime // strict priority, maps to SCHED_FIFO
+        };
+
+        struct priority_type
+        {
+            scheduling policy = scheduling::normal;
+
+            /// @brief Nice value in [-20, 19] for normal threads, lower runs first;
+            ///        priority in [1, 99] for realtime threads, higher runs first.
+            int level = 0;
+        };
+
+        struct Args
+        {
+            /// @brief Size of the stack as bytes, zero for the system default.
+            std::size_t stack_size = 0;
+
+            /// @brief Friendly name shown by debuggers and profilers.
+            std::string_view name = {};
+
+            /// @brief Argument forwarded to the routine.
+            void* args = nullptr;
+        };
 
 
         explicit native_thread(routine_type routine, size_t stack_size) noexcept
+            : native_thread{ routine, Args{ .stack_size = stack_size } }
+        {
+        }
+
+        /// @brief Creates a thread that starts immediately.
+        explicit native_thread(routine_type routine, const Args& args) noexcept
         {
 #if defined(DRAKO_PLT_WIN32)
             _handle = ::CreateThread(NULL, // [In] security attributes
-                stack_size,
+                args.stack_size,
                 routine,
-                nullptr,
+                args.args,
                 NULL,
                 &_id); // [Out] created thread id
             if (_handle == NULL)
             {
                 std::exit(EXIT_FAILURE);
             }
+
+#elif defined(DRAKO_PLT_LINUX)
+            pthread_attr_t attr;
+            if (::pthread_attr_init(&attr) != 0)
+                std::exit(EXIT_FAILURE);
+            if (args.stack_size != 0 && ::pthread_attr_setstacksize(&attr, args.stack_size) != 0)
+                std::exit(EXIT_FAILURE);
+
+            // the kernel id of the thread is needed to change its nice value
+            const auto start = new (std::nothrow) _startup{ .routine = routine, .args = args.args };
+            if (start == nullptr)
+                std::exit(EXIT_FAILURE);
+            if (::pthread_create(&_handle, &attr, &_start, start) != 0)
+                std::exit(EXIT_FAILURE);
+            ::pthread_attr_destroy(&attr);
+
+            start->tid.wait(0, std::memory_order::acquire);
+            _id       = static_cast<id_type>(start->tid.load(std::memory_order::relaxed));
+            _joinable = true;
+            _release(start);
+
 #else
 #error Platform not supported
 #endif
+            if (!std::empty(args.name))
+            {
+                std::error_code ec;
+                set_name(args.name, ec); // names are only a debugging aid
+            }
         }
 
         ~native_thread() noexcept
@@ -49,6 +133,12 @@ namespace drako::sys
             if (_handle != INVALID_HANDLE_VALUE)
                 ::CloseHandle(_handle);
 
+#elif defined(DRAKO_PLT_LINUX)
+
+            // like closing the handle on Windows, the thread keeps running
+            if (_joinable)
+                ::pthread_detach(_handle);
+
 #else
 #error Platform not supported
 #endif
@@ -65,6 +155,13 @@ namespace drako::sys
             _id           = other._id;
             other._handle = INVALID_HANDLE_VALUE;
 
+#elif defined(DRAKO_PLT_LINUX)
+
+            _handle         = other._handle;
+            _id             = other._id;
+            _joinable       = other._joinable;
+            other._joinable = false;
+
 #else
 #error Platform not supported
 #endif
@@ -77,20 +174,76 @@ namespace drako::sys
             _id           = other._id;
             other._handle = INVALID_HANDLE_VALUE;
 
+#elif defined(DRAKO_PLT_LINUX)
+
+            if (this != &other)
+            {
+                if (_joinable)
+                    ::pthread_detach(_handle);
+                _handle         = other._handle;
+                _id             = other._id;
+                _joinable       = other._joinable;
+                other._joinable = false;
+            }
+
 #else
 #error Platform not supported
 #endif
             return *this;
         }
 
-        void run(const thread_context&) noexcept;
+        /// @brief Waits for the termination of the thread.
+        void join() noexcept
+        {
+#if defined(DRAKO_PLT_WIN32)
+
+            ::WaitForSingleObject(_handle, INFINITE);
+
+#elif defined(DRAKO_PLT_LINUX)
+
+            if (_joinable)
+            {
+                ::pthread_join(_handle, nullptr);
+                _joinable = false;
+            }
+
+#else
+#error Platform not supported
+#endif
+        }
+
+        /// @brief Identifier of the thread assigned by the system.
+        [[nodiscard]] id_type id() const noexcept { return _id; }
+
 
-        [[nodiscard]] priority_type priority() const noexcept;
+        [[nodiscard]] priority_type priority() const;
+        [[nodiscard]] priority_type priority(std::error_code& ec) const noexcept;
 
-        void set_priority(const priority_type p) noexcept;
+        /// @brief Changes the scheduling policy and the priority of the thread.
+        ///
+        /// @note Realtime threads and negative nice values usually require elevated privileges.
+        ///
+        void set_priority(const priority_type p);
+        void set_priority(const priority_type p, std::error_code& ec) noexcept;
+
+        /// @brief Logical processors where the thread is allowed to run.
+        [[nodiscard]] affinity_mask affinity() const;
+        [[nodiscard]] affinity_mask affinity(std::error_code& ec) const noexcept;
+
+        /// @brief Restricts the thread to a set of logical processors.
+        void set_affinity(const affinity_mask& cpus);
+        void set_affinity(const affinity_mask& cpus, std::error_code& ec) noexcept;
+
+        /// @brief Changes the friendly name of the thread.
+        ///
+        /// @note Names longer than 15 characters are truncated on Linux.
+        ///
+        void set_name(std::string_view name);
+        void set_name(std::string_view name, std::error_code& ec) noexcept;
 
         [[nodiscard]] native_cpu_core core_affinity() noexcept;
 
+        /// @brief Pins the thread to a single logical processor.
         [[nodiscard]] bool core_affinity(native_cpu_core core) noexcept
         {
 #if defined(DRAKO_PLT_WIN32)
@@ -100,6 +253,14 @@ namespace drako::sys
             // p.Number =
             return ::SetThreadIdealProcessorEx(_handle, &(core.cpu_number), NULL);
 
+#elif defined(DRAKO_PLT_LINUX)
+
+            affinity_mask cpus;
+            cpus.set(core.cpu_number);
+            std::error_code ec;
+            set_affinity(cpus, ec);
+            return !ec;
+
 #else
 #error Platform not supported
 #endif
@@ -111,11 +272,258 @@ namespace drako::sys
         HANDLE _handle;
         DWORD  _id;
 
+#elif defined(DRAKO_PLT_LINUX)
+
+        // state shared with the new thread until it publishes its id
+        struct _startup
+        {
+            routine_type*     routine;
+            void*             args;
+            std::atomic<long> tid        = 0;
+            std::atomic<int>  references = 2; // creator and new thread
+        };
+
+        pthread_t _handle;
+        id_type   _id;
+        bool      _joinable = false;
+
+        // the creator can return from the wait before the notification has been sent,
+        // so the block is freed by whichever side is done with it last
+        static void _release(_startup* start) noexcept
+        {
+            if (start->references.fetch_sub(1, std::memory_order::acq_rel) == 1)
+                delete start;
+        }
+
+        static void* _start(void* p) noexcept
+        {
+            const auto start   = static_cast<_startup*>(p);
+            const auto routine = start->routine;
+            const auto args    = start->args;
+
+            start->tid.store(static_cast<long>(::gettid()), std::memory_order::release);
+            start->tid.notify_one();
+            _release(start);
+            return routine(args);
+        }
+
 #else
 #error Platform not supported
 #endif
     };
 
+
+#if defined(DRAKO_PLT_WIN32)
+
+    inline native_thread::priority_type native_thread::priority(std::error_code& ec) const noexcept
+    {
+        ec.clear();
+
+        const auto p = ::GetThreadPriority(_handle);
+        if (p == THREAD_PRIORITY_ERROR_RETURN)
+        {
+            ec.assign(::GetLastError(), std::system_category());
+            return {};
+        }
+        if (p == THREAD_PRIORITY_TIME_CRITICAL)
+            return { .policy = scheduling::realtime, .level = 99 };
+        return { .policy = scheduling::normal, .level = -p * 10 }; // back to the nice scale
+    }
+
+    inline void native_thread::set_priority(const priority_type p, std::error_code& ec) noexcept
+    {
+        ec.clear();
+
+        // Windows has only a few levels inside each priority class
+        const auto level = (p.policy == scheduling::realtime)
+                               ? THREAD_PRIORITY_TIME_CRITICAL
+                               : std::clamp(-p.level / 10, THREAD_PRIORITY_LOWEST, THREAD_PRIORITY_HIGHEST);
+        if (::SetThreadPriority(_handle, level) == 0)
+            ec.assign(::GetLastError(), std::system_category());
+    }
+
+    inline native_thread::affinity_mask native_thread::affinity(std::error_code& ec) const noexcept
+    {
+        ec.clear();
+
+        // there is no getter, the previous mask is returned by the setter
+        DWORD_PTR process, system;
+        if (::GetProcessAffinityMask(::GetCurrentProcess(), &process, &system) == 0)
+        {
+            ec.assign(::GetLastError(), std::system_category());
+            return {};
+        }
+        const auto previous = ::SetThreadAffinityMask(_handle, process);
+        if (previous == 0)
+        {
+            ec.assign(::GetLastError(), std::system_category());
+            return {};
+        }
+        ::SetThreadAffinityMask(_handle, previous);
+        return affinity_mask{ static_cast<unsigned long long>(previous) };
+    }
+
+    inline void native_thread::set_affinity(const affinity_mask& cpus, std::error_code& ec) noexcept
+    {
+        ec.clear();
+
+        // only the processors of the current group are addressable
+        const auto mask = static_cast<DWORD_PTR>((cpus & affinity_mask{ ~DWORD_PTR{ 0 } }).to_ullong());
+        if (::SetThreadAffinityMask(_handle, mask) == 0)
+            ec.assign(::GetLastError(), std::system_category());
+    }
+
+    inline void native_thread::set_name(std::string_view name, std::error_code& ec) noexcept
+    {
+        ec.clear();
+
+        const std::wstring wide(std::cbegin(name), std::cend(name)); // names are expected to be ASCII
+        if (const auto hr = ::SetThreadDescription(_handle, wide.c_str()); FAILED(hr))
+            ec.assign(hr, std::system_category());
+    }
+
+#elif defined(DRAKO_PLT_LINUX)
+
+    inline native_thread::priority_type native_thread::priority(std::error_code& ec) const noexcept
+    {
+        ec.clear();
+
+        int         policy;
+        sched_param param;
+        if (const auto e = ::pthread_getschedparam(_handle, &policy, &param); e != 0)
+        {
+            ec.assign(e, std::system_category());
+            return {};
+        }
+        if (policy == SCHED_FIFO || policy == SCHED_RR)
+            return { .policy = scheduling::realtime, .level = param.sched_priority };
+
+        // on Linux the nice value is a property of each thread
+        errno           = 0;
+        const auto nice = ::getpriority(PRIO_PROCESS, static_cast<id_t>(_id));
+        if (errno != 0)
+        {
+            ec.assign(errno, std::system_category());
+            return {};
+        }
+        return { .policy = scheduling::normal, .level = nice };
+    }
+
+    inline void native_thread::set_priority(const priority_type p, std::error_code& ec) noexcept
+    {
+        ec.clear();
+
+        if (p.policy == scheduling::realtime)
+        {
+            const sched_param param{ .sched_priority = p.level };
+            if (const auto e = ::pthread_setschedparam(_handle, SCHED_FIFO, &param); e != 0)
+                ec.assign(e, std::system_category());
+            return;
+        }
+
+        const sched_param param{ .sched_priority = 0 };
+        if (const auto e = ::pthread_setschedparam(_handle, SCHED_OTHER, &param); e != 0)
+            ec.assign(e, std::system_category());
+        else if (::setpriority(PRIO_PROCESS, static_cast<id_t>(_id), p.level) != 0)
+            ec.assign(errno, std::system_category());
+    }
+
+    inline native_thread::affinity_mask native_thread::affinity(std::error_code& ec) const noexcept
+    {
+        ec.clear();
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (const auto e = ::pthread_getaffinity_np(_handle, sizeof(set), &set); e != 0)
+        {
+            ec.assign(e, std::system_category());
+            return {};
+        }
+
+        affinity_mask cpus;
+        for (std::size_t i = 0; i < std::min<std::size_t>(CPU_SETSIZE, max_cpu_count); ++i)
+            if (CPU_ISSET(i, &set))
+                cpus.set(i);
+        return cpus;
+    }
+
+    inline void native_thread::set_affinity(const affinity_mask& cpus, std::error_code& ec) noexcept
+    {
+        ec.clear();
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (std::size_t i = 0; i < std::min<std::size_t>(CPU_SETSIZE, max_cpu_count); ++i)
+            if (cpus.test(i))
+                CPU_SET(i, &set);
+
+        if (const auto e = ::pthread_setaffinity_np(_handle, sizeof(set), &set); e != 0)
+            ec.assign(e, std::system_category());
+    }
+
+    inline void native_thread::set_name(std::string_view name, std::error_code& ec) noexcept
+    {
+        ec.clear();
+
+        // the kernel accepts at most 15 characters plus the terminator
+        char buffer[16] = {};
+        name.copy(buffer, std::size(buffer) - 1);
+        if (const auto e = ::pthread_setname_np(_handle, buffer); e != 0)
+            ec.assign(e, std::system_category());
+    }
+
+    inline native_cpu_core native_thread::core_affinity() noexcept
+    {
+        // first processor of the mask, the one used by core_affinity(native_cpu_core)
+        std::error_code ec;
+        const auto      cpus = affinity(ec);
+        for (std::size_t i = 0; i < std::size(cpus); ++i)
+            if (cpus.test(i))
+                return native_cpu_core{ static_cast<std::uint32_t>(i) };
+        return native_cpu_core{ 0 };
+    }
+
+#endif
+
+    inline native_thread::priority_type native_thread::priority() const
+    {
+        std::error_code ec;
+        const auto      p = priority(ec);
+        if (ec)
+            throw std::system_error(ec);
+        return p;
+    }
+
+    inline void native_thread::set_priority(const priority_type p)
+    {
+        std::error_code ec;
+        if (set_priority(p, ec); ec)
+            throw std::system_error(ec);
+    }
+
+    inline native_thread::affinity_mask native_thread::affinity() const
+    {
+        std::error_code ec;
+        const auto      cpus = affinity(ec);
+        if (ec)
+            throw std::system_error(ec);
+        return cpus;
+    }
+
+    inline void native_thread::set_affinity(const affinity_mask& cpus)
+    {
+        std::error_code ec;
+        if (set_affinity(cpus, ec); ec)
+            throw std::system_error(ec);
+    }
+
+    inline void native_thread::set_name(std::string_view name)
+    {
+        std::error_code ec;
+        if (set_name(name, ec); ec)
+            throw std::system_error(ec);
+    }
+
 } // namespace drako::sys
 
-#endif // !DRAKO_THREAD_HPP
\ No newline at end of file
+#endif // !DRAKO_THREAD_HPP
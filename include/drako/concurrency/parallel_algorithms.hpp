@@ -0,0 +1,203 @@
+#pragma once
+#ifndef DRAKO_PARALLEL_ALGORITHMS_HPP
+#define DRAKO_PARALLEL_ALGORITHMS_HPP
+
+/// @file
+/// @brief  Data parallel algorithms executed on a JobScheduler.
+/// @author Grassi Edoardo
+
+#include "drako/concurrency/job_scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace drako
+{
+    /// @brief Min number of elements processed as a single chunk by the parallel algorithms.
+    ///
+    /// Ranges shorter than twice the grain are processed serially by the calling thread.
+    ///
+    inline constexpr const std::size_t default_parallel_grain = 1024;
+
+
+    namespace _detail
+    {
+        // guided self-scheduling: chunks shrink as the range is consumed, so that threads
+        // that received expensive elements are balanced by the others at the end of the range
+        class _chunked_range
+        {
+        public:
+            explicit _chunked_range(std::size_t first, std::size_t last, std::size_t grain, std::size_t threads) noexcept
+                : _cursor{ first }, _last{ last }, _grain{ grain }, _threads{ threads } {}
+
+            // claims the next chunk, returns false when the range is exhausted
+            [[nodiscard]] bool next(std::size_t& begin, std::size_t& end) noexcept
+            {
+                auto current = _cursor.load(std::memory_order::relaxed);
+                do
+                {
+                    if (current >= _last)
+                        return false;
+
+                    const auto remaining = _last - current;
+                    const auto size      = std::min(remaining, std::max(_grain, remaining / (2 * _threads)));
+                    begin                = current;
+                    end                  = current + size;
+                } while (!_cursor.compare_exchange_weak(current, end, std::memory_order::relaxed));
+                return true;
+            }
+
+        private:
+            std::atomic<std::size_t> _cursor;
+            const std::size_t        _last;
+            const std::size_t        _grain;
+            const std::size_t        _threads;
+        };
+
+    } // namespace _detail
+
+
+    /// @brief Invokes a function for each index in a range, in parallel.
+    ///
+    /// @param[in] scheduler Pool of threads that executes the iterations.
+    /// @param[in] first     First index of the range.
+    /// @param[in] last      Past the end index of the range.
+    /// @param[in] f         Callable invoked as f(index), must not throw exceptions.
+    /// @param[in] grain     Min number of iterations executed as a single chunk.
+    ///
+    /// @throw std::bad_alloc if the jobs can't be allocated, once the calling thread completed the iterations.
+    ///
+    /// @note The calling thread takes part in the execution and returns when all the iterations have completed.
+    ///
+    template <typename Function> // clang-format off
+    requires std::is_invocable_v<Function&, std::size_t>
+    void parallel_for(JobScheduler& scheduler, std::size_t first, std::size_t last, // clang-format on
+        Function f, std::size_t grain = default_parallel_grain)
+    {
+        assert(first <= last);
+        assert(grain > 0);
+
+        const auto count = last - first;
+        if (count < 2 * grain || scheduler.workers() == 0) // not worth the overhead
+        {
+            for (auto i = first; i < last; ++i)
+                std::invoke(f, i);
+            return;
+        }
+
+        // at most one job for each worker, plus the calling thread
+        const auto threads = std::min(scheduler.workers() + 1, count / grain);
+
+        _detail::_chunked_range range{ first, last, grain, threads };
+        const auto              execute = [&]() {
+            for (std::size_t begin, end; range.next(begin, end);)
+                for (auto i = begin; i < end; ++i)
+                    std::invoke(f, i);
+        };
+
+        JobCounter counter;
+        try
+        {
+            for (std::size_t t = 1; t < threads; ++t)
+                scheduler.submit(execute, counter);
+        }
+        catch (...)
+        {
+            // the jobs already submitted reference the locals, they must complete before unwinding
+            execute();
+            scheduler.wait(counter);
+            throw;
+        }
+        execute();
+        scheduler.wait(counter);
+    }
+
+    /// @brief Invokes a function for each element of a span, in parallel.
+    ///
+    /// @param[in] f Callable invoked as f(element), must not throw exceptions.
+    ///
+    template <typename T, typename Function> // clang-format off
+    requires std::is_invocable_v<Function&, T&>
+    void parallel_for(JobScheduler& scheduler, std::span<T> values, // clang-format on
+        Function f, std::size_t grain = default_parallel_grain)
+    {
+        parallel_for(
+            scheduler, 0, std::size(values), [&](std::size_t i) { std::invoke(f, values[i]); }, grain);
+    }
+
+    /// @brief Applies a function to each element of a span and stores the results in another, in parallel.
+    ///
+    /// @param[in]  src Source elements.
+    /// @param[out] dst Destination for the results, must be as large as the source.
+    /// @param[in]  f   Callable invoked as f(element), must not throw exceptions.
+    ///
+    template <typename T, typename U, typename Function> // clang-format off
+    requires std::is_invocable_v<Function&, const T&>
+        && std::is_assignable_v<U&, std::invoke_result_t<Function&, const T&>>
+    void parallel_transform(JobScheduler& scheduler, std::span<const T> src, std::span<U> dst, // clang-format on
+        Function f, std::size_t grain = default_parallel_grain)
+    {
+        assert(std::size(src) == std::size(dst));
+        parallel_for(
+            scheduler, 0, std::size(src), [&](std::size_t i) { dst[i] = std::invoke(f, src[i]); }, grain);
+    }
+
+    /// @brief Sorts the elements of a span, in parallel.
+    ///
+    /// The span is split in sorted runs, which are then merged pairwise;
+    /// runs of the same round are sorted and merged in parallel.
+    ///
+    /// @param[in] values  Elements to sort.
+    /// @param[in] compare Strict weak ordering, must not throw exceptions.
+    ///
+    /// @note The sort is not stable.
+    ///
+    template <typename T, typename Compare = std::less<>> // clang-format off
+    requires std::is_invocable_r_v<bool, Compare&, const T&, const T&>
+    void parallel_sort(JobScheduler& scheduler, std::span<T> values, // clang-format on
+        Compare compare = {}, std::size_t grain = default_parallel_grain)
+    {
+        assert(grain > 0);
+
+        const auto count = std::size(values);
+        const auto runs  = std::min(scheduler.workers() + 1, count / grain);
+        if (runs < 2) // not worth the overhead
+        {
+            std::sort(std::begin(values), std::end(values), compare);
+            return;
+        }
+
+        // boundaries of the runs, evenly distributed
+        std::vector<std::size_t> bounds(runs + 1);
+        for (std::size_t r = 0; r <= runs; ++r)
+            bounds[r] = count * r / runs;
+
+        const auto first = std::begin(values);
+        parallel_for(
+            scheduler, 0, runs, [&](std::size_t r) { std::sort(first + bounds[r], first + bounds[r + 1], compare); }, 1);
+
+        // each round merges adjacent pairs of runs, halving their number
+        for (std::size_t width = 1; width < runs; width *= 2)
+        {
+            const auto merges = (runs + 2 * width - 1) / (2 * width);
+            parallel_for(
+                scheduler, 0, merges, [&](std::size_t m) {
+                    const auto lo  = m * 2 * width;
+                    const auto mid = std::min(lo + width, runs);
+                    const auto hi  = std::min(lo + 2 * width, runs);
+                    if (mid < hi)
+                        std::inplace_merge(first + bounds[lo], first + bounds[mid], first + bounds[hi], compare);
+                },
+                1);
+        }
+    }
+
+} // namespace drako
+
+#endif // !DRAKO_PARALLEL_ALGORITHMS_HPP
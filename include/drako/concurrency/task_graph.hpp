@@ -0,0 +1,298 @@
+#pragma once
+#ifndef DRAKO_TASK_GRAPH_HPP
+#define DRAKO_TASK_GRAPH_HPP
+
+/// @file
+/// @brief  Dependency graph of the tasks executed in each frame.
+/// @author Grassi Edoardo
+
+#include "drako/concurrency/job_scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drako
+{
+    /// @brief Directed acyclic graph of tasks, executed once per frame on a JobScheduler.
+    ///
+    /// Each task declares the resources (e.g. the tables of a system) that it reads and writes.
+    /// Tasks that access the same resource, with at least one of them writing it,
+    /// run in the order they were added to the graph; all the other tasks can run in parallel.
+    ///
+    /// The dependencies are computed only when the set of tasks changes,
+    /// executions with the same topology reuse them.
+    ///
+    class TaskGraph
+    {
+    public:
+        using Task = std::function<void()>;
+
+        /// @brief User defined identifier of a resource shared between tasks.
+        enum class Resource : std::uint32_t {};
+
+        /// @brief Identifier of a task in the graph.
+        enum class TaskID : std::uint32_t {};
+
+        struct Node
+        {
+            /// @brief Debug-only friendly name.
+            std::string name;
+
+            /// @brief Work executed in each frame, must not throw exceptions.
+            Task task;
+
+            /// @brief Resources accessed without modifications.
+            std::vector<Resource> reads;
+
+            /// @brief Resources modified by the task.
+            std::vector<Resource> writes;
+        };
+
+        explicit TaskGraph() = default;
+
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        /// @brief Adds a task to the graph.
+        ///
+        /// @return Identifier of the new task.
+        ///
+        /// @warning Not thread-safe, mustn't be called during run().
+        ///
+        [[nodiscard]] TaskID add(Node node)
+        {
+            assert(node.task);
+
+            std::uint32_t slot;
+            if (!std::empty(_free_slots))
+            {
+                slot = _free_slots.back();
+                _free_slots.pop_back();
+            }
+            else
+            {
+                slot = static_cast<std::uint32_t>(std::size(_nodes));
+                _nodes.push_back(std::make_unique<_node>());
+            }
+
+            _nodes[slot]->desc = std::move(node);
+            _order.push_back(slot);
+            _dirty = true;
+            return TaskID{ slot };
+        }
+
+        /// @brief Removes a task from the graph.
+        ///
+        /// @warning Not thread-safe, mustn't be called during run().
+        ///
+        void remove(TaskID id)
+        {
+            const auto slot = static_cast<std::uint32_t>(id);
+            const auto it   = std::find(std::begin(_order), std::end(_order), slot);
+            assert(it != std::end(_order)); // task isn't in the graph
+
+            _order.erase(it);
+            auto& n   = *_nodes[slot];
+            n.desc    = {};
+            n.elapsed = {};
+            _free_slots.push_back(slot);
+            _dirty = true;
+        }
+
+        /// @brief Executes all the tasks and waits for their completion.
+        ///
+        /// The calling thread executes pending jobs of the scheduler while waiting.
+        ///
+        void run(JobScheduler& scheduler)
+        {
+            if (_dirty)
+                _build();
+
+            for (const auto i : _order)
+                _nodes[i]->pending.store(_nodes[i]->predecessors, std::memory_order::relaxed);
+
+            JobCounter counter;
+            for (const auto i : _roots)
+                _submit(scheduler, counter, i);
+            scheduler.wait(counter);
+        }
+
+        /// @brief Longest chain of dependent tasks in the last execution, weighted by their duration.
+        ///
+        /// @return Tasks on the path, in execution order.
+        ///
+        [[nodiscard]] std::vector<TaskID> critical_path() const
+        {
+            using _clock = std::chrono::steady_clock;
+
+            // tasks are sorted in topological order, predecessors are always visited first
+            std::vector<_clock::duration> finish(std::size(_nodes));
+            std::vector<std::uint32_t>    parent(std::size(_nodes), _no_task);
+            std::uint32_t                 last = _no_task;
+            for (const auto i : _order)
+            {
+                auto start = _clock::duration::zero();
+                for (const auto p : _nodes[i]->sources)
+                    if (finish[p] > start)
+                        start = finish[p], parent[i] = p;
+
+                finish[i] = start + _nodes[i]->elapsed;
+                if (last == _no_task || finish[i] > finish[last])
+                    last = i;
+            }
+
+            std::vector<TaskID> path;
+            for (auto i = last; i != _no_task; i = parent[i])
+                path.push_back(TaskID{ i });
+            std::reverse(std::begin(path), std::end(path));
+            return path;
+        }
+
+        /// @brief Duration of a task in the last execution.
+        [[nodiscard]] std::chrono::steady_clock::duration elapsed(TaskID id) const noexcept
+        {
+            return _nodes[static_cast<std::uint32_t>(id)]->elapsed;
+        }
+
+        /// @brief Friendly name of a task.
+        [[nodiscard]] const std::string& name(TaskID id) const noexcept
+        {
+            return _nodes[static_cast<std::uint32_t>(id)]->desc.name;
+        }
+
+        /// @brief Tasks that must complete before a task can start.
+        ///
+        /// @note Dependencies are updated by the first run() after a change of topology.
+        ///
+        [[nodiscard]] std::vector<TaskID> dependencies(TaskID id) const
+        {
+            const auto& sources = _nodes[static_cast<std::uint32_t>(id)]->sources;
+
+            std::vector<TaskID> result;
+            result.reserve(std::size(sources));
+            for (const auto s : sources)
+                result.push_back(TaskID{ s });
+            return result;
+        }
+
+        /// @brief Number of tasks in the graph.
+        [[nodiscard]] std::size_t size() const noexcept { return std::size(_order); }
+
+        /// @brief Number of times the dependencies have been computed.
+        [[nodiscard]] std::size_t builds() const noexcept { return _builds; }
+
+    private:
+        static constexpr const std::uint32_t _no_task = ~std::uint32_t{ 0 };
+
+        struct _node
+        {
+            Node                       desc;
+            std::vector<std::uint32_t> sources;          // tasks that must complete first
+            std::vector<std::uint32_t> targets;          // tasks that wait for this one
+            std::uint32_t              predecessors = 0; // size of sources
+            std::atomic<std::uint32_t> pending      = 0; // sources that haven't completed in this run
+
+            std::chrono::steady_clock::duration elapsed{}; // duration of the last execution
+        };
+
+        // accesses to a resource by the tasks visited so far
+        struct _access
+        {
+            std::optional<std::uint32_t> writer;  // last task that modified the resource
+            std::vector<std::uint32_t>   readers; // tasks that read it after the last write
+        };
+
+        std::vector<std::unique_ptr<_node>> _nodes;      // stable addresses, accessed by the workers
+        std::vector<std::uint32_t>          _order;      // live tasks, in insertion order
+        std::vector<std::uint32_t>          _free_slots; // slots of removed tasks
+        std::vector<std::uint32_t>          _roots;      // tasks without dependencies
+        std::size_t                         _builds = 0;
+        bool                                _dirty  = false;
+
+        void _build()
+        {
+            for (const auto i : _order)
+            {
+                _nodes[i]->sources.clear();
+                _nodes[i]->targets.clear();
+            }
+            _roots.clear();
+
+            const auto link = [this](std::uint32_t from, std::uint32_t to) {
+                auto& s = _nodes[to]->sources;
+                if (from != to && std::find(std::begin(s), std::end(s), from) == std::end(s))
+                {
+                    s.push_back(from);
+                    _nodes[from]->targets.push_back(to);
+                }
+            };
+
+            // only the edges from the last conflicting accesses are recorded,
+            // the older ones are implied by transitivity
+            std::unordered_map<Resource, _access> accesses;
+            for (const auto i : _order)
+            {
+                const auto& desc = _nodes[i]->desc;
+                for (const auto r : desc.reads)
+                    if (const auto& a = accesses[r]; a.writer)
+                        link(*a.writer, i);
+
+                for (const auto w : desc.writes)
+                {
+                    // the readers already wait for the last writer
+                    const auto& a = accesses[w];
+                    if (a.writer && std::empty(a.readers))
+                        link(*a.writer, i);
+                    for (const auto reader : a.readers)
+                        link(reader, i);
+                }
+
+                for (const auto r : desc.reads)
+                    accesses[r].readers.push_back(i);
+                for (const auto w : desc.writes)
+                {
+                    auto& a  = accesses[w];
+                    a.writer = i;
+                    a.readers.clear();
+                }
+
+                auto& n        = *_nodes[i];
+                n.predecessors = static_cast<std::uint32_t>(std::size(n.sources));
+                if (n.predecessors == 0)
+                    _roots.push_back(i);
+            }
+
+            _dirty = false;
+            ++_builds;
+        }
+
+        void _submit(JobScheduler& scheduler, JobCounter& counter, std::uint32_t i)
+        {
+            // ready tasks are submitted before the completed one is signaled, so the counter stays positive
+            scheduler.submit([this, &scheduler, &counter, i]() {
+                auto&      n     = *_nodes[i];
+                const auto start = std::chrono::steady_clock::now();
+                std::invoke(n.desc.task);
+                n.elapsed = std::chrono::steady_clock::now() - start;
+
+                for (const auto t : n.targets)
+                    if (_nodes[t]->pending.fetch_sub(1, std::memory_order::acq_rel) == 1)
+                        _submit(scheduler, counter, t);
+            },
+                counter);
+        }
+    };
+
+} // namespace drako
+
+#endif // !DRAKO_TASK_GRAPH_HPP
@@ -0,0 +1,107 @@
+#include "drako/concurrency/lockfree_bip_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace drako::lockfree;
+
+GTEST_TEST(BipBuffer, WrapAround)
+{
+    BipBuffer buffer{ 100 };
+
+    auto block = buffer.reserve(60);
+    ASSERT_EQ(std::size(block), 60);
+    std::memset(std::data(block), 1, 60);
+    buffer.commit(60);
+
+    // doesn't fit in the tail, and the reader is still at the start
+    EXPECT_TRUE(std::empty(buffer.reserve(50)));
+
+    auto data = buffer.read();
+    ASSERT_EQ(std::size(data), 60);
+    buffer.release(60);
+
+    // wraps around, the last 40 bytes of the buffer are skipped
+    block = buffer.reserve(50);
+    ASSERT_EQ(std::size(block), 50);
+    EXPECT_EQ(std::data(block), std::data(data));
+    std::memset(std::data(block), 2, 50);
+    buffer.commit(30); // shorter than the reservation
+
+    data = buffer.read();
+    ASSERT_EQ(std::size(data), 30);
+    EXPECT_EQ(data[29], std::byte{ 2 });
+    buffer.release(10);
+    EXPECT_EQ(std::size(buffer.read()), 20);
+}
+
+GTEST_TEST(CommandRing, SingleThreadOps)
+{
+    CommandRing ring{ 1024 };
+
+    EXPECT_TRUE(ring.push(1, std::uint64_t{ 42 }));
+
+    const char text[] = "variable length payload";
+    auto       dst    = ring.reserve(2, sizeof(text));
+    ASSERT_EQ(std::size(dst), sizeof(text));
+    std::memcpy(std::data(dst), text, sizeof(text));
+    ring.commit();
+
+    std::vector<std::uint32_t> types;
+    EXPECT_EQ(ring.consume([&](std::uint32_t type, std::span<const std::byte> payload) {
+        types.push_back(type);
+        if (type == 1)
+        {
+            ASSERT_EQ(std::size(payload), sizeof(std::uint64_t));
+            EXPECT_EQ(*reinterpret_cast<const std::uint64_t*>(std::data(payload)), 42);
+        }
+        else
+            EXPECT_EQ(std::memcmp(std::data(payload), text, sizeof(text)), 0);
+    }), 2);
+    EXPECT_EQ(types, (std::vector<std::uint32_t>{ 1, 2 }));
+    EXPECT_EQ(ring.consume([](auto, auto) {}), 0);
+}
+
+GTEST_TEST(CommandRing, MultiThreadOps)
+{
+    const std::uint32_t commands = 100'000;
+
+    CommandRing ring{ 4096 };
+    std::thread producer{ [&]() {
+        for (std::uint32_t i = 0; i < commands;)
+        {
+            // payloads of different sizes, filled with the index of the command
+            const auto bytes = sizeof(std::uint32_t) * (1 + i % 37);
+            if (const auto dst = ring.reserve(i, bytes); !std::empty(dst))
+            {
+                std::vector<std::uint32_t> values(bytes / sizeof(std::uint32_t), i);
+                std::memcpy(std::data(dst), std::data(values), bytes);
+                ring.commit();
+                ++i;
+            }
+            else
+                std::this_thread::yield();
+        }
+    } };
+
+    std::uint32_t expected = 0;
+    while (expected < commands)
+        if (ring.consume([&](std::uint32_t type, std::span<const std::byte> payload) {
+            ASSERT_EQ(type, expected);
+            ASSERT_EQ(std::size(payload), sizeof(std::uint32_t) * (1 + type % 37));
+            for (std::size_t i = 0; i < std::size(payload); i += sizeof(std::uint32_t))
+            {
+                std::uint32_t value;
+                std::memcpy(&value, std::data(payload) + i, sizeof(value));
+                ASSERT_EQ(value, type);
+            }
+            ++expected;
+        }) == 0)
+            std::this_thread::yield();
+    producer.join();
+}
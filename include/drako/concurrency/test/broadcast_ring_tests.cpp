@@ -0,0 +1,87 @@
+#include "drako/concurrency/lockfree_broadcast_ring.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace drako::lockfree;
+
+GTEST_TEST(BroadcastRing, Construction)
+{
+    BroadcastRing<int> ring{ 1000, 3 };
+    EXPECT_EQ(ring.capacity(), 1024);
+    EXPECT_EQ(ring.readers(), 3);
+    for (std::size_t r = 0; r < ring.readers(); ++r)
+        EXPECT_EQ(ring.size(r), 0);
+}
+
+GTEST_TEST(BroadcastRing, SingleThreadOps)
+{
+    BroadcastRing<int> ring{ 8, 2 };
+
+    for (auto i = 0; i < 8; ++i)
+        ASSERT_TRUE(ring.publish(i));
+    EXPECT_FALSE(ring.publish(8)); // both readers are a full lap behind
+
+    // the writer is gated by the slowest reader
+    for (auto i = 0; i < 8; ++i)
+    {
+        int value;
+        ASSERT_TRUE(ring.read(0, value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(ring.publish(8));
+
+    std::vector<int> seen;
+    EXPECT_EQ(ring.consume(1, [&](int v) { seen.push_back(v); }, 3), 3);
+    EXPECT_EQ(seen, (std::vector<int>{ 0, 1, 2 }));
+
+    const int values[] = { 8, 9, 10, 11 };
+    EXPECT_EQ(ring.publish_bulk(values), 3);
+    EXPECT_EQ(ring.size(0), 3);
+    EXPECT_EQ(ring.size(1), 8);
+
+    int out[8];
+    EXPECT_EQ(ring.read_bulk(1, out), 8);
+    for (auto i = 0; i < 8; ++i)
+        EXPECT_EQ(out[i], i + 3);
+}
+
+GTEST_TEST(BroadcastRing, MultiThreadOps)
+{
+    const std::size_t   readers = 3;
+    const std::uint64_t items   = 200'000;
+
+    BroadcastRing<std::uint64_t> ring{ 64, readers };
+    std::atomic_flag             done;
+
+    std::vector<std::thread>   threads;
+    std::vector<std::uint64_t> sums(readers);
+    for (std::size_t r = 0; r < readers; ++r)
+        threads.emplace_back([&, r]() {
+            std::uint64_t expected = 0;
+            const auto    stop     = [&]() { return done.test(std::memory_order::acquire) && ring.size(r) == 0; };
+            while (ring.consume_wait(r, [&](std::uint64_t v) {
+                EXPECT_EQ(v, expected++); // every reader sees every element in order
+                sums[r] += v;
+            }, stop) > 0)
+                ;
+        });
+
+    for (std::uint64_t i = 0; i < items;)
+        if (ring.publish(i))
+            ++i;
+        else
+            std::this_thread::yield();
+
+    done.test_and_set(std::memory_order::release);
+    ring.wake_readers();
+    for (auto& t : threads)
+        t.join();
+
+    for (const auto s : sums)
+        EXPECT_EQ(s, items * (items - 1) / 2);
+}
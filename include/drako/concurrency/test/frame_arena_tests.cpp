@@ -0,0 +1,97 @@
+#include "drako/concurrency/frame_arena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+const auto TEST_THREAD_COUNT = 4;
+
+using namespace drako;
+
+GTEST_TEST(LinearAllocator, Exhaustion)
+{
+    concurrency::lockfree_linear_allocator alloc{ 256 };
+
+    const auto a = alloc.allocate(100, 1);
+    const auto b = alloc.allocate(100, 64);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b) % 64, 0);
+    EXPECT_EQ(alloc.allocate(100), nullptr);
+
+    alloc.release();
+    EXPECT_EQ(alloc.used(), 0);
+    EXPECT_EQ(alloc.allocate(100, 1), a);
+}
+
+GTEST_TEST(FrameArena, RecycleAfterBufferedFrames)
+{
+    FrameArena arena{ { .frames = 2, .frame_size = 4096, .chunk_size = 1024 } };
+
+    const auto first = static_cast<int*>(arena.allocate(sizeof(int), alignof(int)));
+    ASSERT_NE(first, nullptr);
+    *first = 42;
+
+    // memory of the previous frame is still valid
+    arena.advance();
+    EXPECT_NE(arena.allocate(sizeof(int), alignof(int)), first);
+    EXPECT_EQ(*first, 42);
+
+    // the arena of the first frame gets recycled
+    arena.advance();
+    EXPECT_EQ(arena.allocate(sizeof(int), alignof(int)), first);
+}
+
+GTEST_TEST(FrameArena, Stats)
+{
+    FrameArena arena{ { .frames = 1, .frame_size = 4096, .chunk_size = 512 } };
+
+    // third allocation doesn't fit in the first chunk
+    for (auto i = 0; i < 3; ++i)
+        (void)arena.allocate(200);
+    arena.advance();
+    (void)arena.allocate(8);
+
+    const auto stats = arena.stats();
+    EXPECT_EQ(stats.used, 512);
+    EXPECT_EQ(stats.high_water_mark, 512 * 2);
+}
+
+GTEST_TEST(FrameArena, FallbackToHeap)
+{
+    FrameArena arena{ { .frames = 1, .frame_size = 256, .chunk_size = 128 } };
+
+    std::vector<int, FrameAllocator<int>> v{ arena };
+    for (auto i = 0; i < 1000; ++i)
+        v.push_back(i);
+    for (auto i = 0; i < 1000; ++i)
+        EXPECT_EQ(v[i], i);
+    EXPECT_FALSE(arena.owns(v.data()));
+}
+
+GTEST_TEST(FrameArena, MultiThread)
+{
+    FrameArena arena{ { .frames = 1, .frame_size = 1 << 20, .chunk_size = 4096 } };
+
+    std::vector<std::thread> threads;
+    std::vector<std::vector<std::uint64_t*>> blocks(TEST_THREAD_COUNT);
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&, t]() {
+            for (auto i = 0; i < 1000; ++i)
+            {
+                const auto p = static_cast<std::uint64_t*>(arena.allocate(sizeof(std::uint64_t)));
+                ASSERT_NE(p, nullptr);
+                *p = t;
+                blocks[t].push_back(p);
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+
+    // blocks of different threads never overlap
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        for (const auto p : blocks[t])
+            EXPECT_EQ(*p, static_cast<std::uint64_t>(t));
+}
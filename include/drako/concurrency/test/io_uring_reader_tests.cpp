@@ -0,0 +1,123 @@
+#include "drako/concurrency/io_uring_reader.hpp"
+
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace drako;
+
+// temporary file filled with a known pattern
+struct TestFile
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "drako-io-uring-test.bin";
+    std::string           text;
+    int                   fd;
+
+    TestFile()
+    {
+        for (auto i = 0; i < 4096; ++i)
+            text.push_back(static_cast<char>('a' + i % 26));
+        std::ofstream{ path, std::ios::binary } << text;
+        fd = ::open(path.c_str(), O_RDONLY);
+    }
+
+    ~TestFile()
+    {
+        ::close(fd);
+        std::filesystem::remove(path);
+    }
+};
+
+// reaps until the expected number of completions is reached
+std::vector<IoUringReader::Completion> reap_all(IoUringReader& ring, std::size_t expected)
+{
+    std::vector<IoUringReader::Completion>   all;
+    std::array<IoUringReader::Completion, 8> batch;
+    while (std::size(all) < expected)
+    {
+        const auto n = ring.reap(batch, 1);
+        all.insert(std::end(all), std::begin(batch), std::begin(batch) + n);
+    }
+    return all;
+}
+
+#define MAKE_RING_OR_SKIP(ring, entries)                                \
+    std::optional<IoUringReader> ring;                                  \
+    try                                                                 \
+    {                                                                   \
+        ring.emplace(entries);                                          \
+    }                                                                   \
+    catch (const std::system_error& e)                                  \
+    {                                                                   \
+        GTEST_SKIP() << "io_uring is not available: " << e.what();      \
+    }
+
+GTEST_TEST(IoUringReader, BatchedReads)
+{
+    MAKE_RING_OR_SKIP(ring, 8);
+    TestFile file;
+    ASSERT_GE(file.fd, 0);
+
+    std::array<std::array<std::byte, 100>, 4> buffers;
+    std::array<IoUringReader::Read, 4>        reads;
+    for (std::size_t i = 0; i < std::size(reads); ++i)
+        reads[i] = { .fd = file.fd, .dst = buffers[i], .offset = i * 1000, .user_data = &buffers[i] };
+    ASSERT_EQ(ring->submit(reads), std::size(reads));
+
+    for (const auto& c : reap_all(*ring, std::size(reads)))
+    {
+        ASSERT_EQ(c.result, 100);
+        const auto i = static_cast<const std::array<std::byte, 100>*>(c.user_data) - std::data(buffers);
+        EXPECT_EQ(std::memcmp(std::data(buffers[i]), std::data(file.text) + i * 1000, 100), 0);
+    }
+}
+
+GTEST_TEST(IoUringReader, RegisteredBuffersAndFiles)
+{
+    MAKE_RING_OR_SKIP(ring, 4);
+    TestFile file;
+    ASSERT_GE(file.fd, 0);
+
+    std::vector<std::byte>     memory(8192);
+    const std::span<std::byte> registered[] = { memory };
+    const int                  files[]      = { file.fd };
+    ring->register_buffers(registered);
+    ring->register_files(files);
+
+    // the second read crosses the end of the file
+    const IoUringReader::Read reads[] = {
+        { .fd = file.fd, .dst = std::span{ memory }.first(10), .offset = 0, .user_data = nullptr },
+        { .fd = file.fd, .dst = std::span{ memory }.subspan(4096, 200), .offset = 4000, .user_data = &memory },
+    };
+    ASSERT_EQ(ring->submit(reads), 2);
+
+    for (const auto& c : reap_all(*ring, 2))
+        EXPECT_EQ(c.result, c.user_data ? 96 : 10);
+    EXPECT_EQ(std::memcmp(std::data(memory), std::data(file.text), 10), 0);
+    EXPECT_EQ(std::memcmp(std::data(memory) + 4096, std::data(file.text) + 4000, 96), 0);
+}
+
+GTEST_TEST(IoUringReader, ReportsErrors)
+{
+    MAKE_RING_OR_SKIP(ring, 4);
+
+    std::array<std::byte, 16> buffer;
+    const IoUringReader::Read reads[] = { { .fd = -1, .dst = buffer, .offset = 0, .user_data = nullptr } };
+    ASSERT_EQ(ring->submit(reads), 1);
+    EXPECT_EQ(reap_all(*ring, 1).front().result, -EBADF);
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "drako/concurrency/job_scheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+using namespace drako;
+
+GTEST_TEST(JobScheduler, ExternalSubmit)
+{
+    JobScheduler scheduler{ { .workers = 4, .queue_size = 256 } };
+    ASSERT_EQ(scheduler.workers(), 4);
+
+    const auto       jobs = 10'000;
+    std::atomic<int> executed = 0;
+    JobCounter       counter;
+
+    for (auto i = 0; i < jobs; ++i)
+        scheduler.submit([&]() { ++executed; }, counter);
+
+    scheduler.wait(counter);
+    EXPECT_TRUE(counter.done());
+    EXPECT_EQ(executed, jobs);
+}
+
+GTEST_TEST(JobScheduler, NestedSubmit)
+{
+    JobScheduler scheduler{ { .workers = 4, .queue_size = 64 } };
+
+    const auto       parents = 100, children = 100;
+    std::atomic<int> executed = 0;
+    JobCounter       counter;
+
+    for (auto i = 0; i < parents; ++i)
+        scheduler.submit([&]() {
+            // fan out from inside a worker, then join without blocking the thread
+            JobCounter local;
+            for (auto k = 0; k < children; ++k)
+                scheduler.submit([&]() { ++executed; }, local);
+            scheduler.wait(local);
+        },
+            counter);
+
+    scheduler.wait(counter);
+    EXPECT_EQ(executed, parents * children);
+}
+
+GTEST_TEST(JobScheduler, FiberSuspendOnCounter)
+{
+    JobScheduler scheduler{ { .workers = 2, .queue_size = 64 } };
+
+    const auto       fibers = 100, children = 50;
+    std::atomic<int> executed = 0, joined = 0;
+    JobCounter       counter;
+
+    auto fan_out = [&]() -> JobScheduler::Fiber {
+        JobCounter local;
+        for (auto k = 0; k < children; ++k)
+            scheduler.submit([&]() { ++executed; }, local);
+
+        co_await scheduler.suspend_until(local);
+
+        // every child must have completed when the fiber resumes
+        if (local.done())
+            ++joined;
+    };
+
+    for (auto i = 0; i < fibers; ++i)
+        scheduler.submit(fan_out(), counter);
+
+    scheduler.wait(counter);
+    EXPECT_EQ(executed, fibers * children);
+    EXPECT_EQ(joined, fibers);
+}
+
+GTEST_TEST(JobScheduler, CounterDestroyedOnResume)
+{
+    // the counter lives in the fiber frame, which is released as soon as the fiber resumes:
+    // neither the last child nor the registering fiber may access it afterwards
+    JobScheduler scheduler{ { .workers = 4, .queue_size = 64 } };
+
+    const auto       rounds = 2'000;
+    std::atomic<int> resumed = 0;
+    JobCounter       counter;
+
+    auto short_lived = [&]() -> JobScheduler::Fiber {
+        JobCounter local;
+        scheduler.submit([]() {}, local);
+        co_await scheduler.suspend_until(local);
+        ++resumed;
+    };
+
+    for (auto i = 0; i < rounds; ++i)
+        scheduler.submit(short_lived(), counter);
+
+    scheduler.wait(counter);
+    EXPECT_EQ(resumed, rounds);
+}
+
+GTEST_TEST(JobScheduler, CounterDestroyedAfterWait)
+{
+    JobScheduler scheduler{ { .workers = 4, .queue_size = 64 } };
+
+    for (auto i = 0; i < 2'000; ++i)
+    {
+        // the counter goes out of scope as soon as the wait observes it done
+        JobCounter local;
+        scheduler.submit([]() {}, local);
+        scheduler.wait(local);
+    }
+}
@@ -0,0 +1,136 @@
+#include "drako/concurrency/lock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+const auto TEST_THREAD_COUNT = 4;
+const auto TEST_OBJECT_COUNT = 10'000;
+
+using namespace drako::concurrency;
+
+GTEST_TEST(SpinLock, MutualExclusion)
+{
+    spin_lock lock;
+    long long counter = 0; // protected by the lock
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&]() {
+            for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+            {
+                const std::scoped_lock guard{ lock };
+                ++counter;
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(counter, TEST_THREAD_COUNT * TEST_OBJECT_COUNT);
+    EXPECT_TRUE(lock.try_lock());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock();
+
+#if !defined(NDEBUG)
+    EXPECT_EQ(lock.stats().acquisitions, TEST_THREAD_COUNT * TEST_OBJECT_COUNT + 1);
+#endif
+}
+
+GTEST_TEST(SpinLock, Reentrant)
+{
+    reentrant_spin_lock lock;
+    lock.lock();
+    EXPECT_TRUE(lock.try_lock());
+    lock.unlock();
+
+    // still owned by the main thread
+    std::thread{ [&]() { EXPECT_FALSE(lock.try_lock()); } }.join();
+    lock.unlock();
+    std::thread{ [&]() {
+        EXPECT_TRUE(lock.try_lock());
+        lock.unlock();
+    } }.join();
+}
+
+GTEST_TEST(ReadWriteLock, SharedReaders)
+{
+    read_write_lock lock;
+    lock.lock_shared();
+    EXPECT_TRUE(lock.try_lock_shared());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock_shared();
+    lock.unlock_shared();
+
+    lock.lock();
+    EXPECT_FALSE(lock.try_lock_shared());
+    lock.unlock();
+    EXPECT_TRUE(lock.try_lock_shared());
+    lock.unlock_shared();
+}
+
+GTEST_TEST(ReadWriteLock, MultiThread)
+{
+    read_write_lock lock;
+
+    // writers keep the two values equal, readers must never observe them differ
+    long long        a = 0, b = 0;
+    std::atomic<int> torn = 0;
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&]() {
+            for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+            {
+                const std::shared_lock guard{ lock };
+                if (a != b)
+                    ++torn;
+            }
+        });
+    for (auto t = 0; t < TEST_THREAD_COUNT / 2; ++t)
+        threads.emplace_back([&]() {
+            for (auto i = 0; i < TEST_OBJECT_COUNT / 10; ++i)
+            {
+                const std::scoped_lock guard{ lock };
+                ++a;
+                std::this_thread::yield();
+                ++b;
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(a, TEST_THREAD_COUNT / 2 * (TEST_OBJECT_COUNT / 10));
+    EXPECT_EQ(a, b);
+}
+
+GTEST_TEST(Semaphore, BoundsConcurrency)
+{
+    semaphore sem{ 2 };
+
+    std::atomic<int> inside = 0, max_inside = 0;
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&]() {
+            for (auto i = 0; i < TEST_OBJECT_COUNT / 10; ++i)
+            {
+                sem.acquire();
+                const auto n = ++inside;
+                for (auto m = max_inside.load(); n > m && !max_inside.compare_exchange_weak(m, n);)
+                    ;
+                std::this_thread::yield();
+                --inside;
+                sem.release();
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_LE(max_inside, 2);
+    EXPECT_EQ(sem.available(), 2);
+}
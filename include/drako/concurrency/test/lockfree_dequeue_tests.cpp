@@ -0,0 +1,90 @@
+#include "drako/concurrency/lockfree_dequeue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace drako::lockfree;
+
+GTEST_TEST(DEQueue, Construction)
+{
+    DEQueue<int> q{ 100 };
+    EXPECT_EQ(q.capacity(), 128);
+    EXPECT_TRUE(q.empty());
+}
+
+GTEST_TEST(DEQueue, OwnerOps)
+{
+    DEQueue<int> q{ 64 };
+
+    for (auto i = 0; i < 64; ++i)
+        ASSERT_TRUE(q.enque(i));
+    EXPECT_FALSE(q.enque(64)); // queue should be full
+
+    for (auto i = 63; i >= 0; --i)
+    {
+        int out;
+        ASSERT_TRUE(q.deque(out));
+        ASSERT_EQ(out, i); // owner side is LIFO
+    }
+
+    int out;
+    EXPECT_FALSE(q.deque(out));
+}
+
+GTEST_TEST(DEQueue, StealOps)
+{
+    DEQueue<int> q{ 64 };
+
+    for (auto i = 0; i < 10; ++i)
+        ASSERT_TRUE(q.enque(i));
+
+    for (auto i = 0; i < 10; ++i)
+    {
+        int out;
+        ASSERT_TRUE(q.steal(out));
+        ASSERT_EQ(out, i); // thief side is FIFO
+    }
+
+    int out;
+    EXPECT_FALSE(q.steal(out));
+}
+
+GTEST_TEST(DEQueue, ConcurrentSteal)
+{
+    const auto thieves = 4, iters = 100'000;
+
+    DEQueue<int>                  q{ 256 };
+    std::vector<std::atomic<int>> taken(iters);
+    std::atomic_flag              done;
+
+    auto steal = [&]() {
+        for (int out; !done.test();)
+            if (q.steal(out))
+                ++taken[out];
+    };
+
+    std::vector<std::thread> workers;
+    for (auto i = 0; i < thieves; ++i)
+        workers.emplace_back(steal);
+
+    for (auto i = 0; i < iters; ++i)
+    {
+        while (!q.enque(i))
+            if (int out; q.deque(out))
+                ++taken[out];
+    }
+    for (int out; q.deque(out);)
+        ++taken[out];
+
+    while (!q.empty())
+        std::this_thread::yield();
+    done.test_and_set();
+    for (auto& w : workers)
+        w.join();
+
+    for (auto i = 0; i < iters; ++i)
+        ASSERT_EQ(taken[i], 1) << "error at item " << i;
+}
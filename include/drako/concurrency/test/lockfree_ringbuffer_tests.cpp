@@ -2,7 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <numeric>
 #include <thread>
+#include <vector>
 
 using namespace drako::lockfree;
 
@@ -108,4 +112,98 @@ GTEST_TEST(RingBuffer, MultiThreadOps)
 
     producer.join();
     consumer.join();
-}
\ No newline at end of file
+}
+GTEST_TEST(RingBuffer, SingleThreadBulkOps)
+{
+    using T = int;
+    RingBuffer<T> rb{ 100 };
+
+    std::vector<T> in(150), out(150);
+    std::iota(std::begin(in), std::end(in), 0);
+
+    // only a prefix fits in the queue
+    ASSERT_EQ(rb.enque_bulk(in), 100);
+    ASSERT_EQ(rb.enque_bulk(in), 0);
+
+    ASSERT_EQ(rb.deque_bulk({ std::data(out), 60 }), 60);
+    for (auto i = 0; i < 60; ++i)
+        ASSERT_EQ(out[i], i);
+
+    // wrap around the end of the buffer
+    ASSERT_EQ(rb.enque_bulk({ std::data(in) + 100, 50 }), 50);
+    ASSERT_EQ(rb.deque_bulk(out), 90);
+    for (auto i = 0; i < 90; ++i)
+        ASSERT_EQ(out[i], i + 60);
+
+    ASSERT_EQ(rb.deque_bulk(out), 0);
+    ASSERT_EQ(std::size(rb), 0);
+}
+
+GTEST_TEST(RingBuffer, MultiThreadBulkOps)
+{
+    using T = int;
+    RingBuffer<T> rb{ 100 };
+
+    const auto iters = 100'000, batch = 32;
+
+    auto produce = [&]() {
+        std::vector<T> in(batch);
+        for (auto i = 0; i < iters;)
+        {
+            const auto n = std::min(batch, iters - i);
+            for (auto k = 0; k < n; ++k)
+                in[k] = i + k;
+            if (const auto k = rb.enque_bulk({ std::data(in), static_cast<std::size_t>(n) }); k > 0)
+                i += static_cast<int>(k);
+            else
+                std::this_thread::yield();
+        }
+    };
+    auto consume = [&]() {
+        std::vector<T> out(batch);
+        for (auto i = 0; i < iters;)
+        {
+            const auto n = rb.deque_bulk(out);
+            if (n == 0)
+                std::this_thread::yield();
+            for (std::size_t k = 0; k < n; ++k, ++i)
+                ASSERT_EQ(out[k], i);
+        }
+    };
+
+    std::thread producer{ produce };
+    std::thread consumer{ consume };
+
+    producer.join();
+    consumer.join();
+}
+
+GTEST_TEST(RingBuffer, BlockingWait)
+{
+    using T = int;
+    RingBuffer<T> rb{ 16 };
+
+    const auto iters = 10'000;
+
+    std::atomic_flag stop;
+    std::thread      consumer{ [&]() {
+        T expected = 0;
+        for (T out = 0; rb.deque_wait(out, [&]() { return stop.test(); }); ++expected)
+            ASSERT_EQ(out, expected);
+        EXPECT_EQ(expected, iters);
+    } };
+
+    for (auto i = 0; i < iters; ++i)
+    {
+        while (!rb.enque(i))
+            std::this_thread::yield();
+        if (i % 1000 == 0) // let the consumer park on an empty queue
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+    }
+    while (!rb.empty())
+        std::this_thread::yield();
+
+    stop.test_and_set();
+    rb.wake_reader();
+    consumer.join();
+}
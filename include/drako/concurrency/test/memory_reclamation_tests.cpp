@@ -0,0 +1,196 @@
+#include "drako/concurrency/concurrent_list.hpp"
+#include "drako/concurrency/lockfree_linked_stack.hpp"
+#include "drako/concurrency/memory_reclamation.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+const auto TEST_THREAD_COUNT = 4;
+const auto TEST_OBJECT_COUNT = 1000 * TEST_THREAD_COUNT;
+
+using namespace drako::lockfree;
+
+namespace
+{
+    std::atomic<int> freed = 0;
+
+    void count_free(void*, void*) noexcept { freed.fetch_add(1); }
+} // namespace
+
+GTEST_TEST(EpochDomain, NoReclaimWhilePinned)
+{
+    freed = 0;
+    int objects[10];
+    {
+        EpochDomain domain{ 4, 1 };
+
+        const auto reader = domain.pin(); // another thread still traversing
+        {
+            const auto writer = domain.pin();
+            for (auto& o : objects)
+                domain.retire(writer, &o, count_free, nullptr);
+        }
+        EXPECT_EQ(freed, 0);
+    }
+    // leftovers are released by the destructor
+    EXPECT_EQ(freed, std::size(objects));
+}
+
+GTEST_TEST(EpochDomain, BacklogReclaimedAfterStall)
+{
+    freed = 0;
+    const auto batch = 4;
+    int        objects[batch * 64];
+
+    EpochDomain domain{ 4, batch };
+    {
+        // retired nodes pile up past the reserved capacity while a reader is stalled
+        const auto stalled = domain.pin();
+        for (auto& o : objects)
+        {
+            const auto guard = domain.pin();
+            domain.retire(guard, &o, count_free, nullptr);
+        }
+        EXPECT_EQ(freed, 0);
+    }
+
+    // the epoch advances again, the next retirements release the backlog
+    int extra[batch * 2];
+    for (auto& o : extra)
+    {
+        const auto guard = domain.pin();
+        domain.retire(guard, &o, count_free, nullptr);
+    }
+    EXPECT_GE(freed, std::size(objects));
+}
+
+GTEST_TEST(EpochDomain, BatchedReclaim)
+{
+    freed = 0;
+    const auto batch = 8;
+    int        objects[batch * 4];
+
+    EpochDomain domain{ 4, batch };
+    for (auto& o : objects)
+    {
+        const auto guard = domain.pin();
+        domain.retire(guard, &o, count_free, nullptr);
+    }
+    EXPECT_GT(freed, 0);
+    EXPECT_LT(freed, std::size(objects));
+}
+
+GTEST_TEST(HazardDomain, ProtectedNodeSurvivesScan)
+{
+    freed = 0;
+    int              objects[10];
+    std::atomic<int*> shared = &objects[0];
+    {
+        HazardDomain domain{ 4, 1 };
+
+        auto       reader = domain.acquire();
+        const auto p      = reader.protect(0, shared);
+        EXPECT_EQ(p, &objects[0]);
+        {
+            const auto writer = domain.acquire();
+            for (auto& o : objects)
+                domain.retire(writer, &o, count_free, nullptr);
+        }
+        // only the protected node is still alive
+        EXPECT_EQ(freed, std::size(objects) - 1);
+    }
+    EXPECT_EQ(freed, std::size(objects));
+}
+
+GTEST_TEST(LinkedStack, MultiThread)
+{
+    EpochDomain       domain{ TEST_THREAD_COUNT * 2 };
+    linked_stack<int> stack{ domain };
+
+    std::atomic<long long> sum = 0;
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&]() {
+            // each thread keeps recycling nodes to stress reclamation
+            long long local = 0;
+            for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+            {
+                EXPECT_TRUE(stack.push(i));
+                int out = 0;
+                EXPECT_TRUE(stack.pop(out));
+                local += out;
+            }
+            sum += local;
+        });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_TRUE(stack.is_empty());
+    EXPECT_EQ(sum, TEST_THREAD_COUNT * (TEST_OBJECT_COUNT * (TEST_OBJECT_COUNT - 1LL) / 2));
+}
+
+GTEST_TEST(LockfreeList, SingleThread)
+{
+    EpochDomain                            domain{};
+    drako::concurrency::lockfree_list<int> list{ domain };
+
+    EXPECT_TRUE(list.insert(3));
+    EXPECT_TRUE(list.insert(1));
+    EXPECT_TRUE(list.insert(2));
+    EXPECT_FALSE(list.insert(2));
+
+    EXPECT_TRUE(list.contains(1));
+    EXPECT_TRUE(list.remove(1));
+    EXPECT_FALSE(list.contains(1));
+    EXPECT_FALSE(list.remove(1));
+    EXPECT_TRUE(list.contains(2));
+    EXPECT_TRUE(list.contains(3));
+}
+
+GTEST_TEST(LockfreeList, MultiThread)
+{
+    EpochDomain                            domain{ TEST_THREAD_COUNT * 2 };
+    drako::concurrency::lockfree_list<int> list{ domain };
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&, t]() {
+            // threads work on disjoint keys that interleave in the list
+            for (auto i = t; i < 256; i += TEST_THREAD_COUNT)
+                EXPECT_TRUE(list.insert(i));
+            for (auto i = t; i < 256; i += TEST_THREAD_COUNT * 2)
+                EXPECT_TRUE(list.remove(i));
+        });
+    for (auto& t : threads)
+        t.join();
+
+    for (auto i = 0; i < 256; ++i)
+        EXPECT_EQ(list.contains(i), (i % (TEST_THREAD_COUNT * 2)) >= TEST_THREAD_COUNT) << i;
+}
+
+GTEST_TEST(HazardDomain, RetireDoesntGrowStorage)
+{
+    freed = 0;
+    int               objects[64];
+    std::atomic<int*> shared[HazardDomain::slots_per_thread];
+    {
+        HazardDomain domain{ 2, 4 };
+
+        // keep every slot of the reader busy, so that scans can't free everything
+        auto reader = domain.acquire();
+        for (std::size_t i = 0; i < std::size(shared); ++i)
+        {
+            shared[i] = &objects[i];
+            (void)reader.protect(i, shared[i]);
+        }
+
+        const auto writer = domain.acquire();
+        for (auto& o : objects)
+            domain.retire(writer, &o, count_free, nullptr);
+        EXPECT_EQ(freed, std::size(objects) - std::size(shared));
+    }
+    EXPECT_EQ(freed, std::size(objects));
+}
@@ -0,0 +1,113 @@
+#include "drako/concurrency/lockfree_mpsc_queue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drako::lockfree;
+
+struct TestNode : IntrusiveQueueHook
+{
+    explicit TestNode(int v) noexcept
+        : value{ v } {}
+
+    int value;
+};
+
+GTEST_TEST(SR_MW_IntrusiveQueue, SingleThreadOps)
+{
+    SR_MW_IntrusiveQueue<TestNode> queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.deque(), nullptr);
+
+    std::deque<TestNode> nodes; // nodes are neither copyable nor movable
+    for (auto i = 0; i < 10; ++i)
+        nodes.emplace_back(i);
+
+    for (auto k = 0; k < 3; ++k) // nodes can be inserted again after removal
+    {
+        for (auto& n : nodes)
+            queue.enque(&n);
+        EXPECT_FALSE(queue.empty());
+
+        for (auto i = 0; i < 10; ++i)
+        {
+            const auto n = queue.deque();
+            ASSERT_NE(n, nullptr);
+            EXPECT_EQ(n->value, i);
+        }
+        EXPECT_EQ(queue.deque(), nullptr);
+        EXPECT_TRUE(queue.empty());
+    }
+}
+
+GTEST_TEST(SR_MW_Queue, SingleThreadOps)
+{
+    SR_MW_Queue<std::string> queue{ 4 };
+    for (auto i = 0; i < 10; ++i)
+        queue.enque(std::to_string(i));
+
+    std::string s;
+    ASSERT_TRUE(queue.deque(s));
+    EXPECT_EQ(s, "0");
+
+    std::vector<std::string> drained;
+    EXPECT_EQ(queue.drain([&](std::string&& v) { drained.push_back(std::move(v)); }), 9);
+    EXPECT_EQ(drained.front(), "1");
+    EXPECT_EQ(drained.back(), "9");
+    EXPECT_TRUE(queue.empty());
+}
+
+GTEST_TEST(SR_MW_Queue, GrowsBeyondPool)
+{
+    // the pool is full after max_chunks nodes, the others come from the heap
+    SR_MW_Queue<std::string> queue{ 1 };
+    const auto               items = 4 * Pool<int>::max_chunks;
+    for (std::size_t i = 0; i < items; ++i)
+        queue.enque(std::to_string(i));
+
+    std::size_t count = 0;
+    queue.drain([&](std::string&& v) { EXPECT_EQ(v, std::to_string(count++)); });
+    EXPECT_EQ(count, items);
+
+    // nodes of both kinds are recycled
+    for (std::size_t i = 0; i < items; ++i)
+        queue.enque(std::to_string(i));
+    EXPECT_EQ(queue.drain([](std::string&&) {}), items);
+}
+
+GTEST_TEST(SR_MW_Queue, MultiThreadOps)
+{
+    const std::uint32_t writers = 4, items = 50'000;
+
+    SR_MW_Queue<std::uint32_t> queue;
+    std::vector<std::thread>   threads;
+    for (std::uint32_t w = 0; w < writers; ++w)
+        threads.emplace_back([&, w]() {
+            for (std::uint32_t i = 0; i < items; ++i)
+                queue.enque(w * items + i);
+        });
+
+    // elements of the same writer are removed in insertion order
+    std::vector<std::uint32_t> last(writers, 0);
+    std::size_t                count = 0;
+    while (count < writers * items)
+    {
+        const auto n = queue.drain([&](std::uint32_t v) {
+            const auto w = v / items;
+            EXPECT_GE(v + 1, last[w]);
+            last[w] = v + 1;
+        });
+        if (n == 0)
+            std::this_thread::yield();
+        count += n;
+    }
+
+    for (auto& t : threads)
+        t.join();
+    EXPECT_TRUE(queue.empty());
+}
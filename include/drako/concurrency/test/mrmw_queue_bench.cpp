@@ -0,0 +1,92 @@
+/// @brief Throughput benchmark of MR_MW_Queue against a mutex protected queue.
+///
+/// Each thread alternates enqueue and dequeue operations on the shared queue,
+/// the same workload is repeated with an increasing number of threads.
+
+#include "drako/concurrency/lockfree_mrmw_queue.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace drako::lockfree;
+
+const std::size_t QUEUE_CAPACITY = 1024;
+const std::size_t OPS_PER_THREAD = 200'000;
+
+// Baseline queue guarded by a single lock.
+class LockedQueue
+{
+public:
+    explicit LockedQueue(std::size_t capacity)
+        : _capacity{ capacity } {}
+
+    [[nodiscard]] bool enque(int value)
+    {
+        const std::scoped_lock lock{ _mutex };
+        if (std::size(_queue) == _capacity)
+            return false;
+        _queue.push(value);
+        return true;
+    }
+
+    [[nodiscard]] bool deque(int& value)
+    {
+        const std::scoped_lock lock{ _mutex };
+        if (std::empty(_queue))
+            return false;
+        value = _queue.front();
+        _queue.pop();
+        return true;
+    }
+
+private:
+    std::mutex      _mutex;
+    std::queue<int> _queue;
+    std::size_t     _capacity;
+};
+
+template <typename Queue>
+[[nodiscard]] double run(std::size_t threads)
+{
+    Queue queue{ QUEUE_CAPACITY };
+
+    auto work = [&]() {
+        for (std::size_t i = 0; i < OPS_PER_THREAD; ++i)
+        {
+            while (!queue.enque(static_cast<int>(i)))
+                std::this_thread::yield();
+
+            int out;
+            while (!queue.deque(out))
+                std::this_thread::yield();
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < threads; ++t)
+            workers.emplace_back(work);
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    // millions of operations per second
+    return (2.0 * OPS_PER_THREAD * threads) / elapsed.count() / 1e6;
+}
+
+int main()
+{
+    std::cout << "[threads]\t[MR_MW_Queue Mops/s]\t[LockedQueue Mops/s]\n"
+              << std::fixed << std::setprecision(2);
+    for (std::size_t threads = 1; threads <= 32; threads *= 2)
+        std::cout << threads
+                  << "\t\t" << run<MR_MW_Queue<int>>(threads)
+                  << "\t\t\t" << run<LockedQueue>(threads) << '\n';
+    return EXIT_SUCCESS;
+}
@@ -2,25 +2,16 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <numeric>
 #include <thread>
+#include <vector>
 
-const auto  TEST_THREAD_COUNT = 10;
-const auto  TEST_OBJECT_COUNT = 1000 * TEST_THREAD_COUNT;
-bool        results[TEST_THREAD_COUNT];
-std::thread workers[TEST_THREAD_COUNT];
+const auto TEST_THREAD_COUNT = 10;
+const auto TEST_OBJECT_COUNT = 1000 * TEST_THREAD_COUNT;
 
 using namespace drako::lockfree;
 
-void test_task(MR_MW_Queue<int>& q, std::size_t thread_index) noexcept
-{
-    for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
-    {
-        if (int out; !q.deque(out))
-            return;
-    }
-    results[thread_index] = true;
-}
-
 GTEST_TEST(MR_MW_Queue, SingleThread)
 {
     const auto     capacity = 100;
@@ -44,16 +35,98 @@ GTEST_TEST(MR_MW_Queue, SingleThread)
     EXPECT_FALSE(queue.deque(out));
 }
 
+GTEST_TEST(MR_MW_Queue, SingleThreadBulk)
+{
+    const auto       capacity = 100;
+    MR_MW_Queue<int> queue{ capacity };
+
+    std::vector<int> in(150), out(150);
+    std::iota(std::begin(in), std::end(in), 0);
+
+    // only a prefix fits in the queue
+    EXPECT_EQ(queue.enque_bulk(in), capacity);
+    EXPECT_EQ(queue.enque_bulk(in), 0);
+
+    EXPECT_EQ(queue.deque_bulk({ std::data(out), 60 }), 60);
+    EXPECT_EQ(queue.enque_bulk({ std::data(in) + 100, 50 }), 50);
+
+    // wrap around the end of the buffer
+    EXPECT_EQ(queue.deque_bulk(out), 90);
+    for (auto i = 0; i < 90; ++i)
+        EXPECT_EQ(out[i], i + 60);
+
+    EXPECT_EQ(queue.deque_bulk(out), 0);
+}
+
 GTEST_TEST(MR_MW_Queue, MultiThread)
 {
-    MR_MW_Queue<int> queue{ TEST_OBJECT_COUNT };
+    MR_MW_Queue<int> queue{ 64 };
 
-    for (auto i = 0; i < TEST_THREAD_COUNT; ++i)
-        workers[i] = std::thread(test_task, std::ref(queue), i);
+    // half of the workers produce, the other half consume
+    std::vector<std::atomic<int>> consumed(TEST_OBJECT_COUNT);
+    std::atomic<int>              remaining = TEST_OBJECT_COUNT;
 
+    auto produce = [&](int first) {
+        for (auto i = first; i < TEST_OBJECT_COUNT; i += TEST_THREAD_COUNT / 2)
+            while (!queue.enque(i))
+                std::this_thread::yield();
+    };
+    auto consume = [&]() {
+        while (remaining > 0)
+        {
+            if (int out; queue.deque(out))
+            {
+                ++consumed[out];
+                --remaining;
+            }
+            else
+                std::this_thread::yield();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (auto i = 0; i < TEST_THREAD_COUNT / 2; ++i)
+    {
+        workers.emplace_back(produce, i);
+        workers.emplace_back(consume);
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+        EXPECT_EQ(consumed[i], 1) << "error at item " << i;
+}
+
+GTEST_TEST(MR_MW_Queue, BlockingWait)
+{
+    MR_MW_Queue<int> queue{ 64 };
+
+    // consumers park on the empty queue until they are stopped
+    std::vector<std::atomic<int>> consumed(TEST_OBJECT_COUNT);
+    std::atomic_flag              stop;
+
+    auto consume = [&]() {
+        int batch[8];
+        for (std::size_t n; (n = queue.deque_bulk_wait(batch, [&]() { return stop.test(); })) > 0;)
+            for (std::size_t i = 0; i < n; ++i)
+                ++consumed[batch[i]];
+    };
+
+    std::vector<std::thread> workers;
+    for (auto i = 0; i < TEST_THREAD_COUNT / 2; ++i)
+        workers.emplace_back(consume);
+
+    for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+        while (!queue.enque(i))
+            std::this_thread::yield();
+    while (!queue.empty())
+        std::this_thread::yield();
+
+    stop.test_and_set();
+    queue.wake_consumers();
     for (auto& worker : workers)
         worker.join();
 
-    for (auto result : results)
-        EXPECT_TRUE(result);
-}
\ No newline at end of file
+    for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+        EXPECT_EQ(consumed[i], 1) << "error at item " << i;
+}
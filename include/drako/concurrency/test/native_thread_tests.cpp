@@ -0,0 +1,115 @@
+#include "drako/concurrency/native_thread.hpp"
+
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+using namespace drako::sys;
+
+namespace
+{
+    struct Shared
+    {
+        std::atomic<bool> release = false;
+        std::atomic<int>  cpu     = -1;
+    };
+
+    void* park(void* args)
+    {
+        auto& shared = *static_cast<Shared*>(args);
+        shared.release.wait(false); // blocked, so that a realtime thread doesn't starve the test
+        shared.cpu = sched_getcpu();
+        return nullptr;
+    }
+} // namespace
+
+GTEST_TEST(NativeThread, NameAndStack)
+{
+    Shared        shared;
+    native_thread thread{ park, { .stack_size = 256 * 1024, .name = "drako-render-thread", .args = &shared } };
+    EXPECT_NE(thread.id(), 0);
+
+    std::error_code ec;
+    thread.set_name("drako-io", ec);
+    EXPECT_FALSE(ec);
+
+    shared.release = true;
+    shared.release.notify_one();
+    thread.join();
+}
+
+GTEST_TEST(NativeThread, Affinity)
+{
+    Shared        shared;
+    native_thread thread{ park, { .name = "drako-pinned", .args = &shared } };
+
+    const auto available = thread.affinity();
+    ASSERT_TRUE(available.any());
+
+    // pin to the first available processor
+    std::size_t cpu = 0;
+    while (!available.test(cpu))
+        ++cpu;
+    ASSERT_TRUE(thread.core_affinity(native_cpu_core{ static_cast<std::uint32_t>(cpu) }));
+
+    const auto pinned = thread.affinity();
+    EXPECT_EQ(pinned.count(), 1);
+    EXPECT_TRUE(pinned.test(cpu));
+    EXPECT_EQ(thread.core_affinity().cpu_number, cpu);
+
+    shared.release = true;
+    shared.release.notify_one();
+    thread.join();
+    EXPECT_EQ(shared.cpu, static_cast<int>(cpu));
+}
+
+GTEST_TEST(NativeThread, Priority)
+{
+    Shared        shared;
+    native_thread thread{ park, { .args = &shared } };
+
+    // raising the nice value never requires privileges
+    thread.set_priority({ .policy = native_thread::scheduling::normal, .level = 5 });
+    auto p = thread.priority();
+    EXPECT_EQ(p.policy, native_thread::scheduling::normal);
+    EXPECT_EQ(p.level, 5);
+
+    // realtime scheduling is allowed only to privileged users
+    std::error_code ec;
+    thread.set_priority({ .policy = native_thread::scheduling::realtime, .level = 10 }, ec);
+    if (!ec)
+    {
+        p = thread.priority();
+        EXPECT_EQ(p.policy, native_thread::scheduling::realtime);
+        EXPECT_EQ(p.level, 10);
+    }
+    else
+        EXPECT_EQ(ec.value(), EPERM);
+
+    shared.release = true;
+    shared.release.notify_one();
+    thread.join();
+}
+
+GTEST_TEST(NativeThread, CreatorReturnsBeforeStartup)
+{
+    // the creator frame is released right after the constructor returns,
+    // while the new thread may still be publishing its id
+    const auto noop = [](void*) -> void* { return nullptr; };
+    for (auto i = 0; i < 1'000; ++i)
+    {
+        native_thread thread{ noop, {} };
+        EXPECT_NE(thread.id(), 0);
+        thread.join();
+    }
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "drako/concurrency/parallel_algorithms.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <new>
+#include <numeric>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace drako;
+
+GTEST_TEST(ParallelAlgorithms, ParallelFor)
+{
+    JobScheduler scheduler{ { .workers = 4, .queue_size = 64 } };
+
+    for (const std::size_t size : { 0, 1, 100, 10'000, 1'000'000 })
+    {
+        std::vector<std::atomic<int>> visits(size);
+        parallel_for(scheduler, 0, size, [&](std::size_t i) { ++visits[i]; }, 64);
+        EXPECT_TRUE(std::all_of(std::cbegin(visits), std::cend(visits), [](const auto& v) { return v == 1; }));
+    }
+
+    std::vector<int> values(100'000, 1);
+    parallel_for(scheduler, std::span{ values }, [](int& v) { v *= 2; });
+    EXPECT_EQ(std::accumulate(std::cbegin(values), std::cend(values), 0), 200'000);
+}
+
+GTEST_TEST(ParallelAlgorithms, ParallelTransform)
+{
+    JobScheduler scheduler{ { .workers = 4, .queue_size = 64 } };
+
+    std::vector<int> src(100'000);
+    std::iota(std::begin(src), std::end(src), 0);
+
+    std::vector<long long> dst(std::size(src));
+    parallel_transform(scheduler, std::span<const int>{ src }, std::span{ dst },
+        [](int v) { return static_cast<long long>(v) * v; });
+
+    for (std::size_t i = 0; i < std::size(src); ++i)
+        ASSERT_EQ(dst[i], static_cast<long long>(src[i]) * src[i]);
+}
+
+GTEST_TEST(ParallelAlgorithms, ParallelSort)
+{
+    JobScheduler scheduler{ { .workers = 3, .queue_size = 64 } };
+
+    std::mt19937 generator{ 42 };
+    for (const std::size_t size : { 0, 10, 5'000, 100'000, 1'000'003 })
+    {
+        std::vector<int> values(size);
+        for (auto& v : values)
+            v = static_cast<int>(generator() % 1000);
+
+        auto expected = values;
+        std::sort(std::begin(expected), std::end(expected), std::greater<>{});
+
+        parallel_sort(scheduler, std::span{ values }, std::greater<>{});
+        ASSERT_EQ(values, expected);
+    }
+}
+
+GTEST_TEST(ParallelAlgorithms, ParallelForSubmitFailure)
+{
+    // a single worker with a single slot queue can keep 64 jobs alive
+    JobScheduler scheduler{ { .workers = 1, .queue_size = 1 } };
+
+    // each job of the chain waits for the next one, the last finds the job storage exhausted
+    std::vector<std::atomic<int>> visits(10'000);
+    auto                          failed = false;
+    std::function<void(int)>      chain  = [&](int depth) {
+        if (depth < 64)
+        {
+            JobCounter counter;
+            scheduler.submit([&, depth]() { chain(depth + 1); }, counter);
+            scheduler.wait(counter);
+            return;
+        }
+        try
+        {
+            parallel_for(scheduler, 0, std::size(visits), [&](std::size_t i) { ++visits[i]; }, 64);
+        }
+        catch (const std::bad_alloc&)
+        {
+            failed = true;
+        }
+    };
+    chain(0);
+
+    EXPECT_TRUE(failed);
+    EXPECT_TRUE(std::all_of(std::cbegin(visits), std::cend(visits), [](const auto& v) { return v == 1; }));
+
+    // the storage of the jobs is available again
+    std::vector<int> values(10'000, 1);
+    parallel_for(scheduler, std::span{ values }, [](int& v) { v *= 2; }, 64);
+    EXPECT_EQ(std::accumulate(std::cbegin(values), std::cend(values), 0), 20'000);
+}
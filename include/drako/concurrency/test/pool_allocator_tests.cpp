@@ -0,0 +1,167 @@
+#include "drako/concurrency/lockfree_pool_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+const auto TEST_THREAD_COUNT = 4;
+const auto TEST_OBJECT_COUNT = 1000 * TEST_THREAD_COUNT;
+
+using namespace drako::lockfree;
+
+GTEST_TEST(StaticPool, SingleThread)
+{
+    const auto capacity = 64;
+    auto       pool     = std::make_unique<StaticPool<int, capacity, 8>>();
+
+    std::vector<int*> blocks;
+    for (auto i = 0; i < capacity; ++i)
+        blocks.push_back(pool->allocate(1));
+    EXPECT_THROW((void)pool->allocate(1), std::bad_alloc);
+
+    // all the blocks must be distinct
+    std::sort(std::begin(blocks), std::end(blocks));
+    EXPECT_EQ(std::adjacent_find(std::begin(blocks), std::end(blocks)), std::end(blocks));
+
+    for (auto p : blocks)
+        pool->deallocate(p, 1);
+
+    const auto stats = pool->stats();
+    EXPECT_GT(stats.cached, 0);
+    EXPECT_GT(stats.refills, 0);
+    EXPECT_GT(stats.flushes, 0);
+
+    // blocks flushed by the magazine must be available again
+    for (auto i = 0; i < capacity; ++i)
+        blocks[i] = pool->allocate(1);
+    for (auto p : blocks)
+        pool->deallocate(p, 1);
+}
+
+GTEST_TEST(StaticPool, MultiThread)
+{
+    const auto capacity = 1024;
+    auto       pool     = std::make_unique<StaticPool<int, capacity>>();
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&pool, t]() {
+            std::vector<int*> owned;
+            for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+            {
+                if (owned.size() < 64)
+                {
+                    // write a marker to detect blocks handed out twice
+                    owned.push_back(pool->allocate(1));
+                    *owned.back() = t;
+                }
+                else
+                {
+                    for (auto p : owned)
+                    {
+                        EXPECT_EQ(*p, t);
+                        pool->deallocate(p, 1);
+                    }
+                    owned.clear();
+                }
+            }
+            for (auto p : owned)
+                pool->deallocate(p, 1);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    // blocks left in the magazines of terminated threads are still reachable
+    // by new threads that reuse the same index
+    std::vector<int*> blocks;
+    std::thread{ [&]() {
+        for (auto i = 0; i < capacity - 32 * TEST_THREAD_COUNT; ++i)
+            blocks.push_back(pool->allocate(1));
+    } }.join();
+    EXPECT_EQ(std::size(blocks), capacity - 32 * TEST_THREAD_COUNT);
+}
+
+GTEST_TEST(Pool, GrowKeepsAddresses)
+{
+    const auto chunk = 16;
+    Pool<int>  pool{ chunk };
+    EXPECT_EQ(pool.capacity(), chunk);
+
+    std::vector<int*> blocks;
+    for (auto i = 0; i < chunk * 3; ++i)
+    {
+        blocks.push_back(pool.allocate(1));
+        *blocks.back() = i;
+    }
+    EXPECT_EQ(pool.capacity(), chunk * 3);
+
+    // objects allocated before the pool grew are untouched
+    for (auto i = 0; i < chunk * 3; ++i)
+        EXPECT_EQ(*blocks[i], i);
+
+    for (auto p : blocks)
+        pool.deallocate(p, 1);
+}
+
+GTEST_TEST(Pool, StaleHandle)
+{
+    Pool<int> pool{ 4 };
+
+    const auto p = pool.allocate(1);
+    const auto h = pool.handle(p);
+    EXPECT_EQ(pool.get(h), p);
+
+    pool.deallocate(p, 1);
+    EXPECT_EQ(pool.get(h), nullptr);
+
+    // the slot is recycled with a new generation
+    const auto q = pool.allocate(1);
+    EXPECT_EQ(q, p);
+    EXPECT_NE(pool.handle(q), h);
+}
+
+GTEST_TEST(Pool, MaxChunks)
+{
+    Pool<int> pool{ 1 };
+    for (std::size_t i = 0; i < Pool<int>::max_chunks; ++i)
+        (void)pool.allocate(1);
+    EXPECT_THROW((void)pool.allocate(1), std::bad_alloc);
+}
+
+GTEST_TEST(Pool, MultiThread)
+{
+    Pool<int> pool{ 8 };
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&pool, t]() {
+            std::vector<int*> owned;
+            for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+            {
+                if (owned.size() < 16)
+                {
+                    owned.push_back(pool.allocate(1));
+                    *owned.back() = t;
+                }
+                else
+                {
+                    for (auto p : owned)
+                    {
+                        EXPECT_EQ(*p, t);
+                        pool.deallocate(p, 1);
+                    }
+                    owned.clear();
+                }
+            }
+            for (auto p : owned)
+                pool.deallocate(p, 1);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_LE(pool.capacity(), 8 * Pool<int>::max_chunks);
+}
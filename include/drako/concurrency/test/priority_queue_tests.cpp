@@ -0,0 +1,107 @@
+#include "drako/concurrency/lockfree_priority_queue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+const auto TEST_THREAD_COUNT = 4;
+const auto TEST_OBJECT_COUNT = 1000 * TEST_THREAD_COUNT;
+
+using namespace drako::lockfree;
+
+GTEST_TEST(PriorityQueue, SingleHeapIsExact)
+{
+    PriorityQueue<int, int> queue{ 1 };
+
+    for (auto p : { 5, 1, 4, 2, 3 })
+        queue.push(p, p * 10);
+    EXPECT_EQ(queue.size(), 5);
+
+    for (auto p = 1; p <= 5; ++p)
+    {
+        int out;
+        ASSERT_TRUE(queue.try_pop_min(out));
+        EXPECT_EQ(out, p * 10);
+    }
+
+    int out;
+    EXPECT_FALSE(queue.try_pop_min(out));
+    EXPECT_TRUE(queue.empty());
+}
+
+GTEST_TEST(PriorityQueue, UrgentBeforeBackground)
+{
+    PriorityQueue<int, unsigned> queue{ 8 };
+
+    // a few urgent elements hidden among many background ones
+    for (auto i = 0; i < 1000; ++i)
+        queue.push(10, 0);
+    for (auto i = 0; i < 4; ++i)
+        queue.push(0, 1);
+
+    // all the urgent elements are found within a relaxed number of pops
+    int found = 0;
+    for (auto i = 0; i < 64; ++i)
+    {
+        int out;
+        ASSERT_TRUE(queue.try_pop_min(out));
+        found += out;
+    }
+    EXPECT_EQ(found, 4);
+}
+
+GTEST_TEST(PriorityQueue, BulkPop)
+{
+    PriorityQueue<int, int> queue{ 4 };
+    for (auto i = 0; i < 100; ++i)
+        queue.push(i, i);
+
+    std::vector<int> out(100);
+    std::size_t      count = 0;
+    while (count < std::size(out))
+    {
+        const auto n = queue.try_pop_min_bulk(std::span{ out }.subspan(count));
+        ASSERT_GT(n, 0);
+        count += n;
+    }
+    EXPECT_EQ(queue.try_pop_min_bulk(out), 0);
+
+    std::sort(std::begin(out), std::end(out));
+    for (auto i = 0; i < 100; ++i)
+        EXPECT_EQ(out[i], i);
+}
+
+GTEST_TEST(PriorityQueue, MultiThread)
+{
+    PriorityQueue<int, int> queue{ 2 * TEST_THREAD_COUNT };
+
+    std::atomic<long long>   sum    = 0;
+    std::atomic<int>         popped = 0;
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&]() {
+            for (auto i = 0; i < TEST_OBJECT_COUNT; ++i)
+                queue.push(i % 7, i);
+        });
+    for (auto t = 0; t < TEST_THREAD_COUNT; ++t)
+        threads.emplace_back([&]() {
+            int batch[16];
+            while (popped.load() < TEST_THREAD_COUNT * TEST_OBJECT_COUNT)
+            {
+                const auto n = queue.try_pop_min_bulk(batch);
+                for (std::size_t i = 0; i < n; ++i)
+                    sum += batch[i];
+                popped += static_cast<int>(n);
+                if (n == 0)
+                    std::this_thread::yield();
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(sum, TEST_THREAD_COUNT * (TEST_OBJECT_COUNT * (TEST_OBJECT_COUNT - 1LL) / 2));
+}
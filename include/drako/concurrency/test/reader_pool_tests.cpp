@@ -1,54 +1,223 @@
-#include "drako/io/async_reader_pool.hpp"
-#include "drako/io/output_file_handle.hpp"
+#include "drako/concurrency/async_reader_pool.hpp"
 
 #include <gtest/gtest.h>
 #include <rio/input_file_handle.hpp>
 
+#include <atomic>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <set>
 #include <string>
-#include <thread>
+#include <vector>
 
-using namespace std::chrono_literals;
+using namespace drako;
+
+using Request    = AsyncReaderPool::Request;
+using Completion = AsyncReaderPool::Completion;
 
 GTEST_TEST(AsyncReaderPool, ConcurrentExecution)
 {
-    const std::string text[3] = { "aaaaa", "", "" };
+    const std::string text[3] = { "aaaaa", "bbbbbbbbbb", "ccccccccccccccc" };
 
     const auto file_count = std::size(text);
     const auto temp_dir   = std::filesystem::temp_directory_path();
+    const auto filename   = [&](auto i) { return temp_dir / ("drako-reader-pool-" + std::to_string(i)); };
 
-    char filename[L_tmpnam];
-    ASSERT_TRUE(std::tmpnam(filename));
-    try
+    for (std::size_t i = 0; i < file_count; ++i)
+        std::ofstream{ filename(i) } << text[i];
     {
-        for (auto i = 0; i < file_count; ++i)
+        AsyncReaderPool pool{ { .workers = 4, .submit_queue_size = 100, .output_queue_size = 100 } };
+
+        std::vector<rio::UniqueInputFile> files;
+        for (std::size_t i = 0; i < file_count; ++i)
+            files.emplace_back(filename(i));
+
+        std::vector<std::string> buffers(100);
+        std::vector<Request>     requests(100);
+        std::set<std::uint64_t>  tickets;
+        for (std::size_t i = 0; i < std::size(requests); ++i)
         {
-            const auto test_file_path = temp_dir / (filename + std::to_string(i));
+            buffers[i].resize(std::size(text[i % file_count]));
+            requests[i] = { .src = files[i % file_count].native_handle(),
+                .dst = std::as_writable_bytes(std::span{ buffers[i] }), .offset = 0 };
 
-            std::ofstream{ test_file_path } << text[i];
+            const auto ticket = pool.submit(&requests[i]);
+            ASSERT_TRUE(ticket);
+            EXPECT_TRUE(tickets.insert(static_cast<std::uint64_t>(*ticket)).second); // tickets are unique
         }
 
-        AsyncReaderPool pool{ { .workers = 4, .submit_queue_size = 100, .output_queue_size = 100 } };
+        std::array<Completion, 16> completed;
+        for (std::size_t count = 0; count < std::size(requests);)
+        {
+            const auto n = pool.poll(completed);
+            for (const auto& c : std::span{ completed }.first(n))
+            {
+                const auto i = static_cast<std::size_t>(c.request - std::data(requests));
+                ASSERT_FALSE(c.error);
+                EXPECT_EQ(tickets.erase(static_cast<std::uint64_t>(c.ticket)), 1);
+                EXPECT_EQ(buffers[i], text[i % file_count]);
+            }
+            count += n;
+        }
+    }
+    for (std::size_t i = 0; i < file_count; ++i)
+        std::filesystem::remove(filename(i));
+}
+
+GTEST_TEST(AsyncReaderPool, ManyWorkers)
+{
+    const std::string text     = "0123456789abcdef";
+    const auto        filename = std::filesystem::temp_directory_path() / "drako-reader-pool-workers";
+    std::ofstream{ filename } << text;
+
+    for (const auto backend : { AsyncReaderPool::Backend::threads, AsyncReaderPool::Backend::io_uring })
+    {
+        rio::UniqueInputFile file{ filename };
+        AsyncReaderPool      pool{ { .workers = 12, .submit_queue_size = 64, .output_queue_size = 64, .backend = backend } };
+
+        std::vector<char>    buffers(std::size(text));
+        std::vector<Request> requests(std::size(text));
+        for (std::size_t i = 0; i < std::size(requests); ++i)
+        {
+            requests[i] = { .src = file.native_handle(), .dst = std::as_writable_bytes(std::span{ &buffers[i], 1 }), .offset = i };
+            ASSERT_TRUE(pool.submit(&requests[i]));
+        }
+
+        std::array<Completion, 4> completed;
+        for (std::size_t count = 0; count < std::size(requests);)
+        {
+            const auto n = pool.poll(completed);
+            for (const auto& c : std::span{ completed }.first(n))
+                EXPECT_FALSE(c.error);
+            count += n;
+        }
+        EXPECT_EQ(std::string(std::begin(buffers), std::end(buffers)), text);
+    }
+    std::filesystem::remove(filename);
+}
+
+GTEST_TEST(AsyncReaderPool, Callbacks)
+{
+    AsyncReaderPoolMock pool;
+
+    std::byte  buffer[8];
+    std::size_t called = 0;
+    const Request r    = { .src = {}, .dst = buffer, .offset = 0,
+        .callback = [&](const Completion& c) { called += c.bytes; } };
+    const Request s    = { .src = {}, .dst = buffer, .offset = 0 };
+
+    ASSERT_TRUE(pool.submit(&r));
+    const auto ticket = pool.submit(&s);
+    ASSERT_TRUE(ticket);
+
+    // completions with a callback are consumed by the poll
+    std::array<Completion, 4> completed;
+    ASSERT_EQ(pool.poll(completed), 1);
+    EXPECT_EQ(completed[0].request, &s);
+    EXPECT_EQ(completed[0].ticket, *ticket);
+    EXPECT_EQ(called, std::size(buffer));
+}
+
+GTEST_TEST(AsyncReaderPool, MergesAdjacentReads)
+{
+    std::string text;
+    for (auto i = 0; i < 64 * 1024; ++i)
+        text.push_back(static_cast<char>('a' + i % 26));
+
+    const auto filename = std::filesystem::temp_directory_path() / "drako-reader-pool-merge";
+    std::ofstream{ filename } << text;
+    {
+        rio::UniqueInputFile file{ filename };
+        AsyncReaderPool      pool{ { .workers = 1, .submit_queue_size = 256, .output_queue_size = 256,
+            .merge_max_gap = 64, .merge_max_size = 16 * 1024 } };
 
-        std::vector<UniqueInputFile> files;
-        for (auto i = 0; i < file_count; ++i)
-            files.emplace_back(temp_dir / (filename + std::to_string(i)));
+        // keep the only worker busy until all the requests are queued,
+        // so that it finds them in the same batches
+        std::atomic_flag entered, released;
+        std::byte        byte;
+        const Request    gate = { .src = file.native_handle(), .dst = { &byte, 1 }, .offset = 0,
+            .callback = [&](const Completion&) {
+                entered.test_and_set();
+                entered.notify_one();
+                released.wait(false);
+            },
+            .executor = AsyncReaderPool::Executor::io_worker };
+        ASSERT_TRUE(pool.submit(&gate));
+        entered.wait(false);
 
-        decltype(pool)::Request requests[100];
-        for (const auto& r : requests)
+        // small reads separated by short gaps, like the assets of a bundle
+        std::vector<std::string> buffers(128);
+        std::vector<Request>     requests(128);
+        for (std::size_t i = 0; i < std::size(requests); ++i)
         {
-            ASSERT_TRUE(pool.submit(0, std::addressof(r)));
+            buffers[i].resize(400);
+            requests[i] = { .src = file.native_handle(),
+                .dst = std::as_writable_bytes(std::span{ buffers[i] }), .offset = i * 432 };
+            ASSERT_TRUE(pool.submit(&requests[i]));
         }
+        released.test_and_set();
+        released.notify_one();
 
-        std::this_thread::sleep_for(1s);
+        std::array<Completion, 16> completed;
+        for (std::size_t count = 0; count < std::size(requests);)
+        {
+            const auto n = pool.poll(completed);
+            for (const auto& c : std::span{ completed }.first(n))
+            {
+                const auto i = static_cast<std::size_t>(c.request - std::data(requests));
+                ASSERT_FALSE(c.error);
+                ASSERT_EQ(c.bytes, 400);
+                EXPECT_EQ(buffers[i], text.substr(i * 432, 400));
+            }
+            count += n;
+        }
+
+        // neighbours found in the same batch share a read, the gate is served by its own
+        const auto stats = pool.stats();
+        EXPECT_GT(stats.merged, 0);
+        EXPECT_LT(stats.issued, std::size(requests));
+        EXPECT_LE(stats.merged, std::size(requests));
     }
-    catch (const std::exception& e)
+    std::filesystem::remove(filename);
+}
+
+GTEST_TEST(AsyncReaderPool, ReadsUpToEndOfFile)
+{
+    const std::string text(1000, 'x');
+    const auto        filename = std::filesystem::temp_directory_path() / "drako-reader-pool-eof";
+    std::ofstream{ filename } << text;
     {
-        for (auto i = 0; i < file_count; ++i)
+        rio::UniqueInputFile file{ filename };
+
+        // every backend keeps reading after a short read and reports the bytes available
+        for (const auto backend : { AsyncReaderPool::Backend::threads, AsyncReaderPool::Backend::io_uring })
         {
-            const auto test_file_path = temp_dir / (filename + std::to_string(i));
-            std::filesystem::remove(test_file_path);
+            AsyncReaderPool pool{ { .workers = 1, .submit_queue_size = 16, .output_queue_size = 16, .backend = backend } };
+
+            std::vector<std::byte> whole(4096), head(50), tail(100);
+            const Request          requests[] = {
+                { .src = file.native_handle(), .dst = whole, .offset = 0 },
+                { .src = file.native_handle(), .dst = head, .offset = 900 }, // merged with the next one
+                { .src = file.native_handle(), .dst = tail, .offset = 960 },
+            };
+            for (const auto& r : requests)
+                ASSERT_TRUE(pool.submit(&r));
+
+            const std::size_t          expected[] = { 1000, 50, 40 };
+            std::array<Completion, 16> completed;
+            for (std::size_t count = 0; count < std::size(requests);)
+            {
+                const auto n = pool.poll(completed);
+                for (const auto& c : std::span{ completed }.first(n))
+                {
+                    const auto i = static_cast<std::size_t>(c.request - std::data(requests));
+                    EXPECT_FALSE(c.error);
+                    EXPECT_EQ(c.bytes, expected[i]);
+                }
+                count += n;
+            }
         }
     }
-}
\ No newline at end of file
+    std::filesystem::remove(filename);
+}
@@ -0,0 +1,113 @@
+#include "drako/concurrency/task_graph.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace drako;
+
+using Resource = TaskGraph::Resource;
+
+GTEST_TEST(TaskGraph, Dependencies)
+{
+    TaskGraph  graph;
+    const auto input = Resource{ 0 }, assets = Resource{ 1 }, commands = Resource{ 2 };
+
+    const auto a = graph.add({ .name = "input", .task = []() {}, .reads = {}, .writes = { input } });
+    const auto b = graph.add({ .name = "assets", .task = []() {}, .reads = { input }, .writes = { assets } });
+    const auto c = graph.add({ .name = "render", .task = []() {}, .reads = { input }, .writes = { commands } });
+    const auto d = graph.add({ .name = "submit", .task = []() {}, .reads = { assets, commands }, .writes = {} });
+    const auto e = graph.add({ .name = "input", .task = []() {}, .reads = {}, .writes = { input } });
+
+    JobScheduler scheduler{ { .workers = 2, .queue_size = 64 } };
+    graph.run(scheduler);
+
+    using IDs = std::vector<TaskGraph::TaskID>;
+    EXPECT_EQ(graph.dependencies(a), IDs{});
+    EXPECT_EQ(graph.dependencies(b), IDs{ a });
+    EXPECT_EQ(graph.dependencies(c), IDs{ a });
+    EXPECT_EQ(graph.dependencies(d), (IDs{ b, c }));
+    EXPECT_EQ(graph.dependencies(e), (IDs{ b, c })); // must wait for the readers
+}
+
+GTEST_TEST(TaskGraph, ExecutionOrder)
+{
+    TaskGraph    graph;
+    JobScheduler scheduler{ { .workers = 4, .queue_size = 256 } };
+
+    // a chain of writers of the same resource, each fanning out to some readers
+    const auto       chain = 20, readers = 10;
+    std::atomic<int> stage = 0, failures = 0;
+    for (auto i = 0; i < chain; ++i)
+    {
+        (void)graph.add({ .name = "writer", .task = [&, i]() {
+                             if (stage.load() != i * (readers + 1))
+                                 ++failures;
+                             ++stage;
+                         },
+            .reads = {}, .writes = { Resource{ 0 } } });
+        for (auto k = 0; k < readers; ++k)
+            (void)graph.add({ .name = "reader", .task = [&, i]() {
+                                 const auto s = stage.load();
+                                 if (s <= i * (readers + 1) || s > (i + 1) * (readers + 1))
+                                     ++failures;
+                                 ++stage;
+                             },
+                .reads = { Resource{ 0 } }, .writes = {} });
+    }
+
+    for (auto frame = 0; frame < 10; ++frame)
+    {
+        stage = 0;
+        graph.run(scheduler);
+        ASSERT_EQ(stage, chain * (readers + 1));
+    }
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(graph.builds(), 1); // same topology across frames
+}
+
+GTEST_TEST(TaskGraph, Rebuild)
+{
+    TaskGraph        graph;
+    JobScheduler     scheduler{ { .workers = 2, .queue_size = 64 } };
+    std::atomic<int> executed = 0;
+
+    const auto a = graph.add({ .name = "a", .task = [&]() { ++executed; }, .reads = {}, .writes = { Resource{ 0 } } });
+    const auto b = graph.add({ .name = "b", .task = [&]() { ++executed; }, .reads = { Resource{ 0 } }, .writes = {} });
+    graph.run(scheduler);
+    EXPECT_EQ(executed, 2);
+
+    graph.remove(a);
+    const auto c = graph.add({ .name = "c", .task = [&]() { ++executed; }, .reads = {}, .writes = { Resource{ 0 } } });
+    graph.run(scheduler);
+    EXPECT_EQ(executed, 4);
+    EXPECT_EQ(graph.builds(), 2);
+    EXPECT_EQ(graph.size(), 2);
+
+    // the new task comes after the reader
+    EXPECT_TRUE(std::empty(graph.dependencies(b)));
+    EXPECT_EQ(graph.dependencies(c), std::vector{ b });
+}
+
+GTEST_TEST(TaskGraph, CriticalPath)
+{
+    using namespace std::chrono_literals;
+
+    TaskGraph    graph;
+    JobScheduler scheduler{ { .workers = 2, .queue_size = 64 } };
+
+    const auto sleep = [](auto d) { return [d]() { std::this_thread::sleep_for(d); }; };
+
+    const auto a = graph.add({ .name = "a", .task = sleep(1ms), .reads = {}, .writes = { Resource{ 0 } } });
+    const auto b = graph.add({ .name = "b", .task = sleep(20ms), .reads = { Resource{ 0 } }, .writes = { Resource{ 1 } } });
+    (void)graph.add({ .name = "c", .task = sleep(1ms), .reads = { Resource{ 0 } }, .writes = { Resource{ 2 } } });
+    const auto d = graph.add({ .name = "d", .task = sleep(1ms), .reads = { Resource{ 1 }, Resource{ 2 } }, .writes = {} });
+    graph.run(scheduler);
+
+    EXPECT_EQ(graph.critical_path(), (std::vector{ a, b, d }));
+    EXPECT_GE(graph.elapsed(b), 20ms);
+    EXPECT_EQ(graph.name(b), "b");
+}
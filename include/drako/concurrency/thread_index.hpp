@@ -0,0 +1,63 @@
+#pragma once
+#ifndef DRAKO_THREAD_INDEX_HPP
+#define DRAKO_THREAD_INDEX_HPP
+
+/// @file
+/// @brief  Dense indices for threads, used to address per-thread caches.
+/// @author Grassi Edoardo
+
+#include <atomic>
+#include <cstddef>
+
+namespace drako
+{
+    /// @brief Upper bound (exclusive) of the indices returned by this_thread_index().
+    inline constexpr const std::size_t thread_index_limit = 128;
+
+    /// @brief Tracks which thread indices are currently in use.
+    inline std::atomic<bool> _thread_index_slots[thread_index_limit]{};
+
+    /// @brief Index claimed by a thread for its whole lifetime.
+    class _thread_index
+    {
+    public:
+        explicit _thread_index() noexcept
+        {
+            for (std::size_t i = 0; i < thread_index_limit; ++i)
+                if (!_thread_index_slots[i].load(std::memory_order::relaxed)
+                    && !_thread_index_slots[i].exchange(true, std::memory_order::acquire))
+                {
+                    value = i;
+                    return;
+                }
+        }
+
+        ~_thread_index() noexcept
+        {
+            if (value < thread_index_limit)
+                _thread_index_slots[value].store(false, std::memory_order::release);
+        }
+
+        _thread_index(const _thread_index&) = delete;
+        _thread_index& operator=(const _thread_index&) = delete;
+
+        std::size_t value = thread_index_limit;
+    };
+
+    /// @brief Small index that identifies the calling thread among the running ones.
+    ///
+    /// Indices are recycled when threads exit, so data addressed by index
+    /// is handed over to the next thread that claims the same index.
+    ///
+    /// @return An index in [0, thread_index_limit), or thread_index_limit
+    ///         if too many threads are running.
+    ///
+    [[nodiscard]] inline std::size_t this_thread_index() noexcept
+    {
+        thread_local const _thread_index index{};
+        return index.value;
+    }
+
+} // namespace drako
+
+#endif // !DRAKO_THREAD_INDEX_HPP
@@ -33,6 +33,8 @@
 
 #if defined(_drako_compiler_msvc)
 #define _drako_flexible_array_member // MSVC extension uses syntax 'int array[]'
+#elif defined(_drako_compiler_gcc) || defined(_drako_compiler_clang)
+#define _drako_flexible_array_member // GNU extension uses syntax 'int array[]'
 #else
 #error Compiler extension 'flexible array member' is not available.
 #endif
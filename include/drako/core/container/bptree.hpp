@@ -1,161 +1,767 @@
+#pragma once
 #ifndef DRAKO_BPTREE_HPP
 #define DRAKO_BPTREE_HPP
 
-#include <thread>
+/// @file
+/// @brief   Cache-conscious B+ tree for integral keys.
+/// @author  Grassi Edoardo
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
 
 namespace drako
 {
-    // B+ tree data structure.
-    template <typename Key, typename Val, typename Alloc>
-    class bptree final
+    /// @brief Ordered map from integral keys to values, stored as a B+ tree.
+    ///
+    /// The keys of each node fill one cache line (two for 64 bits keys), so that visiting
+    /// a node touches a single line, and they are searched with SIMD comparisons: the
+    /// position of a key is the number of stored keys that compare less, computed without
+    /// branches over the whole line. Unused slots hold the max value of the key type.
+    ///
+    /// Values live in the leaves, which are linked in key order for range iteration.
+    /// Inner nodes store the max key of each child but the last one.
+    ///
+    /// @tparam Key   Type of the keys.
+    /// @tparam Value Type of the mapped values.
+    /// @tparam Al    Allocator, rebound to the node types.
+    ///
+    template <typename Key, typename Value, typename Al = std::allocator<std::pair<const Key, Value>>> // clang-format off
+    requires std::is_integral_v<Key> && std::is_default_constructible_v<Value> && std::is_move_assignable_v<Value>
+    class BPlusTree final // clang-format on
     {
-        static_assert(std::is_integral_v<Key>, "Key type must be an integral type");
+        static constexpr const std::size_t _line_size = std::hardware_destructive_interference_size;
+        static constexpr const std::size_t _key_bytes = (sizeof(Key) >= 8) ? 2 * _line_size : _line_size;
 
     public:
-        explicit bptree(TAlloc const& allocator) noexcept;
-        ~bptree() noexcept;
+        using key_type    = Key;
+        using mapped_type = Value;
+        using size_type   = std::size_t;
 
-        bptree(bptree const&) = delete;
-        bptree& operator=(bptree& const) = delete;
+        /// @brief Max number of keys in a node.
+        static constexpr const std::size_t fanout = _key_bytes / sizeof(Key);
 
-        bptree(bptree&&) noexcept = delete;
-        bptree& operator=(bptree&&) noexcept = delete;
+    private:
+        static_assert(fanout >= 4, "Nodes are too small");
 
-        // Inserts a key-value pair.
-        [[nodiscard]] bool insert(TKey const k, TVal const v) noexcept;
+        static constexpr const Key         _sentinel = std::numeric_limits<Key>::max();
+        static constexpr const std::size_t _min     = fanout / 2; // min number of keys in a non-root node
+        static constexpr const std::size_t _max_height = 32;
 
-        // Removes a key-value pair.
-        [[nodiscard]] bool remove(TKey const k) noexcept;
+        struct alignas(_line_size) _leaf
+        {
+            Key           keys[fanout];
+            Value         values[fanout];
+            _leaf*        next  = nullptr;
+            std::uint32_t count = 0;
 
-        // Search for a key-value pair.
-        [[nodiscard]] bool search(TKey const k, TVal& out) const noexcept;
+            explicit _leaf() noexcept(std::is_nothrow_default_constructible_v<Value>)
+            {
+                std::fill(std::begin(keys), std::end(keys), _sentinel);
+            }
+        };
 
-        // Search for a key-value pair.
-        [[nodiscard]] TVal search(TKey const k, TVal const def) const noexcept;
+        struct alignas(_line_size) _inner
+        {
+            Key           keys[fanout];
+            void*         children[fanout + 1]; // leaves at the last level, inner nodes elsewhere
+            std::uint32_t count = 0;            // number of keys, children are one more
 
-    private:
-        constexpr const size_t cache_line_size = std::hardware_destructive_interference_size;
+            explicit _inner() noexcept
+            {
+                std::fill(std::begin(keys), std::end(keys), _sentinel);
+            }
+        };
+
+        using _leaf_alloc  = typename std::allocator_traits<Al>::template rebind_alloc<_leaf>;
+        using _inner_alloc = typename std::allocator_traits<Al>::template rebind_alloc<_inner>;
 
-        struct KeyValuePair
+    public:
+        /// @brief Forward iterator over the elements, in key order.
+        template <bool Const>
+        class basic_iterator
         {
-            TKey key;
-            TVal val;
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = std::pair<const Key, Value>;
+            using reference         = std::pair<const Key&, std::conditional_t<Const, const Value&, Value&>>;
+
+            explicit basic_iterator() noexcept = default;
+
+            // conversion from mutable to constant iterator
+            template <bool Other> // clang-format off
+            requires (Const && !Other)
+            basic_iterator(const basic_iterator<Other>& other) noexcept // clang-format on
+                : _node{ other._node }, _index{ other._index } {}
+
+            [[nodiscard]] reference operator*() const noexcept { return { key(), value() }; }
+
+            [[nodiscard]] const Key& key() const noexcept { return _node->keys[_index]; }
+
+            [[nodiscard]] auto& value() const noexcept { return _node->values[_index]; }
+
+            basic_iterator& operator++() noexcept
+            {
+                if (++_index == _node->count)
+                    _node = _node->next, _index = 0;
+                return *this;
+            }
+
+            basic_iterator operator++(int) noexcept
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            [[nodiscard]] friend bool operator==(const basic_iterator&, const basic_iterator&) noexcept = default;
+
+        private:
+            friend class BPlusTree;
+            friend class basic_iterator<true>;
+
+            using _leaf_ptr = std::conditional_t<Const, const _leaf*, _leaf*>;
+
+            explicit basic_iterator(_leaf_ptr leaf, std::uint32_t index) noexcept
+                : _node{ leaf }, _index{ index }
+            {
+                // past the last element of a leaf is the first of the next one
+                if (_node != nullptr && _index == _node->count)
+                    _node = _node->next, _index = 0;
+            }
+
+            _leaf_ptr     _node  = nullptr;
+            std::uint32_t _index = 0;
         };
 
-        struct KeyNodePair
+        using iterator       = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+
+        explicit BPlusTree(const Al& al = Al())
+            : _leaves{ al }, _inners{ al } {}
+
+        ~BPlusTree() noexcept { clear(); }
+
+        BPlusTree(const BPlusTree&) = delete;
+        BPlusTree& operator=(const BPlusTree&) = delete;
+
+        BPlusTree(BPlusTree&& other) noexcept
+            : _leaves{ std::move(other._leaves) }
+            , _inners{ std::move(other._inners) }
+            , _root{ std::exchange(other._root, nullptr) }
+            , _head{ std::exchange(other._head, nullptr) }
+            , _height{ std::exchange(other._height, 0) }
+            , _size{ std::exchange(other._size, 0) }
         {
-            TKey  key;
-            void* child;
-        };
+        }
 
-        struct alignas(cache_line_size) TreeNode
+        BPlusTree& operator=(BPlusTree&& other) noexcept
         {
-            // TODO: add compiler-time warning when struct doesn't fit in cache.
-            static_assert(sizeof(TreeNode) == cache_line_size);
+            if (this != &other)
+            {
+                clear();
+                _leaves = std::move(other._leaves);
+                _inners = std::move(other._inners);
+                _root   = std::exchange(other._root, nullptr);
+                _head   = std::exchange(other._head, nullptr);
+                _height = std::exchange(other._height, 0);
+                _size   = std::exchange(other._size, 0);
+            }
+            return *this;
+        }
 
-            uint8_t     keys_count = 0;
-            KeyNodePair data[branch_factor];
 
-            [[nodiscard]] inline bool full() const noexcept
+        /// @brief Inserts an element, if the key isn't already present.
+        ///
+        /// @return Iterator to the element with the key, and whether the insertion took place.
+        ///
+        std::pair<iterator, bool> insert(const Key key, Value value)
+        {
+            if (_root == nullptr)
+                _root = _head = _new_leaf();
+
+            // path from the root, used to propagate the splits upwards
+            _inner*       path[_max_height];
+            std::uint32_t slot[_max_height];
+
+            void* node = _root;
+            for (std::size_t level = 0; level < _height; ++level)
             {
-                return this->keys_count == keys_count;
+                const auto n = static_cast<_inner*>(node);
+                path[level]  = n;
+                slot[level]  = _position(n->keys, key);
+                node         = n->children[slot[level]];
             }
 
-        private:
-            constexpr const size_t branch_factor = 10;
-        };
+            auto leaf = static_cast<_leaf*>(node);
+            auto i    = _position(leaf->keys, key);
+            if (i < leaf->count && leaf->keys[i] == key)
+                return { iterator{ leaf, i }, false };
+
+            if (leaf->count == fanout)
+            {
+                // the split goes up through the full ancestors, and adds a root if they're all full:
+                // the nodes are allocated first, so the tree is left untouched if one of them throws
+                auto top = _height;
+                while (top > 0 && path[top - 1]->count == fanout)
+                    --top;
+                const std::size_t inners = (_height - top) + (top == 0 ? 1 : 0);
+
+                _inner*     spare[_max_height + 1] = {};
+                std::size_t allocated              = 0;
+                const auto  right                  = _new_leaf();
+                try
+                {
+                    for (; allocated < inners; ++allocated)
+                        spare[allocated] = _new_inner();
+                }
+                catch (...)
+                {
+                    while (allocated > 0)
+                        _delete_inner(spare[--allocated]);
+                    _delete_leaf(right);
+                    throw;
+                }
+
+                // split in halves, the left one keeps the lower keys
+                _move_entries(*leaf, fanout / 2, *right, 0, fanout - fanout / 2);
+                right->next = leaf->next;
+                leaf->next  = right;
+
+                Key   separator = leaf->keys[leaf->count - 1];
+                void* sibling   = right;
+                if (key > separator)
+                    i -= leaf->count, leaf = right;
+
+                auto next = spare;
+                for (auto level = _height; sibling != nullptr;)
+                {
+                    if (level == 0) // the root has been split
+                    {
+                        const auto root   = *next++;
+                        root->keys[0]     = separator;
+                        root->children[0] = _root;
+                        root->children[1] = sibling;
+                        root->count       = 1;
+                        _root             = root;
+                        assert(_height + 1 < _max_height);
+                        ++_height;
+                        break;
+                    }
+                    --level;
+                    sibling = _insert_child(*path[level], slot[level], separator, sibling, *next);
+                    if (sibling != nullptr)
+                        ++next;
+                }
+                assert(next == spare + inners);
+            }
 
-        struct alignas(cache_line_size) LeafNode
+            _insert_entry(*leaf, i, key, std::move(value));
+            ++_size;
+            return { iterator{ leaf, i }, true };
+        }
+
+        /// @brief Removes the element with the specified key.
+        ///
+        /// @return True if an element has been removed, false otherwise.
+        ///
+        bool erase(const Key key) noexcept
         {
-            // TODO: add compiler-time warning when struct doesn't fit in cache.
-            static_assert(sizeof(LeafNode) == CACHE_LINE_SIZE);
+            if (_root == nullptr)
+                return false;
 
-            KeyValuePair data[branch_factor];
-            LeafNode*    next = nullptr;
-        };
+            _inner*       path[_max_height];
+            std::uint32_t slot[_max_height];
 
-        void*        _root;       // Ptr to root node
-        LeafNode*    _head;       // Ptr to first leaf node
-        size_t       _height = 0; // Distance from root node to leafs
-        Alloc const& _allocator;  // Memory provider for runtime allocations
-    };
+            void* node = _root;
+            for (std::size_t level = 0; level < _height; ++level)
+            {
+                const auto n = static_cast<_inner*>(node);
+                path[level]  = n;
+                slot[level]  = _position(n->keys, key);
+                node         = n->children[slot[level]];
+            }
 
-    template <typename Key, typename Val, typename Alloc>
-    inline bptree<Key, Val, Alloc>::bptree(Alloc const& allocator) noexcept
-        : _allocator(allocator)
-    {
-        _root = _allocator.construct();
-    }
+            const auto leaf = static_cast<_leaf*>(node);
+            const auto i    = _position(leaf->keys, key);
+            if (i == leaf->count || leaf->keys[i] != key)
+                return false;
 
-    template <typename Key, typename Val, typename Alloc>
-    inline bptree<Key, Val, Alloc>::~bptree() noexcept
-    {
-        auto curr_node = static_cast<TreeNode*>(this->_root);
+            _erase_entry(*leaf, i);
+            --_size;
+
+            // rebalance from the bottom, while nodes are left with too few keys
+            auto underflow = (_height > 0 && leaf->count < _min);
+            for (auto level = _height; underflow && level > 0;)
+            {
+                --level;
+                underflow = (level == _height - 1)
+                                ? _rebalance_leaf(*path[level], slot[level])
+                                : _rebalance_inner(*path[level], slot[level]);
+                if (level == 0)
+                    break;
+                underflow = underflow && path[level]->count < _min;
+            }
 
-        // Foreach node
-        for (auto i = 0; i < this->_height; i++)
+            // shrink the tree when the root is left with a single child
+            while (_height > 0 && static_cast<_inner*>(_root)->count == 0)
+            {
+                const auto root = static_cast<_inner*>(_root);
+                _root           = root->children[0];
+                _delete_inner(root);
+                --_height;
+            }
+            return true;
+        }
+
+        /// @brief Replaces the content with elements sorted by key.
+        ///
+        /// Leaves and inner nodes are filled evenly bottom-up, in linear time.
+        ///
+        /// @param[in] keys   Keys in strictly ascending order.
+        /// @param[in] values Values associated with the keys.
+        ///
+        void assign_sorted(std::span<const Key> keys, std::span<const Value> values)
         {
-            // Foreach node child
-            for (auto j = 0; curr_node->data[j] != nullptr)
+            assert(std::size(keys) == std::size(values));
+            assert(std::adjacent_find(std::cbegin(keys), std::cend(keys), std::greater_equal<>{}) == std::cend(keys));
+
+            clear();
+            if (std::empty(keys))
+                return;
+
+            // level of the leaves, with the max key of each node
+            std::vector<std::pair<void*, Key>> level;
+
+            const auto count  = std::size(keys);
+            const auto leaves = (count + fanout - 1) / fanout;
+            _leaf*     prev   = nullptr;
+            for (std::size_t l = 0, first = 0; l < leaves; ++l)
             {
-                // Recursive call - free child
+                const auto last = count * (l + 1) / leaves;
+                const auto leaf = _new_leaf();
+                for (auto i = first; i < last; ++i)
+                {
+                    leaf->keys[i - first]   = keys[i];
+                    leaf->values[i - first] = values[i];
+                }
+                leaf->count = static_cast<std::uint32_t>(last - first);
+                (prev ? prev->next : _head) = leaf;
+                prev                        = leaf;
+                level.emplace_back(leaf, keys[last - 1]);
+                first = last;
+            }
+
+            // each inner node takes up to fanout + 1 children
+            while (std::size(level) > 1)
+            {
+                std::vector<std::pair<void*, Key>> parents;
+
+                const auto children = std::size(level);
+                const auto nodes    = (children + fanout) / (fanout + 1);
+                for (std::size_t n = 0, first = 0; n < nodes; ++n)
+                {
+                    const auto last  = children * (n + 1) / nodes;
+                    const auto inner = _new_inner();
+                    for (auto c = first; c < last; ++c)
+                    {
+                        inner->children[c - first] = level[c].first;
+                        if (c + 1 < last)
+                            inner->keys[c - first] = level[c].second;
+                    }
+                    inner->count = static_cast<std::uint32_t>(last - first - 1);
+                    parents.emplace_back(inner, level[last - 1].second);
+                    first = last;
+                }
+                level = std::move(parents);
+                ++_height;
             }
+
+            _root = level.front().first;
+            _size = count;
         }
-        this->_allocator.deallocate(this->_root);
-    }
 
-    template <typename Key, typename Val, typename Alloc>
-    inline bool bptree<Key, Val, Alloc>::insert(const Key k, const Val v) noexcept
-    {
-        // Navigate tree toward leaf nodes
-        auto curr_node = static_cast<TreeNode*>(this->_root);
-        for (auto i = 0; i < this->_height; i++)
+        /// @brief Removes all the elements.
+        void clear() noexcept
+        {
+            if (_root != nullptr)
+                _delete_subtree(_root, _height);
+            _root   = nullptr;
+            _head   = nullptr;
+            _height = 0;
+            _size   = 0;
+        }
+
+
+        /// @brief Finds the element with the specified key.
+        [[nodiscard]] iterator find(const Key key) noexcept
+        {
+            const auto it = lower_bound(key);
+            return (it != end() && it.key() == key) ? it : end();
+        }
+
+        /// @brief Finds the element with the specified key.
+        [[nodiscard]] const_iterator find(const Key key) const noexcept
+        {
+            const auto it = lower_bound(key);
+            return (it != end() && it.key() == key) ? it : end();
+        }
+
+        /// @brief Checks whether an element with the specified key is present.
+        [[nodiscard]] bool contains(const Key key) const noexcept { return find(key) != end(); }
+
+        /// @brief Finds the first element whose key is not less than the specified one.
+        [[nodiscard]] iterator lower_bound(const Key key) noexcept
+        {
+            const auto [leaf, i] = _search(key);
+            return iterator{ leaf, i };
+        }
+
+        /// @brief Finds the first element whose key is not less than the specified one.
+        [[nodiscard]] const_iterator lower_bound(const Key key) const noexcept
+        {
+            const auto [leaf, i] = _search(key);
+            return const_iterator{ leaf, i };
+        }
+
+        /// @brief Finds the first element whose key is greater than the specified one.
+        [[nodiscard]] iterator upper_bound(const Key key) noexcept
+        {
+            auto it = lower_bound(key);
+            return (it != end() && it.key() == key) ? ++it : it;
+        }
+
+        /// @brief Finds the first element whose key is greater than the specified one.
+        [[nodiscard]] const_iterator upper_bound(const Key key) const noexcept
+        {
+            auto it = lower_bound(key);
+            return (it != end() && it.key() == key) ? ++it : it;
+        }
+
+
+        [[nodiscard]] iterator       begin() noexcept { return iterator{ _head, 0 }; }
+        [[nodiscard]] const_iterator begin() const noexcept { return const_iterator{ _head, 0 }; }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+        [[nodiscard]] iterator       end() noexcept { return iterator{}; }
+        [[nodiscard]] const_iterator end() const noexcept { return const_iterator{}; }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+        /// @brief Number of elements.
+        [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+        /// @brief Number of inner levels above the leaves.
+        [[nodiscard]] std::size_t height() const noexcept { return _height; }
+
+    private:
+        [[no_unique_address]] _leaf_alloc  _leaves;
+        [[no_unique_address]] _inner_alloc _inners;
+
+        void*       _root   = nullptr; // leaf when the height is zero, inner node otherwise
+        _leaf*      _head   = nullptr; // first leaf of the linked list
+        std::size_t _height = 0;
+        std::size_t _size   = 0;
+
+
+        // number of keys that compare less than the given one, unused slots never do
+        [[nodiscard]] static std::uint32_t _position(const Key (&keys)[fanout], const Key key) noexcept
         {
-            // Split current node if already full
-            if (curr_node.full())
+#if defined(__AVX2__)
+            if constexpr (sizeof(Key) == 4 || sizeof(Key) == 8)
             {
-                // Split node
+                // compare as signed integers, unsigned ones need the sign bit flipped
+                using _lane               = std::conditional_t<sizeof(Key) == 4, std::int32_t, std::int64_t>;
+                constexpr const auto flip = std::is_signed_v<Key> ? _lane{ 0 } : std::numeric_limits<_lane>::min();
+
+                const auto k    = (sizeof(Key) == 4) ? _mm256_set1_epi32(static_cast<std::int32_t>(static_cast<_lane>(key) ^ flip))
+                                                     : _mm256_set1_epi64x(static_cast<std::int64_t>(static_cast<_lane>(key) ^ flip));
+                const auto bias = (sizeof(Key) == 4) ? _mm256_set1_epi32(static_cast<std::int32_t>(flip))
+                                                     : _mm256_set1_epi64x(static_cast<std::int64_t>(flip));
+
+                std::uint32_t count = 0;
+                for (std::size_t i = 0; i < fanout; i += 32 / sizeof(Key))
+                {
+                    const auto v = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(keys + i)), bias);
+                    const auto m = (sizeof(Key) == 4) ? _mm256_cmpgt_epi32(k, v) : _mm256_cmpgt_epi64(k, v);
+                    count += static_cast<std::uint32_t>(std::popcount(static_cast<unsigned>(_mm256_movemask_epi8(m))));
+                }
+                return count / sizeof(Key); // one bit for each byte of the matching lanes
             }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#if defined(__SSE4_2__)
+            constexpr const bool _wide_compare = true;
+#else
+            constexpr const bool _wide_compare = false;
+#endif
+            if constexpr (sizeof(Key) == 4 || (sizeof(Key) == 8 && _wide_compare))
+            {
+                // compare as signed integers, unsigned ones need the sign bit flipped
+                using _lane               = std::conditional_t<sizeof(Key) == 4, std::int32_t, std::int64_t>;
+                constexpr const auto flip = std::is_signed_v<Key> ? _lane{ 0 } : std::numeric_limits<_lane>::min();
+
+                __m128i k, bias;
+                if constexpr (sizeof(Key) == 4)
+                {
+                    k    = _mm_set1_epi32(static_cast<std::int32_t>(static_cast<_lane>(key) ^ flip));
+                    bias = _mm_set1_epi32(static_cast<std::int32_t>(flip));
+                }
+                else
+                {
+                    k    = _mm_set1_epi64x(static_cast<std::int64_t>(static_cast<_lane>(key) ^ flip));
+                    bias = _mm_set1_epi64x(static_cast<std::int64_t>(flip));
+                }
+
+                std::uint32_t count = 0;
+                for (std::size_t i = 0; i < fanout; i += 16 / sizeof(Key))
+                {
+                    const auto v = _mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(keys + i)), bias);
+                    __m128i    m;
+                    if constexpr (sizeof(Key) == 4)
+                        m = _mm_cmpgt_epi32(k, v);
+                    else
+                        m = _mm_cmpgt_epi64(k, v);
+                    count += static_cast<std::uint32_t>(std::popcount(static_cast<unsigned>(_mm_movemask_epi8(m))));
+                }
+                return count / sizeof(Key); // one bit for each byte of the matching lanes
+            }
+#endif
+            // branchless scan of the whole node, compilers vectorize it as well
+            std::uint32_t count = 0;
+            for (std::size_t i = 0; i < fanout; ++i)
+                count += (keys[i] < key);
+            return count;
+        }
+
+        // leaf and position of the first element not less than the key
+        [[nodiscard]] std::pair<_leaf*, std::uint32_t> _search(const Key key) const noexcept
+        {
+            if (_root == nullptr)
+                return { nullptr, 0 };
 
-            // Find correct child node by key comparison
-            auto j = 0;
-            while (k < curr_node->keys[j])
+            void* node = _root;
+            for (std::size_t level = 0; level < _height; ++level)
             {
-                j++;
+                const auto n = static_cast<_inner*>(node);
+                node         = n->children[_position(n->keys, key)];
             }
+            const auto leaf = static_cast<_leaf*>(node);
+            return { leaf, _position(leaf->keys, key) };
+        }
+
 
-            curr_node = static_cast<TreeNode*>(curr_node->ptrs[j - 1]);
+        [[nodiscard]] _leaf* _new_leaf()
+        {
+            return std::construct_at(std::allocator_traits<_leaf_alloc>::allocate(_leaves, 1));
         }
 
-        // Insert at leaf node
-        const auto leaf_node = reinterpret_cast<LeafNode*>(curr_node);
-        j                    = 0;
-        while (k < leaf_node->keys[j])
+        [[nodiscard]] _inner* _new_inner()
         {
-            j++;
+            return std::construct_at(std::allocator_traits<_inner_alloc>::allocate(_inners, 1));
         }
 
-        return true;
-    }
+        void _delete_leaf(_leaf* leaf) noexcept
+        {
+            std::destroy_at(leaf);
+            std::allocator_traits<_leaf_alloc>::deallocate(_leaves, leaf, 1);
+        }
 
-    template <typename Key, typename Val, typename Alloc>
-    inline bool bptree<Key, Val, Alloc>::search(Key const k, Val& out) const noexcept
-    {
-        // Navigate tree towards leaf nodes
-        auto curr_node = static_cast<TreeNode*>(this->_root);
-        for (auto i = 0; i < this->_height; i++)
+        void _delete_inner(_inner* inner) noexcept
         {
-            auto j = 0;
-            while (k < curr_node->keys[j])
+            std::destroy_at(inner);
+            std::allocator_traits<_inner_alloc>::deallocate(_inners, inner, 1);
+        }
+
+        void _delete_subtree(void* node, std::size_t height) noexcept
+        {
+            if (height == 0)
+                return _delete_leaf(static_cast<_leaf*>(node));
+
+            const auto inner = static_cast<_inner*>(node);
+            for (std::uint32_t c = 0; c <= inner->count; ++c)
+                _delete_subtree(inner->children[c], height - 1);
+            _delete_inner(inner);
+        }
+
+
+        // moves count entries of a leaf to another one, the tail of the source is shifted down
+        static void _move_entries(_leaf& src, std::uint32_t from, _leaf& dst, std::uint32_t to, std::uint32_t count)
+        {
+            std::move_backward(dst.keys + to, dst.keys + dst.count, dst.keys + dst.count + count);
+            std::move_backward(dst.values + to, dst.values + dst.count, dst.values + dst.count + count);
+            std::move(src.keys + from, src.keys + from + count, dst.keys + to);
+            std::move(src.values + from, src.values + from + count, dst.values + to);
+            dst.count += count;
+
+            std::move(src.keys + from + count, src.keys + src.count, src.keys + from);
+            std::move(src.values + from + count, src.values + src.count, src.values + from);
+            src.count -= count;
+            std::fill(src.keys + src.count, std::end(src.keys), _sentinel);
+        }
+
+        static void _insert_entry(_leaf& leaf, std::uint32_t i, Key key, Value&& value)
+        {
+            assert(leaf.count < fanout);
+            std::move_backward(leaf.keys + i, leaf.keys + leaf.count, leaf.keys + leaf.count + 1);
+            std::move_backward(leaf.values + i, leaf.values + leaf.count, leaf.values + leaf.count + 1);
+            leaf.keys[i]   = key;
+            leaf.values[i] = std::move(value);
+            ++leaf.count;
+        }
+
+        static void _erase_entry(_leaf& leaf, std::uint32_t i) noexcept
+        {
+            std::move(leaf.keys + i + 1, leaf.keys + leaf.count, leaf.keys + i);
+            std::move(leaf.values + i + 1, leaf.values + leaf.count, leaf.values + i);
+            leaf.values[--leaf.count] = Value{};
+            leaf.keys[leaf.count]     = _sentinel;
+        }
+
+        // inserts a separator and the child at its right in position i,
+        // returns the new sibling if the node had to be split, with the separator to push up;
+        // the sibling is the preallocated spare node
+        [[nodiscard]] static void* _insert_child(_inner& node, std::uint32_t i, Key& separator, void* child, _inner* spare) noexcept
+        {
+            if (node.count < fanout)
             {
-                j++;
+                std::move_backward(node.keys + i, node.keys + node.count, node.keys + node.count + 1);
+                std::move_backward(node.children + i + 1, node.children + node.count + 1, node.children + node.count + 2);
+                node.keys[i]         = separator;
+                node.children[i + 1] = child;
+                ++node.count;
+                return nullptr;
             }
-            curr_node = static_cast<TreeNode*>(curr_node->ptrs[j - 1]);
+
+            // gather all the keys and children, then split them around the middle key
+            Key   keys[fanout + 1];
+            void* children[fanout + 2];
+            std::copy_n(node.keys, i, keys);
+            keys[i] = separator;
+            std::copy(node.keys + i, node.keys + fanout, keys + i + 1);
+            std::copy_n(node.children, i + 1, children);
+            children[i + 1] = child;
+            std::copy(node.children + i + 1, node.children + fanout + 1, children + i + 2);
+
+            constexpr const auto left  = (fanout + 1) / 2; // keys kept by the node
+            const auto           right = spare;
+            assert(right != nullptr);
+
+            std::copy_n(keys, left, node.keys);
+            std::fill(node.keys + left, std::end(node.keys), _sentinel);
+            std::copy_n(children, left + 1, node.children);
+            node.count = left;
+
+            std::copy(keys + left + 1, keys + fanout + 1, right->keys);
+            std::copy(children + left + 1, children + fanout + 2, right->children);
+            right->count = fanout - left;
+
+            separator = keys[left];
+            return right;
         }
 
-        // Scan leaf node
-        const auto leaf_node = static_cast<LeafNode*>(curr_node);
-    }
+        // fixes the leaf in position i of the parent, returns true if the parent lost a key
+        bool _rebalance_leaf(_inner& parent, std::uint32_t i) noexcept
+        {
+            const auto leaf  = static_cast<_leaf*>(parent.children[i]);
+            const auto left  = (i > 0) ? static_cast<_leaf*>(parent.children[i - 1]) : nullptr;
+            const auto right = (i < parent.count) ? static_cast<_leaf*>(parent.children[i + 1]) : nullptr;
+
+            if (left && left->count > _min) // borrow the last element of the left sibling
+            {
+                _move_entries(*left, left->count - 1, *leaf, 0, 1);
+                parent.keys[i - 1] = left->keys[left->count - 1];
+                return false;
+            }
+            if (right && right->count > _min) // borrow the first element of the right sibling
+            {
+                _move_entries(*right, 0, *leaf, leaf->count, 1);
+                parent.keys[i] = leaf->keys[leaf->count - 1];
+                return false;
+            }
+
+            // merge with a sibling, the right node of the pair is released
+            const auto j  = left ? i - 1 : i;
+            const auto lo = static_cast<_leaf*>(parent.children[j]);
+            const auto hi = static_cast<_leaf*>(parent.children[j + 1]);
+            _move_entries(*hi, 0, *lo, lo->count, hi->count);
+            lo->next = hi->next;
+            _delete_leaf(hi);
+            _erase_child(parent, j);
+            return true;
+        }
+
+        // fixes the inner node in position i of the parent, returns true if the parent lost a key
+        bool _rebalance_inner(_inner& parent, std::uint32_t i) noexcept
+        {
+            const auto node  = static_cast<_inner*>(parent.children[i]);
+            const auto left  = (i > 0) ? static_cast<_inner*>(parent.children[i - 1]) : nullptr;
+            const auto right = (i < parent.count) ? static_cast<_inner*>(parent.children[i + 1]) : nullptr;
+
+            if (left && left->count > _min) // rotate the last child of the left sibling
+            {
+                std::move_backward(node->keys, node->keys + node->count, node->keys + node->count + 1);
+                std::move_backward(node->children, node->children + node->count + 1, node->children + node->count + 2);
+                node->keys[0]     = parent.keys[i - 1];
+                node->children[0] = left->children[left->count];
+                ++node->count;
+
+                parent.keys[i - 1]      = left->keys[--left->count];
+                left->keys[left->count] = _sentinel;
+                return false;
+            }
+            if (right && right->count > _min) // rotate the first child of the right sibling
+            {
+                node->keys[node->count]         = parent.keys[i];
+                node->children[node->count + 1] = right->children[0];
+                ++node->count;
+
+                parent.keys[i] = right->keys[0];
+                std::move(right->keys + 1, right->keys + right->count, right->keys);
+                std::move(right->children + 1, right->children + right->count + 1, right->children);
+                right->keys[--right->count] = _sentinel;
+                return false;
+            }
+
+            // merge with a sibling, the separator between them moves down
+            const auto j  = left ? i - 1 : i;
+            const auto lo = static_cast<_inner*>(parent.children[j]);
+            const auto hi = static_cast<_inner*>(parent.children[j + 1]);
+            lo->keys[lo->count] = parent.keys[j];
+            std::copy_n(hi->keys, hi->count, lo->keys + lo->count + 1);
+            std::copy_n(hi->children, hi->count + 1, lo->children + lo->count + 1);
+            lo->count += hi->count + 1;
+            _delete_inner(hi);
+            _erase_child(parent, j);
+            return true;
+        }
+
+        // removes the separator in position j and the child at its right
+        static void _erase_child(_inner& parent, std::uint32_t j) noexcept
+        {
+            std::move(parent.keys + j + 1, parent.keys + parent.count, parent.keys + j);
+            std::move(parent.children + j + 2, parent.children + parent.count + 1, parent.children + j + 1);
+            parent.keys[--parent.count] = _sentinel;
+        }
+    };
+
 } // namespace drako
 
-#endif // !DRAKO_BPLUSTREE_HPP
+#endif // !DRAKO_BPTREE_HPP
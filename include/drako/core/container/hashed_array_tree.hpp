@@ -1,164 +1,393 @@
-#ifndef DRAKO_HASHED_ARRAY_TREE_HPP_
-#define DRAKO_HASHED_ARRAY_TREE_HPP_
+#pragma once
+#ifndef DRAKO_HASHED_ARRAY_TREE_HPP
+#define DRAKO_HASHED_ARRAY_TREE_HPP
 
-#include <cstddef>
-#include <cmath>
-
-#include <drako_math_utility.hpp>
-#include <drako_assertions.hpp>
+/// @file
+/// @brief   Growable array whose elements never move.
+/// @author  Grassi Edoardo
 
-#ifndef DRAKO_DISABLE_BOUNDS_CHECKS
-#   define DK_CHECK_INDEX(index) \
-        DRAKO_ASSERT_INSIDE_INCLUSIVE_BOUNDS(index, 0, capacity() - 1, "Index is out of array bounds")
-#else
-#   define DK_ASSERT_BOUNDS(...)
-#endif
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace drako
 {
-    #define CACHE_LINE_SIZE_BYTES 64
-
-    // Tag structure
+    /// @brief Tag that requests the initial capacity to be allocated as a single block.
     struct request_contiguous_storage_tag
     {
         constexpr explicit request_contiguous_storage_tag() noexcept = default;
     };
 
-    template <typename T, std::size_t ChunkSize>
+
+    /// @brief Growable array made of fixed size chunks, indexed by a directory of pointers.
+    ///
+    /// Appending allocates a new chunk when the last one is full and never relocates
+    /// the elements already stored, so pointers and references to them stay valid
+    /// until the element is removed. Only the directory grows by reallocation.
+    ///
+    /// The memory overhead is at most one partially filled chunk plus the directory,
+    /// O(ChunkSize + size / ChunkSize), that is O(sqrt(n)) for a chunk size close to sqrt(n).
+    ///
+    /// Chunks are contiguous and can be processed independently by different threads,
+    /// see chunk() and chunks().
+    ///
+    /// @tparam T         Type of the elements.
+    /// @tparam ChunkSize Number of elements in each chunk, must be a power of 2.
+    /// @tparam Al        Allocator of the elements.
+    ///
+    template <typename T, std::size_t ChunkSize, typename Al = std::allocator<T>>
     class HashedArrayTree
     {
-        static_assert(drako::math::is_pow2(ChunkSize), "Chunk size must be a power of 2");
+        static_assert(std::has_single_bit(ChunkSize), "Chunk size must be a power of 2");
+
+        using _traits     = std::allocator_traits<Al>;
+        using _dir_alloc  = typename _traits::template rebind_alloc<T*>;
+        using _directory  = std::vector<T*, _dir_alloc>;
 
     public:
+        using value_type      = T;
+        using size_type       = std::size_t;
+        using reference       = T&;
+        using const_reference = const T&;
 
-        // Ctor
-        explicit HashedArrayTree(std::size_t count);
-        // Ctor
-        explicit HashedArrayTree(std::size_t count, const request_contiguous_storage_tag);
-        // Dtor
-        ~HashedArrayTree() noexcept;
+        /// @brief Random access iterator over the elements.
+        template <bool Const>
+        class basic_iterator
+        {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = T;
+            using pointer           = std::conditional_t<Const, const T*, T*>;
+            using reference         = std::conditional_t<Const, const T&, T&>;
 
-        // Copy ctor
-        HashedArrayTree(const HashedArrayTree&);
-        // Copy assignment operator
-        HashedArrayTree& operator=(const HashedArrayTree&);
+            explicit basic_iterator() noexcept = default;
 
-        // Move ctor
-        constexpr HashedArrayTree(HashedArrayTree&&) noexcept;
-        // Move assignment operator
-        constexpr HashedArrayTree& operator=(HashedArrayTree&&) noexcept;
+            // conversion from mutable to constant iterator
+            template <bool Other> // clang-format off
+            requires (Const && !Other)
+            basic_iterator(const basic_iterator<Other>& other) noexcept // clang-format on
+                : _chunks{ other._chunks }, _index{ other._index } {}
 
-        inline constexpr T& operator[](std::size_t idx) noexcept;
-        inline constexpr const T& operator[](std::size_t idx) const noexcept;
+            [[nodiscard]] reference operator*() const noexcept { return _chunks[_index / ChunkSize][_index % ChunkSize]; }
+            [[nodiscard]] pointer   operator->() const noexcept { return std::addressof(**this); }
+            [[nodiscard]] reference operator[](difference_type n) const noexcept { return *(*this + n); }
 
-        // Returns the number of elements stored in the array
-        inline constexpr std::size_t reserved_memory_size() const noexcept { return size; }
+            basic_iterator& operator++() noexcept { return ++_index, *this; }
+            basic_iterator& operator--() noexcept { return --_index, *this; }
+            basic_iterator  operator++(int) noexcept { return basic_iterator{ _chunks, _index++ }; }
+            basic_iterator  operator--(int) noexcept { return basic_iterator{ _chunks, _index-- }; }
 
-        // Returns the maximum number of elements that can be stored in the array
-        inline constexpr std::size_t capacity() const noexcept { return m_chunkCount * ChunkSize; }
+            basic_iterator& operator+=(difference_type n) noexcept { return _index += n, *this; }
+            basic_iterator& operator-=(difference_type n) noexcept { return _index -= n, *this; }
 
-    private:
+            [[nodiscard]] friend basic_iterator operator+(basic_iterator it, difference_type n) noexcept { return it += n; }
+            [[nodiscard]] friend basic_iterator operator+(difference_type n, basic_iterator it) noexcept { return it += n; }
+            [[nodiscard]] friend basic_iterator operator-(basic_iterator it, difference_type n) noexcept { return it -= n; }
 
-        std::size_t size;
-        std::size_t m_chunkCount;
-        T** m_pChunks;
-    };
+            [[nodiscard]] friend difference_type operator-(const basic_iterator& a, const basic_iterator& b) noexcept
+            {
+                return static_cast<difference_type>(a._index) - static_cast<difference_type>(b._index);
+            }
 
-    template<typename T, std::size_t ChunkSize>
-    HashedArrayTree<T, ChunkSize>::HashedArrayTree(std::size_t count)
-        : size(0)
-    {
-        m_chunkCount = drako::math::ceil_to_pow2(std::sqrt(count));
+            [[nodiscard]] friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept
+            {
+                return a._index == b._index;
+            }
+
+            [[nodiscard]] friend auto operator<=>(const basic_iterator& a, const basic_iterator& b) noexcept
+            {
+                return a._index <=> b._index;
+            }
+
+        private:
+            friend class HashedArrayTree;
+            friend class basic_iterator<true>;
+
+            explicit basic_iterator(T* const* chunks, std::size_t index) noexcept
+                : _chunks{ chunks }, _index{ index } {}
+
+            T* const*   _chunks = nullptr;
+            std::size_t _index  = 0;
+        };
+
+        using iterator       = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
 
-        T** m_pChunks = static_cast<T**>(std::aligned_alloc(alignof(T*), m_chunkCount * sizeof(T*));
-        DRAKO_ASSERT_NOT_NULL(m_pChunks, "Allocation failed");
 
-        for (std::size_t i = 0; i < m_chunkCount; i++)
+        explicit HashedArrayTree(const Al& al = Al())
+            : _al{ al }, _chunks{ _dir_alloc{ al } } {}
+
+        /// @brief Constructs an empty array with capacity for at least the specified number of elements.
+        explicit HashedArrayTree(std::size_t count, const Al& al = Al())
+            : HashedArrayTree{ al }
         {
-            m_pChunks[i] = static_cast<T*>(std::aligned_alloc(alignof(T), ChunkSize * sizeof(T)));
-            DRAKO_ASSERT_NOT_NULL(m_pChunks[i], "Allocation failed");
+            reserve(count);
         }
-    }
 
-    template<typename T, std::size_t ChunkSize>
-    HashedArrayTree<T, ChunkSize>::HashedArrayTree(std::size_t count, const request_contiguous_storage_tag)
-        : size(0)
-    {
-        m_chunkCount = drako::math::ceil_to_pow2(std::sqrt(count));
+        /// @brief Constructs an empty array whose initial capacity is allocated as a single block.
+        ///
+        /// Elements of the initial capacity are contiguous in memory,
+        /// the chunks allocated later are independent.
+        ///
+        explicit HashedArrayTree(std::size_t count, const request_contiguous_storage_tag, const Al& al = Al())
+            : HashedArrayTree{ al }
+        {
+            const auto chunks = (count + ChunkSize - 1) / ChunkSize;
+            if (chunks == 0)
+                return;
 
-        T** m_pChunks = static_cast<T**>(
-            std::aligned_alloc(alignof(T),
-                               m_chunkCount * sizeof(T*) + m_chunkCount * ChunkSize * sizeof(T))
-            );
-        DRAKO_ASSERT_NOT_NULL(m_pChunks, "Allocation failed");
+            _chunks.reserve(chunks);
+            _block        = _traits::allocate(_al, chunks * ChunkSize);
+            _block_chunks = chunks;
+            for (std::size_t i = 0; i < chunks; ++i)
+                _chunks.push_back(_block + i * ChunkSize);
+        }
 
-        for (std::size_t i = 0; i < m_chunkCount; i++)
+        ~HashedArrayTree() noexcept
         {
-            m_pChunks[i] = // assign leafs
+            clear();
+            _release(0);
         }
-    }
 
-    template<typename T, std::size_t ChunkSize>
-    inline HashedArrayTree<T, ChunkSize>::~HashedArrayTree() noexcept
-    {
-        if (m_pChunks != nullptr) // Avoid inner ptrs deallocations if the array has been moved from
+        HashedArrayTree(const HashedArrayTree& other) requires std::is_copy_constructible_v<T>
+            : HashedArrayTree{ _traits::select_on_container_copy_construction(other._al) }
         {
-            for (int i = 0; i < m_chunkCount; i++)
+            reserve(other._size);
+            try
             {
-                std::free(m_pChunks[i]);
+                for (const auto& x : other)
+                    emplace_back(x);
+            }
+            catch (...)
+            {
+                clear();
+                _release(0);
+                throw;
             }
-            std::free(m_pChunks);
         }
-    }
 
-    template<typename T, std::size_t ChunkSize>
-    inline HashedArrayTree<T, ChunkSize>::HashedArrayTree(const HashedArrayTree& rhs)
-        : size(rhs.size), m_chunkCount(rhs.m_chunkCount)
-    {
-        
-    }
+        HashedArrayTree& operator=(const HashedArrayTree& other) requires std::is_copy_constructible_v<T>
+        {
+            if (this != std::addressof(other))
+            {
+                HashedArrayTree copy{ other };
+                swap(copy);
+            }
+            return *this;
+        }
 
-    template<typename T, std::size_t ChunkSize>
-    inline HashedArrayTree<T, ChunkSize>& HashedArrayTree<T, ChunkSize>::operator=(const HashedArrayTree& rhs)
-    {
-        if (this != &rhs)
+        HashedArrayTree(HashedArrayTree&& other) noexcept
+            : _al{ std::move(other._al) }
+            , _chunks{ std::move(other._chunks) }
+            , _size{ std::exchange(other._size, 0) }
+            , _block{ std::exchange(other._block, nullptr) }
+            , _block_chunks{ std::exchange(other._block_chunks, 0) }
         {
-            // TODO: add impl
+            other._chunks.clear();
         }
-        return *this;
-    }
 
-    template<typename T, std::size_t ChunkSize>
-    inline constexpr HashedArrayTree<T, ChunkSize>::HashedArrayTree(HashedArrayTree&& rhs) noexcept
-        : size(rhs.size), m_chunkCount(rhs.m_chunkCount)
-    {
-        m_pChunks = rhs.m_pChunks;
-        rhs.m_pChunks = nullptr;
-    }
+        HashedArrayTree& operator=(HashedArrayTree&& other) noexcept
+        {
+            if (this != std::addressof(other))
+            {
+                clear();
+                _release(0);
+                _al           = std::move(other._al);
+                _chunks       = std::move(other._chunks);
+                _size         = std::exchange(other._size, 0);
+                _block        = std::exchange(other._block, nullptr);
+                _block_chunks = std::exchange(other._block_chunks, 0);
+                other._chunks.clear();
+            }
+            return *this;
+        }
 
-    template<typename T, std::size_t ChunkSize>
-    inline constexpr HashedArrayTree<T, ChunkSize>& HashedArrayTree<T, ChunkSize>::operator=(HashedArrayTree&& rhs) noexcept
-    {
-        if (this != &rhs)
+        void swap(HashedArrayTree& other) noexcept
         {
-            // TODO: add impl
+            using std::swap;
+            swap(_al, other._al);
+            swap(_chunks, other._chunks);
+            swap(_size, other._size);
+            swap(_block, other._block);
+            swap(_block_chunks, other._block_chunks);
         }
-        return *this;
-    }
 
-    template <typename T, std::size_t ChunkSize>
-    inline constexpr T& HashedArrayTree<T, ChunkSize>::operator[](std::size_t idx) noexcept
-    {
-        DK_CHECK_INDEX(idx);
-        return (m_pChunks[idx / ChunkSize])[idx % ChunkSize];
-    }
 
-    template <typename T, std::size_t ChunkSize>
-    inline constexpr const T& HashedArrayTree<T, ChunkSize>::operator[](std::size_t idx) const noexcept
-    {
-        DK_CHECK_INDEX(idx);
-        return (m_pChunks[idx / ChunkSize])[idx % ChunckSize];
-    }
-}
+        [[nodiscard]] T& operator[](std::size_t pos) noexcept
+        {
+            assert(pos < _size); // out of array bounds
+            return _chunks[pos / ChunkSize][pos % ChunkSize];
+        }
+
+        [[nodiscard]] const T& operator[](std::size_t pos) const noexcept
+        {
+            assert(pos < _size); // out of array bounds
+            return _chunks[pos / ChunkSize][pos % ChunkSize];
+        }
+
+        [[nodiscard]] T&       front() noexcept { return (*this)[0]; }
+        [[nodiscard]] const T& front() const noexcept { return (*this)[0]; }
+
+        [[nodiscard]] T&       back() noexcept { return (*this)[_size - 1]; }
+        [[nodiscard]] const T& back() const noexcept { return (*this)[_size - 1]; }
+
+
+        /// @brief Constructs an element at the end of the array.
+        ///
+        /// @return Reference to the new element, valid until the element is removed.
+        ///
+        template <typename... Args> // clang-format off
+        requires std::is_constructible_v<T, Args...>
+        T& emplace_back(Args&&... args) // clang-format on
+        {
+            if (_size == capacity())
+                _grow();
+
+            const auto p = std::addressof(_chunks[_size / ChunkSize][_size % ChunkSize]);
+            _traits::construct(_al, p, std::forward<Args>(args)...);
+            ++_size;
+            return *p;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        /// @brief Destroys the last element.
+        void pop_back() noexcept
+        {
+            assert(_size > 0);
+            --_size;
+            _traits::destroy(_al, std::addressof(_chunks[_size / ChunkSize][_size % ChunkSize]));
+        }
+
+        /// @brief Destroys all the elements, the capacity is left unchanged.
+        void clear() noexcept
+        {
+            for (std::size_t c = 0; c < chunk_count(); ++c)
+                for (auto& x : chunk(c))
+                    _traits::destroy(_al, std::addressof(x));
+            _size = 0;
+        }
+
+        /// @brief Allocates chunks until the capacity is at least the specified number of elements.
+        void reserve(std::size_t count)
+        {
+            const auto chunks = (count + ChunkSize - 1) / ChunkSize;
+            if (chunks > std::size(_chunks))
+                _chunks.reserve(chunks);
+            while (capacity() < count)
+                _grow();
+        }
+
+        /// @brief Releases the chunks that don't hold any element.
+        void shrink_to_fit() noexcept
+        {
+            _release(std::max(chunk_count(), _block_chunks));
+        }
+
+
+        /// @brief Number of elements stored in the array.
+        [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+        /// @brief Number of elements that can be stored without allocating new chunks.
+        [[nodiscard]] std::size_t capacity() const noexcept { return std::size(_chunks) * ChunkSize; }
+
+
+        /// @brief Number of chunks that hold at least an element.
+        [[nodiscard]] std::size_t chunk_count() const noexcept { return (_size + ChunkSize - 1) / ChunkSize; }
+
+        /// @brief Elements stored in a chunk, contiguous in memory.
+        [[nodiscard]] std::span<T> chunk(std::size_t index) noexcept
+        {
+            assert(index < chunk_count());
+            return { _chunks[index], std::min(ChunkSize, _size - index * ChunkSize) };
+        }
+
+        /// @brief Elements stored in a chunk, contiguous in memory.
+        [[nodiscard]] std::span<const T> chunk(std::size_t index) const noexcept
+        {
+            assert(index < chunk_count());
+            return { _chunks[index], std::min(ChunkSize, _size - index * ChunkSize) };
+        }
+
+        /// @brief Random access range over the chunks that hold elements, as spans.
+        ///
+        /// Disjoint subranges of chunks can be processed by different threads without synchronization.
+        ///
+        [[nodiscard]] auto chunks() noexcept
+        {
+            return std::views::iota(std::size_t{ 0 }, chunk_count())
+                | std::views::transform([this](std::size_t i) { return chunk(i); });
+        }
+
+        /// @brief Random access range over the chunks that hold elements, as spans.
+        [[nodiscard]] auto chunks() const noexcept
+        {
+            return std::views::iota(std::size_t{ 0 }, chunk_count())
+                | std::views::transform([this](std::size_t i) { return chunk(i); });
+        }
+
+
+        [[nodiscard]] iterator       begin() noexcept { return iterator{ std::data(_chunks), 0 }; }
+        [[nodiscard]] const_iterator begin() const noexcept { return const_iterator{ std::data(_chunks), 0 }; }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+        [[nodiscard]] iterator       end() noexcept { return iterator{ std::data(_chunks), _size }; }
+        [[nodiscard]] const_iterator end() const noexcept { return const_iterator{ std::data(_chunks), _size }; }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    private:
+        [[no_unique_address]] Al _al;
+
+        _directory  _chunks;           // pointers to the chunks, in order
+        std::size_t _size         = 0; // number of elements
+        T*          _block        = nullptr; // single allocation of the first chunks, if any
+        std::size_t _block_chunks = 0;       // number of chunks in the block
+
+        void _grow()
+        {
+            // the directory slot is secured first, so that the chunk can't leak
+            _chunks.push_back(nullptr);
+            try
+            {
+                _chunks.back() = _traits::allocate(_al, ChunkSize);
+            }
+            catch (...)
+            {
+                _chunks.pop_back();
+                throw;
+            }
+        }
+
+        // deallocates the chunks after the first ones
+        void _release(std::size_t keep) noexcept
+        {
+            for (auto i = std::max(keep, _block_chunks); i < std::size(_chunks); ++i)
+                _traits::deallocate(_al, _chunks[i], ChunkSize);
+
+            if (keep < _block_chunks) // the block is released as a whole
+            {
+                _traits::deallocate(_al, _block, _block_chunks * ChunkSize);
+                _block        = nullptr;
+                _block_chunks = 0;
+            }
+            _chunks.resize(std::min(keep, std::size(_chunks)));
+            _chunks.shrink_to_fit();
+        }
+    };
+
+} // namespace drako
 
-#endif // !DRAKO_HASHED_ARRAY_TREE_HPP_
+#endif // !DRAKO_HASHED_ARRAY_TREE_HPP
@@ -0,0 +1,481 @@
+#pragma once
+#ifndef DRAKO_SMALL_VECTOR_HPP
+#define DRAKO_SMALL_VECTOR_HPP
+
+/// @file
+/// @brief   Vector with inline storage for a few elements.
+/// @author  Grassi Edoardo
+
+#include <algorithm>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace drako
+{
+    /// @brief Vector that stores up to N elements inline, without any allocation.
+    ///
+    /// Larger sizes spill the elements to storage obtained from the allocator,
+    /// which is kept until the vector is destroyed or shrunk. The interface matches std::vector.
+    ///
+    /// @tparam T  Type of the elements.
+    /// @tparam N  Number of elements stored inline.
+    /// @tparam Al Allocator used for the elements that don't fit inline.
+    ///
+    template <typename T, std::size_t N, typename Al = std::allocator<T>>
+    class SmallVector
+    {
+        static_assert(N > 0, "Inline capacity must be positive");
+
+        using _traits = std::allocator_traits<Al>;
+
+    public:
+        using value_type             = T;
+        using allocator_type         = Al;
+        using size_type              = std::size_t;
+        using difference_type        = std::ptrdiff_t;
+        using reference              = T&;
+        using const_reference        = const T&;
+        using pointer                = T*;
+        using const_pointer          = const T*;
+        using iterator               = T*;
+        using const_iterator         = const T*;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        /// @brief Number of elements stored without allocations.
+        static constexpr const std::size_t inline_capacity = N;
+
+
+        explicit SmallVector(const Al& al = Al()) noexcept(std::is_nothrow_copy_constructible_v<Al>)
+            : _al{ al } {}
+
+        explicit SmallVector(std::size_t count, const Al& al = Al())
+            : _al{ al }
+        {
+            resize(count);
+        }
+
+        SmallVector(std::size_t count, const T& value, const Al& al = Al())
+            : _al{ al }
+        {
+            resize(count, value);
+        }
+
+        template <std::input_iterator It>
+        SmallVector(It first, It last, const Al& al = Al())
+            : _al{ al }
+        {
+            assign(first, last);
+        }
+
+        SmallVector(std::initializer_list<T> values, const Al& al = Al())
+            : _al{ al }
+        {
+            assign(std::begin(values), std::end(values));
+        }
+
+        ~SmallVector() noexcept
+        {
+            clear();
+            _release();
+        }
+
+        SmallVector(const SmallVector& other)
+            : _al{ _traits::select_on_container_copy_construction(other._al) }
+        {
+            assign(std::begin(other), std::end(other));
+        }
+
+        SmallVector& operator=(const SmallVector& other)
+        {
+            if (this != std::addressof(other))
+            {
+                if constexpr (_traits::propagate_on_container_copy_assignment::value)
+                    if (_al != other._al)
+                    { // storage must be released by the allocator that obtained it
+                        clear();
+                        _release();
+                        _al = other._al;
+                    }
+                assign(std::begin(other), std::end(other));
+            }
+            return *this;
+        }
+
+        SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : _al{ std::move(other._al) }
+        {
+            _take(other);
+        }
+
+        SmallVector& operator=(SmallVector&& other) noexcept(
+            std::is_nothrow_move_constructible_v<T>&& std::is_nothrow_move_assignable_v<T>)
+        {
+            if (this != std::addressof(other))
+            {
+                if (!other._is_inline() && (_traits::propagate_on_container_move_assignment::value || _al == other._al))
+                { // the heap storage changes owner, elements aren't touched
+                    clear();
+                    _release();
+                    if constexpr (_traits::propagate_on_container_move_assignment::value)
+                        _al = std::move(other._al);
+                    _take(other);
+                }
+                else
+                {
+                    assign(std::make_move_iterator(std::begin(other)), std::make_move_iterator(std::end(other)));
+                    other.clear();
+                }
+            }
+            return *this;
+        }
+
+        SmallVector& operator=(std::initializer_list<T> values)
+        {
+            assign(std::begin(values), std::end(values));
+            return *this;
+        }
+
+        /// @brief Replaces the content with the elements of a range.
+        template <std::input_iterator It>
+        void assign(It first, It last)
+        {
+            clear();
+            if constexpr (std::forward_iterator<It>)
+                reserve(static_cast<std::size_t>(std::distance(first, last)));
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+
+        /// @brief Replaces the content with copies of a value.
+        void assign(std::size_t count, const T& value)
+        {
+            clear();
+            resize(count, value);
+        }
+
+        [[nodiscard]] allocator_type get_allocator() const noexcept { return _al; }
+
+
+        [[nodiscard]] T& operator[](std::size_t pos) noexcept
+        {
+            assert(pos < _size); // out of bounds
+            return _data[pos];
+        }
+
+        [[nodiscard]] const T& operator[](std::size_t pos) const noexcept
+        {
+            assert(pos < _size); // out of bounds
+            return _data[pos];
+        }
+
+        [[nodiscard]] T& at(std::size_t pos)
+        {
+            if (pos >= _size)
+                throw std::out_of_range{ "SmallVector index is out of range." };
+            return _data[pos];
+        }
+
+        [[nodiscard]] const T& at(std::size_t pos) const
+        {
+            if (pos >= _size)
+                throw std::out_of_range{ "SmallVector index is out of range." };
+            return _data[pos];
+        }
+
+        [[nodiscard]] T&       front() noexcept { return (*this)[0]; }
+        [[nodiscard]] const T& front() const noexcept { return (*this)[0]; }
+
+        [[nodiscard]] T&       back() noexcept { return (*this)[_size - 1]; }
+        [[nodiscard]] const T& back() const noexcept { return (*this)[_size - 1]; }
+
+        [[nodiscard]] T*       data() noexcept { return _data; }
+        [[nodiscard]] const T* data() const noexcept { return _data; }
+
+
+        [[nodiscard]] iterator       begin() noexcept { return _data; }
+        [[nodiscard]] const_iterator begin() const noexcept { return _data; }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return _data; }
+
+        [[nodiscard]] iterator       end() noexcept { return _data + _size; }
+        [[nodiscard]] const_iterator end() const noexcept { return _data + _size; }
+        [[nodiscard]] const_iterator cend() const noexcept { return _data + _size; }
+
+        [[nodiscard]] reverse_iterator       rbegin() noexcept { return reverse_iterator{ end() }; }
+        [[nodiscard]] const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+        [[nodiscard]] const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+        [[nodiscard]] reverse_iterator       rend() noexcept { return reverse_iterator{ begin() }; }
+        [[nodiscard]] const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+        [[nodiscard]] const_reverse_iterator crend() const noexcept { return rend(); }
+
+
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+        [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+        [[nodiscard]] std::size_t max_size() const noexcept
+        {
+            return std::min<std::size_t>(_traits::max_size(_al), std::numeric_limits<difference_type>::max());
+        }
+
+        [[nodiscard]] std::size_t capacity() const noexcept { return _capacity; }
+
+        /// @brief Checks whether the elements are stored inline.
+        [[nodiscard]] bool is_inline() const noexcept { return _is_inline(); }
+
+        /// @brief Grows the storage to hold at least the specified number of elements.
+        void reserve(std::size_t count)
+        {
+            if (count > _capacity)
+                _reallocate(count);
+        }
+
+        /// @brief Moves the elements back inline if they fit, or to a smaller allocation otherwise.
+        void shrink_to_fit()
+        {
+            if (!_is_inline() && _size < _capacity)
+                _reallocate(_size);
+        }
+
+
+        void clear() noexcept
+        {
+            std::destroy_n(_data, _size);
+            _size = 0;
+        }
+
+        template <typename... Args> // clang-format off
+        requires std::is_constructible_v<T, Args...>
+        T& emplace_back(Args&&... args) // clang-format on
+        {
+            if (_size == _capacity)
+            { // the arguments may refer to an element, so the new one is constructed before relocation
+                const auto capacity = _grown(_size + 1);
+                const auto data     = _traits::allocate(_al, capacity);
+                try
+                {
+                    _traits::construct(_al, data + _size, std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    _traits::deallocate(_al, data, capacity);
+                    throw;
+                }
+                try
+                {
+                    _relocate(data, capacity);
+                }
+                catch (...)
+                {
+                    std::destroy_at(data + _size);
+                    _traits::deallocate(_al, data, capacity);
+                    throw;
+                }
+            }
+            else
+                _traits::construct(_al, _data + _size, std::forward<Args>(args)...);
+            return _data[_size++];
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        void pop_back() noexcept
+        {
+            assert(_size > 0);
+            std::destroy_at(_data + --_size);
+        }
+
+        /// @brief Constructs an element before the specified position.
+        template <typename... Args> // clang-format off
+        requires std::is_constructible_v<T, Args...>
+        iterator emplace(const_iterator pos, Args&&... args) // clang-format on
+        {
+            assert(pos >= cbegin() && pos <= cend());
+            const auto index = static_cast<std::size_t>(pos - cbegin());
+
+            // appended then rotated in place, so that arguments referring to elements stay valid
+            emplace_back(std::forward<Args>(args)...);
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+        iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+        /// @brief Inserts the elements of a range before the specified position.
+        template <std::input_iterator It>
+        iterator insert(const_iterator pos, It first, It last)
+        {
+            assert(pos >= cbegin() && pos <= cend());
+            const auto index = static_cast<std::size_t>(pos - cbegin());
+            const auto old   = _size;
+            for (; first != last; ++first)
+                emplace_back(*first);
+            std::rotate(begin() + index, begin() + old, end());
+            return begin() + index;
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<T> values)
+        {
+            return insert(pos, std::begin(values), std::end(values));
+        }
+
+        iterator erase(const_iterator pos) noexcept(std::is_nothrow_move_assignable_v<T>)
+        {
+            return erase(pos, pos + 1);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) noexcept(std::is_nothrow_move_assignable_v<T>)
+        {
+            assert(first >= cbegin() && first <= last && last <= cend());
+            const auto begin = _data + (first - cbegin());
+            const auto end   = std::move(_data + (last - cbegin()), _data + _size, begin);
+            std::destroy(end, _data + _size);
+            _size = static_cast<std::size_t>(end - _data);
+            return begin;
+        }
+
+        void resize(std::size_t count)
+        {
+            if (count < _size)
+                return void(erase(begin() + count, end()));
+            reserve(count);
+            while (_size < count)
+                emplace_back();
+        }
+
+        void resize(std::size_t count, const T& value)
+        {
+            if (count < _size)
+                return void(erase(begin() + count, end()));
+            reserve(count);
+            while (_size < count)
+                emplace_back(value);
+        }
+
+        void swap(SmallVector& other) noexcept(
+            std::is_nothrow_move_constructible_v<T>&& std::is_nothrow_move_assignable_v<T>)
+        {
+            if (this == std::addressof(other))
+                return;
+            if (!_is_inline() && !other._is_inline())
+            { // heap storage is exchanged without touching the elements
+                assert(_traits::propagate_on_container_swap::value || _al == other._al);
+                if constexpr (_traits::propagate_on_container_swap::value)
+                    std::swap(_al, other._al);
+                std::swap(_data, other._data);
+                std::swap(_size, other._size);
+                std::swap(_capacity, other._capacity);
+                return;
+            }
+            SmallVector temp{ std::move(other) };
+            other = std::move(*this);
+            *this = std::move(temp);
+        }
+
+        friend void swap(SmallVector& a, SmallVector& b) noexcept(noexcept(a.swap(b))) { a.swap(b); }
+
+        [[nodiscard]] friend bool operator==(const SmallVector& a, const SmallVector& b)
+        {
+            return std::equal(std::begin(a), std::end(a), std::begin(b), std::end(b));
+        }
+
+        [[nodiscard]] friend auto operator<=>(const SmallVector& a, const SmallVector& b) // clang-format off
+        requires std::three_way_comparable<T> // clang-format on
+        {
+            return std::lexicographical_compare_three_way(std::begin(a), std::end(a), std::begin(b), std::end(b));
+        }
+
+    private:
+        [[no_unique_address]] Al _al;
+
+        T*          _data     = reinterpret_cast<T*>(_buffer);
+        std::size_t _size     = 0;
+        std::size_t _capacity = N;
+
+        alignas(T) std::byte _buffer[N * sizeof(T)];
+
+        [[nodiscard]] bool _is_inline() const noexcept
+        {
+            return _data == reinterpret_cast<const T*>(_buffer);
+        }
+
+        [[nodiscard]] std::size_t _grown(std::size_t required) const
+        {
+            if (required > max_size())
+                throw std::length_error{ "SmallVector is too large." };
+            return std::max(required, std::min(2 * _capacity, max_size()));
+        }
+
+        // moves the elements to new storage, which is inline when the capacity fits
+        void _reallocate(std::size_t capacity)
+        {
+            if (capacity <= N)
+                return _relocate(reinterpret_cast<T*>(_buffer), N);
+
+            const auto data = _traits::allocate(_al, capacity);
+            try
+            {
+                _relocate(data, capacity);
+            }
+            catch (...)
+            {
+                _traits::deallocate(_al, data, capacity);
+                throw;
+            }
+        }
+
+        // moves the elements in the destination, copies them if moves can throw
+        void _relocate(T* data, std::size_t capacity)
+        {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+                std::uninitialized_move_n(_data, _size, data);
+            else
+                std::uninitialized_copy_n(_data, _size, data);
+
+            std::destroy_n(_data, _size);
+            _release();
+            _data     = data;
+            _capacity = capacity;
+        }
+
+        // deallocates the heap storage, elements must be already destroyed
+        void _release() noexcept
+        {
+            if (!_is_inline())
+                _traits::deallocate(_al, _data, _capacity);
+            _data     = reinterpret_cast<T*>(_buffer);
+            _capacity = N;
+        }
+
+        // takes the elements of another vector, left empty and inline
+        void _take(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            if (other._is_inline())
+            {
+                std::uninitialized_move_n(other._data, other._size, _data);
+                _size = other._size;
+                other.clear();
+            }
+            else
+            {
+                _data     = std::exchange(other._data, reinterpret_cast<T*>(other._buffer));
+                _size     = std::exchange(other._size, 0);
+                _capacity = std::exchange(other._capacity, N);
+            }
+        }
+    };
+
+} // namespace drako
+
+#endif // !DRAKO_SMALL_VECTOR_HPP
@@ -2,16 +2,453 @@
 #ifndef DRAKO_SOA_HPP
 #define DRAKO_SOA_HPP
 
+/// @file
+/// @brief   Tables stored as structure of arrays.
+/// @author  Grassi Edoardo
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace drako::soa
 {
-    template <typename... Ts>
-    void pusb_back(std::vector<Ts>&... args)
+    /// @brief Table whose rows are stored as one array for each column.
+    ///
+    /// Rows are always inserted and removed as a whole, so columns can't get out of sync.
+    /// All the columns share a single allocation, grown geometrically.
+    ///
+    /// Rows are densely packed: removal moves the last row in the hole, so row indices
+    /// aren't stable. Handles returned on insertion keep referring to the same row
+    /// across removals and reorderings of the others.
+    ///
+    /// @tparam Ts Types of the columns.
+    ///
+    template <typename... Ts> // clang-format off
+    requires (sizeof...(Ts) > 0) && (std::is_move_constructible_v<Ts> && ...) && (std::is_move_assignable_v<Ts> && ...)
+    class Table // clang-format on
     {
-    }
+        static constexpr const std::uint32_t _none = ~std::uint32_t{ 0 };
+
+        // columns of user types, followed by the slot of each row
+        using _pointers = std::tuple<Ts*..., std::uint32_t*>;
+
+        template <typename T>
+        static constexpr const std::size_t _occurrences = (std::size_t{ std::is_same_v<T, Ts> } + ...);
+
+        template <typename T>
+        static constexpr std::size_t _index_of() noexcept
+        {
+            constexpr bool matches[] = { std::is_same_v<T, Ts>... };
+            return static_cast<std::size_t>(std::find(std::begin(matches), std::end(matches), true) - std::begin(matches));
+        }
+
+        static constexpr const bool _nothrow_relocate =
+            ((std::is_nothrow_move_constructible_v<Ts> && std::is_nothrow_move_assignable_v<Ts>)&&...);
+
+    public:
+        /// @brief Number of columns.
+        static constexpr const std::size_t columns = sizeof...(Ts);
+
+        /// @brief Type of a column.
+        template <std::size_t I>
+        using column_type = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+        /// @brief Stable reference to a row.
+        struct Handle
+        {
+            std::uint32_t slot       = _none;
+            std::uint32_t generation = 0;
+
+            [[nodiscard]] friend constexpr bool operator==(const Handle&, const Handle&) noexcept = default;
+        };
+
+
+        explicit Table() noexcept = default;
+
+        /// @brief Constructs an empty table with capacity for the specified number of rows.
+        explicit Table(std::size_t capacity) { reserve(capacity); }
+
+        ~Table() noexcept
+        {
+            clear();
+            _deallocate(_data, _capacity);
+        }
+
+        Table(const Table&) = delete;
+        Table& operator=(const Table&) = delete;
+
+        Table(Table&& other) noexcept
+            : _data{ std::exchange(other._data, nullptr) }
+            , _columns{ std::exchange(other._columns, _pointers{}) }
+            , _size{ std::exchange(other._size, 0) }
+            , _capacity{ std::exchange(other._capacity, 0) }
+            , _slots{ std::move(other._slots) }
+            , _free_slots{ std::move(other._free_slots) }
+        {
+            other._slots.clear();
+            other._free_slots.clear();
+        }
+
+        Table& operator=(Table&& other) noexcept
+        {
+            if (this != std::addressof(other))
+            {
+                clear();
+                _deallocate(_data, _capacity);
+                _data       = std::exchange(other._data, nullptr);
+                _columns    = std::exchange(other._columns, _pointers{});
+                _size       = std::exchange(other._size, 0);
+                _capacity   = std::exchange(other._capacity, 0);
+                _slots      = std::move(other._slots);
+                _free_slots = std::move(other._free_slots);
+                other._slots.clear();
+                other._free_slots.clear();
+            }
+            return *this;
+        }
+
+
+        /// @brief Elements of a column, one for each row.
+        template <std::size_t I>
+        [[nodiscard]] std::span<column_type<I>> column() noexcept { return { std::get<I>(_columns), _size }; }
+
+        /// @brief Elements of a column, one for each row.
+        template <std::size_t I>
+        [[nodiscard]] std::span<const column_type<I>> column() const noexcept { return { std::get<I>(_columns), _size }; }
+
+        /// @brief Elements of the column of the specified type, which must be unique in the table.
+        template <typename T> // clang-format off
+        requires (_occurrences<T> == 1)
+        [[nodiscard]] std::span<T> column() noexcept // clang-format on
+        {
+            return column<_index_of<T>()>();
+        }
+
+        /// @brief Elements of the column of the specified type, which must be unique in the table.
+        template <typename T> // clang-format off
+        requires (_occurrences<T> == 1)
+        [[nodiscard]] std::span<const T> column() const noexcept // clang-format on
+        {
+            return column<_index_of<T>()>();
+        }
+
+
+        /// @brief Appends a row, each column is constructed from the corresponding argument.
+        ///
+        /// @return Handle to the new row.
+        ///
+        template <typename... Args> // clang-format off
+        requires (sizeof...(Args) == columns) && (std::is_constructible_v<Ts, Args> && ...)
+        Handle emplace_back(Args&&... args) // clang-format on
+        {
+            if (_size == _capacity)
+                reserve(std::max(std::size_t{ 8 }, 2 * _capacity));
+
+            // slots and free slots never outgrow the capacity, so their updates can't throw
+            std::uint32_t slot;
+            if (!std::empty(_free_slots))
+            {
+                slot = _free_slots.back();
+                _free_slots.pop_back();
+            }
+            else
+            {
+                slot = static_cast<std::uint32_t>(std::size(_slots));
+                _slots.push_back({ .row = _none, .generation = 0 });
+            }
+
+            try
+            {
+                _construct_row(std::index_sequence_for<Ts...>{}, std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                _free_slots.push_back(slot);
+                throw;
+            }
+
+            std::get<columns>(_columns)[_size] = slot;
+            _slots[slot].row                   = static_cast<std::uint32_t>(_size);
+            ++_size;
+            return { .slot = slot, .generation = _slots[slot].generation };
+        }
+
+        /// @brief Appends a row.
+        Handle push_back(Ts... row) { return emplace_back(std::move(row)...); }
+
+        /// @brief Removes a row, replacing it with the last one.
+        void erase(std::size_t row) noexcept(_nothrow_relocate)
+        {
+            assert(row < _size);
+            const auto last = _size - 1;
+
+            // the handle of the removed row is invalidated
+            const auto slot = std::get<columns>(_columns)[row];
+            ++_slots[slot].generation;
+            _slots[slot].row = _none;
+            _free_slots.push_back(slot);
+
+            if (row != last)
+            {
+                [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    ((std::get<I>(_columns)[row] = std::move(std::get<I>(_columns)[last])), ...);
+                }(std::make_index_sequence<columns + 1>{});
+                _slots[std::get<columns>(_columns)[row]].row = static_cast<std::uint32_t>(row);
+            }
+            _destroy_row(last);
+            --_size;
+        }
+
+        /// @brief Removes the row referenced by a handle, replacing it with the last one.
+        void erase(Handle h) noexcept(_nothrow_relocate)
+        {
+            assert(contains(h));
+            erase(_slots[h.slot].row);
+        }
+
+        /// @brief Removes the last row.
+        void pop_back() noexcept
+        {
+            assert(_size > 0);
+            erase(_size - 1);
+        }
+
+        /// @brief Removes all the rows, the capacity is left unchanged.
+        void clear() noexcept
+        {
+            while (_size > 0)
+                pop_back();
+        }
+
+
+        /// @brief Handle to a row.
+        [[nodiscard]] Handle handle(std::size_t row) const noexcept
+        {
+            assert(row < _size);
+            const auto slot = std::get<columns>(_columns)[row];
+            return { .slot = slot, .generation = _slots[slot].generation };
+        }
+
+        /// @brief Checks whether the row referenced by a handle is in the table.
+        [[nodiscard]] bool contains(Handle h) const noexcept
+        {
+            return h.slot < std::size(_slots) && _slots[h.slot].generation == h.generation && _slots[h.slot].row != _none;
+        }
+
+        /// @brief Current index of the row referenced by a handle.
+        [[nodiscard]] std::size_t index(Handle h) const noexcept
+        {
+            assert(contains(h));
+            return _slots[h.slot].row;
+        }
+
+
+        /// @brief Reorders the rows, so that the row at position order[i] becomes the row i.
+        ///
+        /// @param[in] order Permutation of the indices of the rows.
+        ///
+        void permute(std::span<const std::size_t> order)
+        {
+            assert(std::size(order) == _size);
+
+            // cycles of the permutation are applied in place, one column at a time
+            std::vector<bool> done(_size);
+            const auto        apply = [&]<typename T>(T* column) {
+                std::fill(std::begin(done), std::end(done), false);
+                for (std::size_t start = 0; start < _size; ++start)
+                {
+                    if (done[start])
+                        continue;
+
+                    T    temp = std::move(column[start]);
+                    auto row  = start;
+                    for (; order[row] != start; row = order[row])
+                    {
+                        assert(!done[order[row]]); // not a permutation
+                        column[row] = std::move(column[order[row]]);
+                        done[row]   = true;
+                    }
+                    column[row] = std::move(temp);
+                    done[row]   = true;
+                }
+            };
+            std::apply([&](auto*... column) { (apply(column), ...); }, _columns);
+
+            for (std::size_t row = 0; row < _size; ++row)
+                _slots[std::get<columns>(_columns)[row]].row = static_cast<std::uint32_t>(row);
+        }
+
+        /// @brief Sorts the rows by the values of a column.
+        ///
+        /// @param[in] compare Strict weak ordering of the elements of the column.
+        ///
+        template <std::size_t I, typename Compare = std::less<>>
+        void sort(Compare compare = {})
+        {
+            const auto keys = column<I>();
+
+            std::vector<std::size_t> order(_size);
+            std::iota(std::begin(order), std::end(order), std::size_t{ 0 });
+            std::sort(std::begin(order), std::end(order),
+                [&](std::size_t a, std::size_t b) { return std::invoke(compare, keys[a], keys[b]); });
+            permute(order);
+        }
+
+        /// @brief Sorts the rows by the values of the column of the specified type.
+        template <typename T, typename Compare = std::less<>> // clang-format off
+        requires (_occurrences<T> == 1)
+        void sort(Compare compare = {}) // clang-format on
+        {
+            sort<_index_of<T>()>(std::move(compare));
+        }
+
+
+        /// @brief Allocates storage for at least the specified number of rows.
+        ///
+        /// All the columns are stored in a single block of memory.
+        ///
+        void reserve(std::size_t capacity)
+        {
+            if (capacity <= _capacity)
+                return;
+
+            _slots.reserve(capacity);
+            _free_slots.reserve(capacity);
+
+            const auto data    = static_cast<std::byte*>(::operator new(_bytes(capacity), std::align_val_t{ _alignment }));
+            const auto layout  = _layout(data, capacity);
+
+            // columns whose relocation can throw go first, so that a failure
+            // releases their copies before any other column has been moved from
+            std::size_t relocated = 0;
+            try
+            {
+                [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    ((_nothrow_relocate_column<I> ? void() : _relocate(std::get<I>(_columns), std::get<I>(layout)), ++relocated), ...);
+                }(std::make_index_sequence<sizeof...(Ts) + 1>{});
+            }
+            catch (...)
+            {
+                [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    ((I < relocated && !_nothrow_relocate_column<I> ? void(std::destroy_n(std::get<I>(layout), _size)) : void()), ...);
+                }(std::make_index_sequence<sizeof...(Ts) + 1>{});
+                _deallocate(data, capacity);
+                throw;
+            }
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                ((_nothrow_relocate_column<I> ? _relocate(std::get<I>(_columns), std::get<I>(layout)) : void()), ...);
+            }(std::make_index_sequence<sizeof...(Ts) + 1>{});
+
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                (void(std::destroy_n(std::get<I>(_columns), _size)), ...);
+            }(std::make_index_sequence<sizeof...(Ts) + 1>{});
+            _deallocate(_data, _capacity);
+
+            _data     = data;
+            _columns  = layout;
+            _capacity = capacity;
+        }
+
+
+        /// @brief Number of rows.
+        [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+        /// @brief Number of rows that can be stored without reallocation.
+        [[nodiscard]] std::size_t capacity() const noexcept { return _capacity; }
+
+    private:
+        struct _slot
+        {
+            std::uint32_t row;        // current index of the row, none when the slot is free
+            std::uint32_t generation; // incremented when the row is removed
+        };
+
+        static constexpr const std::size_t _alignment = std::max({ alignof(Ts)..., alignof(std::uint32_t) });
+
+        std::byte*                 _data    = nullptr;
+        _pointers                  _columns = {};
+        std::size_t                _size     = 0;
+        std::size_t                _capacity = 0;
+        std::vector<_slot>         _slots;      // indirection from handles to rows
+        std::vector<std::uint32_t> _free_slots; // slots available for new rows
+
+        // size of the block for the specified number of rows, columns are padded to their alignment
+        [[nodiscard]] static constexpr std::size_t _bytes(std::size_t capacity) noexcept
+        {
+            std::size_t bytes = 0;
+            ((bytes = (bytes + alignof(Ts) - 1) / alignof(Ts) * alignof(Ts) + capacity * sizeof(Ts)), ...);
+            bytes = (bytes + alignof(std::uint32_t) - 1) / alignof(std::uint32_t) * alignof(std::uint32_t);
+            return bytes + capacity * sizeof(std::uint32_t);
+        }
+
+        // position of each column in the block
+        [[nodiscard]] static _pointers _layout(std::byte* data, std::size_t capacity) noexcept
+        {
+            std::size_t offset = 0;
+            const auto  next   = [&]<typename T>(std::type_identity<T>) {
+                offset       = (offset + alignof(T) - 1) / alignof(T) * alignof(T);
+                const auto p = reinterpret_cast<T*>(data + offset);
+                offset += capacity * sizeof(T);
+                return p;
+            };
+            // braced initialization guarantees the left to right evaluation
+            return _pointers{ next(std::type_identity<Ts>{})..., next(std::type_identity<std::uint32_t>{}) };
+        }
+
+        static void _deallocate(std::byte* data, std::size_t capacity) noexcept
+        {
+            if (data != nullptr)
+                ::operator delete(data, _bytes(capacity), std::align_val_t{ _alignment });
+        }
+
+        template <std::size_t I>
+        static constexpr const bool _nothrow_relocate_column =
+            std::is_nothrow_move_constructible_v<std::tuple_element_t<I, std::tuple<Ts..., std::uint32_t>>>;
+
+        // moves the elements of a column in new storage, copies them if moves can throw
+        template <typename T>
+        void _relocate(T* src, T* dst)
+        {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+                std::uninitialized_move_n(src, _size, dst);
+            else
+                std::uninitialized_copy_n(src, _size, dst);
+        }
+
+        template <std::size_t... I, typename... Args>
+        void _construct_row(std::index_sequence<I...>, Args&&... args)
+        {
+            // columns are constructed in order, a failure destroys the ones already constructed
+            std::size_t constructed = 0;
+            try
+            {
+                ((std::construct_at(std::get<I>(_columns) + _size, std::forward<Args>(args)), ++constructed), ...);
+            }
+            catch (...)
+            {
+                ((I < constructed ? std::destroy_at(std::get<I>(_columns) + _size) : void()), ...);
+                throw;
+            }
+        }
+
+        void _destroy_row(std::size_t row) noexcept
+        {
+            std::apply([row](auto*... column) { (std::destroy_at(column + row), ...); }, _columns);
+        }
+    };
 
 } // namespace drako::soa
-}
 
-#endif // !DRAKO_SOA_HPP
\ No newline at end of file
+#endif // !DRAKO_SOA_HPP
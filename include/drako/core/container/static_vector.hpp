@@ -14,15 +14,15 @@ namespace drako
     {
     public:
         using iterator       = T*;
-        using const_iterator = T* const;
+        using const_iterator = const T*;
 
         constexpr explicit StaticVector() noexcept = default;
 
 
         ~StaticVector() noexcept
         {
-            for (auto i = 0; i < _size; ++i)
-                std::destroy_at(_data + i);
+            for (std::size_t i = 0; i < _size; ++i)
+                std::destroy_at(std::addressof((*this)[i]));
         }
 
         constexpr StaticVector(const StaticVector& other) requires std::is_copy_constructible_v<T>
@@ -78,7 +78,7 @@ namespace drako
 
     private:
         std::aligned_storage_t<sizeof(T), alignof(T)> _data[Size];
-        std::size_t                                   _size;
+        std::size_t                                   _size = 0;
     };
 
 } // namespace drako
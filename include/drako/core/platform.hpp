@@ -25,15 +25,20 @@
 // #define DRAKO_PLT_MACOS
 // #define _drako_platform_MacOS
 
-// MACRO
-// Defined for Linux target.
-//
-// #define DRAKO_PLT_LINUX
-// #define _drako_platform_Linux
-
 #endif // DRKAPI_CC_MSC
 
 
+#if defined(__linux__)
+
+/// @brief Defined when Linux is the target platform.
+#define _drako_platform_Linux __linux__
+
+/// @brief [[deprecated]] Use '_drako_platform_Linux' instead.
+#define DRAKO_PLT_LINUX _drako_platform_Linux
+
+#endif
+
+
 #if defined(DRAKO_CC_MSVC) && defined(_M_X86)
 #define DRAKO_ARCH_X86
 #endif
@@ -0,0 +1,198 @@
+#include "drako/core/container/bptree.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace drako;
+
+namespace
+{
+    template <typename Key, typename Al>
+    void expect_same(const BPlusTree<Key, std::string, Al>& tree, const std::map<Key, std::string>& model)
+    {
+        ASSERT_EQ(tree.size(), model.size());
+        auto it = tree.begin();
+        for (const auto& [k, v] : model)
+        {
+            ASSERT_NE(it, tree.end());
+            ASSERT_EQ(it.key(), k);
+            ASSERT_EQ(it.value(), v);
+            ++it;
+        }
+        ASSERT_EQ(it, tree.end());
+    }
+
+    // random inserts and erases checked against std::map, the second half of the run shrinks the tree
+    template <typename Key>
+    void compare_with_map(Key min, Key max, int operations)
+    {
+        std::mt19937_64                    rng{ 42 };
+        std::uniform_int_distribution<Key> keys{ min, max };
+        BPlusTree<Key, std::string>        tree;
+        std::map<Key, std::string>         model;
+
+        for (auto i = 0; i < operations; ++i)
+        {
+            const auto key = keys(rng);
+            const auto op  = rng() % 3;
+            if (op == 0 || (op == 1 && i < operations / 2))
+            {
+                const auto [it, inserted] = tree.insert(key, std::to_string(key));
+                ASSERT_EQ(inserted, model.emplace(key, std::to_string(key)).second);
+                ASSERT_EQ(it.key(), key);
+            }
+            else
+                ASSERT_EQ(tree.erase(key), model.erase(key) == 1);
+
+            const auto query = keys(rng);
+            ASSERT_EQ(tree.contains(query), model.contains(query));
+            if (const auto expected = model.lower_bound(query); expected == std::end(model))
+                ASSERT_EQ(tree.lower_bound(query), tree.end());
+            else
+                ASSERT_EQ(tree.lower_bound(query).key(), expected->first);
+            if (const auto expected = model.upper_bound(query); expected == std::end(model))
+                ASSERT_EQ(tree.upper_bound(query), tree.end());
+            else
+                ASSERT_EQ(tree.upper_bound(query).key(), expected->first);
+
+            if (i % 1000 == 0)
+                expect_same(tree, model);
+        }
+        expect_same(tree, model);
+
+        // drain from both ends, merging nodes until the root is a leaf again
+        while (!std::empty(model))
+        {
+            const auto key = (rng() & 1) ? std::begin(model)->first : std::prev(std::end(model))->first;
+            ASSERT_TRUE(tree.erase(key));
+            model.erase(key);
+        }
+        expect_same(tree, model);
+        EXPECT_EQ(tree.height(), 0);
+    }
+
+    // forwards to the standard allocator, throws when the countdown reaches zero
+    template <typename T>
+    struct FailingAllocator
+    {
+        using value_type = T;
+
+        int* countdown;
+
+        FailingAllocator(int& counter) noexcept
+            : countdown{ &counter } {}
+
+        template <typename U>
+        FailingAllocator(const FailingAllocator<U>& other) noexcept
+            : countdown{ other.countdown } {}
+
+        [[nodiscard]] T* allocate(std::size_t n)
+        {
+            if (--*countdown == 0)
+                throw std::bad_alloc{};
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept { std::allocator<T>{}.deallocate(p, n); }
+
+        template <typename U>
+        [[nodiscard]] bool operator==(const FailingAllocator<U>& other) const noexcept
+        {
+            return countdown == other.countdown;
+        }
+    };
+} // namespace
+
+GTEST_TEST(BPlusTree, CompareWithMapU16) { compare_with_map<std::uint16_t>(0, 3'000, 30'000); }
+
+GTEST_TEST(BPlusTree, CompareWithMapU32) { compare_with_map<std::uint32_t>(0, 5'000, 60'000); }
+
+GTEST_TEST(BPlusTree, CompareWithMapI32) { compare_with_map<std::int32_t>(-3'000, 3'000, 60'000); }
+
+GTEST_TEST(BPlusTree, CompareWithMapU64) { compare_with_map<std::uint64_t>(0xFFFF'FFFF'0000'0000, 0xFFFF'FFFF'0000'2000, 60'000); }
+
+GTEST_TEST(BPlusTree, CompareWithMapI64) { compare_with_map<std::int64_t>(-2'000, 2'000, 60'000); }
+
+GTEST_TEST(BPlusTree, KeysNearUnusedSlotValue)
+{
+    // unused slots are filled with the max key, which is a valid key too
+    compare_with_map<std::uint32_t>(0xFFFF'FF00, 0xFFFF'FFFF, 20'000);
+}
+
+GTEST_TEST(BPlusTree, AssignSorted)
+{
+    for (const std::size_t n : { 0, 1, 16, 17, 100, 300, 5'000, 70'000 })
+    {
+        std::vector<std::uint32_t>           keys;
+        std::vector<std::string>             values;
+        std::map<std::uint32_t, std::string> model;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            keys.push_back(static_cast<std::uint32_t>(i * 3));
+            values.push_back(std::to_string(i));
+            model.emplace(keys.back(), values.back());
+        }
+
+        BPlusTree<std::uint32_t, std::string> tree;
+        tree.insert(7, "replaced");
+        tree.assign_sorted(keys, values);
+        expect_same(tree, model);
+
+        // the bulk loaded nodes must accept updates afterwards
+        for (std::size_t i = 0; i < n; i += 2)
+        {
+            const auto key = static_cast<std::uint32_t>(i * 3);
+            ASSERT_TRUE(tree.erase(key));
+            model.erase(key);
+            tree.insert(key + 1, "inserted");
+            model.emplace(key + 1, "inserted");
+        }
+        expect_same(tree, model);
+
+        auto moved = std::move(tree);
+        expect_same(moved, model);
+        EXPECT_TRUE(tree.empty());
+    }
+}
+
+GTEST_TEST(BPlusTree, FailedSplitLeavesTreeUnchanged)
+{
+    using Tree = BPlusTree<std::uint16_t, std::string, FailingAllocator<std::pair<const std::uint16_t, std::string>>>;
+
+    std::mt19937                          rng{ 7 };
+    int                                   countdown = 0;
+    Tree                                  tree{ FailingAllocator<std::pair<const std::uint16_t, std::string>>{ countdown } };
+    std::map<std::uint16_t, std::string> model;
+
+    // every allocation of a split may fail, including the ones for the new inner nodes and root
+    auto failures = 0;
+    while (tree.height() < 2)
+    {
+        const auto key = static_cast<std::uint16_t>(rng());
+        countdown      = 1 + static_cast<int>(rng() % 4);
+        try
+        {
+            const auto inserted = tree.insert(key, std::to_string(key)).second;
+            ASSERT_EQ(inserted, model.emplace(key, std::to_string(key)).second);
+        }
+        catch (const std::bad_alloc&)
+        {
+            ++failures;
+            ASSERT_FALSE(tree.contains(key));
+            expect_same(tree, model);
+        }
+    }
+    countdown = 0;
+    EXPECT_GT(failures, 0);
+    expect_same(tree, model);
+    for (const auto& [k, v] : model)
+        ASSERT_EQ(tree.find(k).value(), v);
+}
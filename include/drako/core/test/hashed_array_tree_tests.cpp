@@ -0,0 +1,154 @@
+#include "drako/core/container/hashed_array_tree.hpp"
+#include "drako/concurrency/parallel_algorithms.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <string>
+#include <vector>
+
+using namespace drako;
+
+static_assert(std::random_access_iterator<HashedArrayTree<int, 4>::iterator>);
+static_assert(std::random_access_iterator<HashedArrayTree<int, 4>::const_iterator>);
+static_assert(std::ranges::random_access_range<decltype(std::declval<HashedArrayTree<int, 4>&>().chunks())>);
+
+GTEST_TEST(HashedArrayTree, ReferencesStableAcrossGrowth)
+{
+    HashedArrayTree<std::string, 8> array;
+    std::vector<const std::string*> refs;
+    for (auto i = 0; i < 1'000; ++i)
+        refs.push_back(&array.emplace_back(std::to_string(i)));
+
+    ASSERT_EQ(std::size(array), 1'000);
+    EXPECT_EQ(array.chunk_count(), 125);
+    for (std::size_t i = 0; i < std::size(array); ++i)
+    {
+        ASSERT_EQ(refs[i], &array[i]);
+        ASSERT_EQ(array[i], std::to_string(i));
+    }
+
+    // removing elements and releasing the empty chunks leaves the others in place
+    for (auto i = 0; i < 500; ++i)
+        array.pop_back();
+    array.shrink_to_fit();
+    EXPECT_EQ(array.capacity(), 504);
+    for (std::size_t i = 0; i < std::size(array); ++i)
+        ASSERT_EQ(refs[i], &array[i]);
+}
+
+GTEST_TEST(HashedArrayTree, CopyMoveSwap)
+{
+    HashedArrayTree<std::string, 8> a;
+    for (auto i = 0; i < 100; ++i)
+        a.push_back(std::to_string(i));
+
+    auto b = a;
+    EXPECT_TRUE(std::equal(std::begin(a), std::end(a), std::begin(b), std::end(b)));
+    EXPECT_NE(&a[0], &b[0]);
+
+    b.clear();
+    b = a;
+    EXPECT_TRUE(std::equal(std::begin(a), std::end(a), std::begin(b), std::end(b)));
+
+    // moves transfer the chunks, references to the elements stay valid
+    const auto first = &a.front();
+    auto       c     = std::move(a);
+    EXPECT_TRUE(std::empty(a));
+    EXPECT_EQ(&c.front(), first);
+    EXPECT_EQ(c.back(), "99");
+
+    a = std::move(c);
+    EXPECT_TRUE(std::empty(c));
+    EXPECT_EQ(&a.front(), first);
+
+    HashedArrayTree<std::string, 8> d;
+    d.push_back("x");
+    a.swap(d);
+    EXPECT_EQ(std::size(a), 1);
+    EXPECT_EQ(a.front(), "x");
+    EXPECT_EQ(std::size(d), 100);
+    EXPECT_EQ(&d.front(), first);
+
+    // the moved from arrays must be reusable
+    c.push_back("y");
+    EXPECT_EQ(c.front(), "y");
+}
+
+GTEST_TEST(HashedArrayTree, SortThroughIterators)
+{
+    HashedArrayTree<int, 16> array;
+    for (auto i = 0; i < 1'000; ++i)
+        array.push_back((i * 7919) % 1'000);
+
+    std::sort(std::begin(array), std::end(array));
+    for (std::size_t i = 0; i < std::size(array); ++i)
+        ASSERT_EQ(array[i], static_cast<int>(i));
+}
+
+GTEST_TEST(HashedArrayTree, ContiguousStorage)
+{
+    HashedArrayTree<std::string, 16> array{ 40, request_contiguous_storage_tag{} };
+    EXPECT_EQ(array.capacity(), 48);
+    for (auto i = 0; i < 100; ++i)
+        array.push_back(std::to_string(i));
+
+    // the initial capacity is a single block, the chunks allocated later aren't
+    for (std::size_t i = 1; i < 48; ++i)
+        ASSERT_EQ(&array[i], &array[i - 1] + 1);
+    EXPECT_EQ(array[99], "99");
+
+    // the initial block is never released
+    array.clear();
+    array.shrink_to_fit();
+    EXPECT_EQ(array.capacity(), 48);
+    array.push_back("x");
+    EXPECT_EQ(array.front(), "x");
+
+    HashedArrayTree<std::string, 16> reserved{ 33 };
+    EXPECT_EQ(reserved.capacity(), 48);
+    EXPECT_TRUE(std::empty(reserved));
+}
+
+GTEST_TEST(HashedArrayTree, Chunks)
+{
+    HashedArrayTree<int, 64> array;
+    for (auto i = 0; i < 1'000; ++i)
+        array.push_back(i);
+
+    // every chunk is full but the last one
+    const auto& view   = array;
+    const auto  chunks = view.chunks();
+    ASSERT_EQ(std::ranges::size(chunks), 16);
+    std::size_t total = 0;
+    for (const auto chunk : chunks)
+    {
+        for (std::size_t i = 0; i < std::size(chunk); ++i)
+            ASSERT_EQ(chunk[i], static_cast<int>(total + i));
+        total += std::size(chunk);
+    }
+    EXPECT_EQ(total, std::size(array));
+    EXPECT_EQ(std::size(chunks[15]), 1'000 - 15 * 64);
+}
+
+GTEST_TEST(HashedArrayTree, ParallelForOverChunks)
+{
+    JobScheduler             scheduler{ { .workers = 3, .queue_size = 64 } };
+    HashedArrayTree<int, 64> array;
+    for (auto i = 0; i < 10'000; ++i)
+        array.push_back(i);
+
+    // each job owns a whole chunk, so the work is split without any false sharing
+    const auto chunks = array.chunks();
+    parallel_for(
+        scheduler, 0, std::size(chunks), [&](std::size_t c) {
+            for (auto& x : chunks[c])
+                x *= 2;
+        },
+        1);
+
+    for (std::size_t i = 0; i < std::size(array); ++i)
+        ASSERT_EQ(array[i], 2 * static_cast<int>(i));
+}
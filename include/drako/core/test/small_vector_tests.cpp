@@ -0,0 +1,231 @@
+#include "drako/core/container/small_vector.hpp"
+#include "drako/concurrency/frame_arena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace drako;
+
+namespace
+{
+    template <typename Vector>
+    void expect_same(const Vector& v, const std::vector<std::string>& model)
+    {
+        ASSERT_EQ(std::size(v), std::size(model));
+        for (std::size_t i = 0; i < std::size(model); ++i)
+            ASSERT_EQ(v[i], model[i]);
+    }
+
+    // forwards to the standard allocator, counting the allocations
+    template <typename T>
+    struct CountingAllocator
+    {
+        using value_type = T;
+
+        std::size_t* allocations;
+
+        CountingAllocator(std::size_t& counter) noexcept
+            : allocations{ &counter } {}
+
+        template <typename U>
+        CountingAllocator(const CountingAllocator<U>& other) noexcept
+            : allocations{ other.allocations } {}
+
+        [[nodiscard]] T* allocate(std::size_t n)
+        {
+            ++*allocations;
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept { std::allocator<T>{}.deallocate(p, n); }
+
+        template <typename U>
+        [[nodiscard]] bool operator==(const CountingAllocator<U>& other) const noexcept
+        {
+            return allocations == other.allocations;
+        }
+    };
+} // namespace
+
+GTEST_TEST(SmallVector, CompareWithVector)
+{
+    // long strings own heap memory, so elements destroyed twice or never show up under sanitizers
+    std::mt19937                rng{ 1 };
+    SmallVector<std::string, 4> v;
+    std::vector<std::string>    model;
+
+    for (auto i = 0; i < 20'000; ++i)
+    {
+        const auto value = std::string(rng() % 40, static_cast<char>('a' + rng() % 26));
+        switch (rng() % 12)
+        {
+            case 0:
+            case 1:
+            case 2:
+                v.push_back(value);
+                model.push_back(value);
+                break;
+
+            case 3:
+                if (!std::empty(model))
+                {
+                    v.pop_back();
+                    model.pop_back();
+                }
+                break;
+
+            case 4:
+            {
+                const auto pos = rng() % (std::size(model) + 1);
+                v.insert(std::begin(v) + pos, value);
+                model.insert(std::begin(model) + pos, value);
+                break;
+            }
+            case 5:
+                if (!std::empty(model))
+                {
+                    const auto pos = rng() % std::size(model);
+                    v.erase(std::begin(v) + pos);
+                    model.erase(std::begin(model) + pos);
+                }
+                break;
+
+            case 6:
+            {
+                const auto count = rng() % 10;
+                v.resize(count, value);
+                model.resize(count, value);
+                break;
+            }
+            case 7:
+            {
+                const auto copy = v;
+                expect_same(copy, model);
+                v = copy;
+                break;
+            }
+            case 8:
+            {
+                auto moved = std::move(v);
+                v          = std::move(moved);
+                break;
+            }
+            case 9:
+                v.shrink_to_fit();
+                if (std::size(model) <= v.inline_capacity)
+                {
+                    ASSERT_TRUE(v.is_inline());
+                }
+                break;
+
+            case 10:
+                // arguments that alias the elements of the vector itself
+                if (!std::empty(model))
+                {
+                    v.push_back(v[0]);
+                    model.push_back(model[0]);
+                    v.emplace(std::begin(v), v.back());
+                    model.insert(std::begin(model), model.back());
+                }
+                break;
+
+            case 11:
+            {
+                SmallVector<std::string, 4> other{ "x", "y" };
+                other.swap(v);
+                expect_same(other, model);
+                other.swap(v);
+
+                const std::vector<std::string> range{ "q", "r" };
+                v.insert(std::end(v), std::begin(range), std::end(range));
+                model.insert(std::end(model), std::begin(range), std::end(range));
+                break;
+            }
+        }
+        expect_same(v, model);
+    }
+}
+
+GTEST_TEST(SmallVector, InlineStorageDoesntAllocate)
+{
+    std::size_t                                 allocations = 0;
+    SmallVector<int, 4, CountingAllocator<int>> v{ CountingAllocator<int>{ allocations } };
+    for (auto i = 0; i < 4; ++i)
+        v.push_back(i);
+    EXPECT_TRUE(v.is_inline());
+    EXPECT_EQ(allocations, 0);
+
+    v.push_back(4);
+    EXPECT_FALSE(v.is_inline());
+    EXPECT_EQ(allocations, 1);
+
+    // back inline once the elements fit again
+    v.pop_back();
+    v.shrink_to_fit();
+    EXPECT_TRUE(v.is_inline());
+    EXPECT_EQ(v, (SmallVector<int, 4, CountingAllocator<int>>{ { 0, 1, 2, 3 }, CountingAllocator<int>{ allocations } }));
+}
+
+GTEST_TEST(SmallVector, MoveOnly)
+{
+    SmallVector<std::unique_ptr<int>, 2> a;
+    for (auto i = 0; i < 10; ++i)
+        a.emplace_back(std::make_unique<int>(i));
+
+    // moving heap storage transfers the allocation
+    const auto elements = std::data(a);
+    auto       b        = std::move(a);
+    EXPECT_TRUE(std::empty(a));
+    EXPECT_EQ(std::data(b), elements);
+    EXPECT_EQ(*b[9], 9);
+
+    SmallVector<std::unique_ptr<int>, 2> c;
+    c.emplace_back(std::make_unique<int>(1));
+    swap(b, c);
+    EXPECT_EQ(std::size(c), 10);
+    EXPECT_EQ(std::size(b), 1);
+    EXPECT_EQ(*b[0], 1);
+    EXPECT_THROW((void)b.at(3), std::out_of_range);
+
+    // moving inline storage moves the elements one by one
+    auto d = std::move(b);
+    EXPECT_TRUE(d.is_inline());
+    EXPECT_EQ(*d[0], 1);
+
+    b = SmallVector<std::unique_ptr<int>, 2>{};
+    EXPECT_TRUE(std::empty(b));
+}
+
+GTEST_TEST(SmallVector, Comparison)
+{
+    const SmallVector<int, 3> a{ 1, 2, 3 }, b{ 1, 2, 4 }, c{ 1, 2, 3, 0 };
+    EXPECT_TRUE(a < b);
+    EXPECT_TRUE(a < c);
+    EXPECT_FALSE(a == b);
+    EXPECT_EQ(a, (SmallVector<int, 3>{ 1, 2, 3 }));
+}
+
+GTEST_TEST(SmallVector, FrameAllocator)
+{
+    FrameArena                arena{ { .frames = 1, .frame_size = 1024, .chunk_size = 256 } };
+    const FrameAllocator<int> al{ arena };
+
+    // outgrows the arena, the allocator falls back to the heap
+    SmallVector<int, 4, FrameAllocator<int>> v{ al };
+    for (auto i = 0; i < 1'000; ++i)
+        v.push_back(i);
+    EXPECT_EQ(v.back(), 999);
+
+    auto w = std::move(v);
+    EXPECT_EQ(std::size(w), 1'000);
+
+    SmallVector<int, 4, FrameAllocator<int>> copy{ al };
+    copy = w;
+    EXPECT_EQ(copy, w);
+    EXPECT_EQ(copy.get_allocator(), al);
+}
@@ -0,0 +1,247 @@
+#include "drako/core/container/soa.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace drako;
+
+namespace
+{
+    struct alignas(32) Wide
+    {
+        double v[4];
+    };
+
+    // throws on the construction selected by the countdown, counts the live instances
+    struct Fragile
+    {
+        static inline int countdown = 0;
+        static inline int live      = 0;
+
+        int value;
+
+        Fragile(int v)
+            : value{ v }
+        {
+            _count();
+        }
+
+        Fragile(const Fragile& other)
+            : value{ other.value }
+        {
+            _count();
+        }
+
+        // potentially throwing, so the table relocates by copy
+        Fragile(Fragile&& other) noexcept(false)
+            : Fragile{ static_cast<const Fragile&>(other) }
+        {
+        }
+
+        Fragile& operator=(const Fragile&) = default;
+        Fragile& operator=(Fragile&&) = default;
+
+        ~Fragile() noexcept { --live; }
+
+    private:
+        void _count()
+        {
+            if (--countdown == 0)
+                throw std::runtime_error{ "construction failed" };
+            ++live;
+        }
+    };
+} // namespace
+
+GTEST_TEST(SoaTable, HandlesFollowRows)
+{
+    soa::Table<std::uint32_t, std::string, std::unique_ptr<int>, bool, Wide> table;
+    std::map<std::uint32_t, decltype(table)::Handle>                          handles;
+
+    const auto expect_rows = [&]() {
+        ASSERT_EQ(std::size(table), std::size(handles));
+        for (const auto& [key, h] : handles)
+        {
+            ASSERT_TRUE(table.contains(h));
+            const auto row = table.index(h);
+            ASSERT_EQ(table.handle(row), h);
+            ASSERT_EQ(table.column<std::uint32_t>()[row], key);
+            ASSERT_EQ(table.column<1>()[row], std::to_string(key));
+            ASSERT_EQ(*table.column<2>()[row], static_cast<int>(key));
+            ASSERT_EQ(table.column<bool>()[row], key % 2 == 0);
+            ASSERT_EQ(table.column<Wide>()[row].v[0], static_cast<double>(key));
+        }
+    };
+
+    // random erasures move the last row in the hole
+    std::mt19937 rng{ 3 };
+    for (std::uint32_t key = 0; key < 2'000; ++key)
+    {
+        handles[key] = table.emplace_back(key, std::to_string(key), std::make_unique<int>(key), key % 2 == 0, Wide{ { static_cast<double>(key) } });
+        if (rng() % 3 == 0)
+        {
+            const auto it = std::next(std::begin(handles), rng() % std::size(handles));
+            table.erase(it->second);
+            ASSERT_FALSE(table.contains(it->second));
+            handles.erase(it);
+        }
+    }
+    expect_rows();
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(std::data(table.column<Wide>())) % alignof(Wide), 0);
+
+    table.sort<std::string>();
+    EXPECT_TRUE(std::is_sorted(std::begin(table.column<1>()), std::end(table.column<1>())));
+    expect_rows();
+
+    table.sort<0>(std::greater<>{});
+    EXPECT_TRUE(std::is_sorted(std::begin(table.column<0>()), std::end(table.column<0>()), std::greater<>{}));
+    expect_rows();
+
+    auto moved = std::move(table);
+    EXPECT_TRUE(std::empty(table));
+    table = std::move(moved);
+    expect_rows();
+
+    table.clear();
+    EXPECT_TRUE(std::empty(table));
+    for (const auto& [key, h] : handles)
+        EXPECT_FALSE(table.contains(h));
+}
+
+GTEST_TEST(SoaTable, GenerationsInvalidateReusedSlots)
+{
+    soa::Table<int> table;
+    const auto      first = table.push_back(1);
+    table.erase(first);
+    EXPECT_FALSE(table.contains(first));
+
+    // the slot is recycled for the next row, with a new generation
+    const auto second = table.push_back(2);
+    EXPECT_EQ(second.slot, first.slot);
+    EXPECT_NE(second.generation, first.generation);
+    EXPECT_FALSE(table.contains(first));
+    EXPECT_TRUE(table.contains(second));
+
+    EXPECT_FALSE(table.contains(decltype(table)::Handle{}));
+}
+
+GTEST_TEST(SoaTable, EraseMovesLastRow)
+{
+    soa::Table<int, std::string> table;
+    std::vector<decltype(table)::Handle> handles;
+    for (auto i = 0; i < 5; ++i)
+        handles.push_back(table.push_back(i, std::to_string(i)));
+
+    table.erase(std::size_t{ 1 });
+    ASSERT_EQ(std::size(table), 4);
+    EXPECT_EQ(table.column<int>()[1], 4);
+    EXPECT_EQ(table.column<std::string>()[1], "4");
+    EXPECT_EQ(table.index(handles[4]), 1);
+
+    table.pop_back();
+    EXPECT_FALSE(table.contains(handles[3]));
+    EXPECT_EQ(std::size(table), 3);
+}
+
+GTEST_TEST(SoaTable, Permute)
+{
+    soa::Table<int, std::string> table;
+    std::vector<decltype(table)::Handle> handles;
+    for (auto i = 0; i < 6; ++i)
+        handles.push_back(table.push_back(i, std::to_string(i)));
+
+    const std::size_t order[] = { 3, 0, 5, 1, 4, 2 };
+    table.permute(order);
+    for (std::size_t row = 0; row < std::size(order); ++row)
+    {
+        EXPECT_EQ(table.column<int>()[row], static_cast<int>(order[row]));
+        EXPECT_EQ(table.column<std::string>()[row], std::to_string(order[row]));
+        EXPECT_EQ(table.index(handles[order[row]]), row);
+    }
+}
+
+GTEST_TEST(SoaTable, ReserveSingleAllocation)
+{
+    soa::Table<std::uint8_t, double, Wide> table{ 10 };
+    ASSERT_EQ(table.capacity(), 10);
+
+    // columns are laid out one after the other in the same block, padded to their alignment
+    const auto align = [](std::uintptr_t p, std::size_t a) { return (p + a - 1) / a * a; };
+    const auto bytes = reinterpret_cast<std::uintptr_t>(std::data(table.column<0>()));
+    const auto reals = reinterpret_cast<std::uintptr_t>(std::data(table.column<1>()));
+    const auto wides = reinterpret_cast<std::uintptr_t>(std::data(table.column<2>()));
+    EXPECT_EQ(reals, align(bytes + 10 * sizeof(std::uint8_t), alignof(double)));
+    EXPECT_EQ(wides, align(reals + 10 * sizeof(double), alignof(Wide)));
+
+    // growth is geometric
+    for (auto i = 0; i < 11; ++i)
+        table.push_back(static_cast<std::uint8_t>(i), i, Wide{});
+    EXPECT_EQ(table.capacity(), 20);
+}
+
+GTEST_TEST(SoaTable, ReserveFailureLeavesTableUnchanged)
+{
+    {
+        Fragile::countdown = 0;
+        soa::Table<std::string, Fragile, std::string> table{ 4 };
+        for (auto i = 0; i < 4; ++i)
+            table.emplace_back(std::string(50, 'a'), i, std::string(50, 'b'));
+        ASSERT_EQ(Fragile::live, 4);
+
+        // the third copy of the relocation throws, the copies already made must be released
+        Fragile::countdown = 3;
+        EXPECT_THROW(table.reserve(64), std::runtime_error);
+        EXPECT_EQ(Fragile::live, 4);
+        EXPECT_EQ(table.capacity(), 4);
+        ASSERT_EQ(std::size(table), 4);
+        for (auto i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(table.column<1>()[i].value, i);
+            EXPECT_EQ(table.column<0>()[i], std::string(50, 'a'));
+            EXPECT_EQ(table.column<2>()[i], std::string(50, 'b'));
+        }
+
+        Fragile::countdown = 0;
+        table.reserve(64);
+        EXPECT_EQ(Fragile::live, 4);
+        EXPECT_EQ(table.column<1>()[3].value, 3);
+    }
+    EXPECT_EQ(Fragile::live, 0);
+}
+
+GTEST_TEST(SoaTable, EmplaceFailureLeavesTableUnchanged)
+{
+    {
+        soa::Table<std::string, Fragile, std::string> table{ 8 };
+
+        Fragile::countdown = 5;
+        auto inserted      = 0;
+        try
+        {
+            for (;; ++inserted)
+                table.emplace_back(std::string(50, 'a'), inserted, std::string(50, 'b'));
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        EXPECT_EQ(inserted, 4);
+        EXPECT_EQ(std::size(table), 4);
+        EXPECT_EQ(Fragile::live, 4);
+
+        // the slot taken by the failed row is available again
+        Fragile::countdown = 0;
+        const auto h       = table.emplace_back("a", 4, "b");
+        EXPECT_EQ(table.index(h), 4);
+        EXPECT_EQ(table.column<1>()[4].value, 4);
+    }
+    EXPECT_EQ(Fragile::live, 0);
+}
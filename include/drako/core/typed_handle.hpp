@@ -57,8 +57,7 @@ namespace drako
         constexpr BasicTypedID(const BasicTypedID&) noexcept = default;
         constexpr BasicTypedID& operator=(const BasicTypedID&) noexcept = default;
 
-        //[[nodiscard]] friend bool operator==(const _this, const _this) noexcept = default;
-        //[[nodiscard]] friend bool operator!=(const _this, const _this) noexcept = default;
+        [[nodiscard]] friend constexpr bool operator==(const BasicTypedID&, const BasicTypedID&) noexcept = default;
         //[[nodiscard]] friend bool operator<(const _this, const _this) noexcept  = default;
         //[[nodiscard]] friend bool operator>(const _this, const _this) noexcept  = default;
         //[[nodiscard]] friend bool operator<=(const _this, const _this) noexcept = default;
@@ -3,7 +3,10 @@
 #define DRAKO_ASSET_SYSTEM_HPP
 
 #include "drako/concurrency/async_reader_pool.hpp"
+#include "drako/concurrency/frame_arena.hpp"
+#include "drako/concurrency/lockfree_mpsc_queue.hpp"
 #include "drako/concurrency/lockfree_ringbuffer.hpp"
+#include "drako/core/container/soa.hpp"
 #include "drako/devel/asset_types.hpp"
 #include "drako/devel/asset_utils.hpp"
 #include "drako/graphics/mesh_types.hpp"
@@ -13,14 +16,17 @@
 #include <cassert>
 #include <filesystem>
 #include <functional>
+#include <memory>
 #include <vector>
 
 namespace drako::engine
 {
     struct AssetLoadRequest
     {
+        /// @brief Assets to load, copied when the request is submitted.
         std::span<const AssetID> assets;
-        std::function<void()>    callback;
+
+        std::function<void()> callback;
     };
 
 
@@ -66,7 +72,12 @@ namespace drako::engine
         //void release_bundle(const AssetBundleID id) noexcept;
 
         void acquire_asset(const AssetID) noexcept;
-        void acquire_asset(const AssetLoadRequest&) noexcept;
+
+        /// @brief Submits a request for a group of assets.
+        ///
+        /// @throw std::bad_alloc if the copy of the request can't be allocated.
+        ///
+        void acquire_asset(const AssetLoadRequest&);
 
         void release_asset(const AssetID) noexcept;
         //void release_asset(std::span<const AssetID>) noexcept;
@@ -96,18 +107,22 @@ namespace drako::engine
 
         const ConfigArgs _config;
 
-        //AsyncReaderPool _io_service;
+        // storage for temporaries of a single update cycle
+        FrameArena _frame_arena{ { .frames = 1, .frame_size = 64 * 1024, .chunk_size = 8 * 1024 } };
 
-        // TODO: vvv those needs to be threadsafe vvv
-        std::vector<AssetBundleID> _bundle_load_list; // load requests
-        std::vector<AssetBundleID> _bundle_dump_list; // unload requests
-        // TODO: ^^^ those needs to be threadsafe ^^^
+        // requests submitted by any thread, drained once per update
+        lockfree::SR_MW_Queue<AssetBundleID> _bundle_load_list; // load requests
+        lockfree::SR_MW_Queue<AssetBundleID> _bundle_dump_list; // unload requests
 
-        // TODO: vvv those needs to be threadsafe vvv
-        std::vector<AssetID>          _asset_load_list; // load requests
-        std::vector<AssetID>          _asset_dump_list; // unload requests
-        std::vector<AssetLoadRequest> _asset_load_requests;
-        // TODO: ^^^ those needs to be threadsafe ^^^
+        lockfree::SR_MW_Queue<AssetID>          _asset_load_list; // load requests
+        lockfree::SR_MW_Queue<AssetID>          _asset_dump_list; // unload requests
+        // owns a copy of the assets, the span of the caller is only valid during the submission
+        struct _queued_load_request
+        {
+            std::vector<AssetID>  assets;
+            std::function<void()> callback;
+        };
+        lockfree::SR_MW_Queue<_queued_load_request> _asset_load_requests;
 
         struct _pending_bundle_request
         {
@@ -122,17 +137,16 @@ namespace drako::engine
 
         struct _pending_asset_request
         {
-            _request_id          id;
-            AssetID              asset;
-            std::span<std::byte> data;
-            std::uint32_t        refcount;
+            AsyncReaderPool::Ticket  ticket;
+            AssetID                  asset;
+            std::size_t              index;    // position in the table of available assets
+            rio::UniqueInputFile     file;     // kept open until the read completes
+            AsyncReaderPool::Request read;     // referenced by the reader pool
+            std::uint32_t            refcount; // references acquired while loading
         };
 
-        struct _pending_assets_table
-        {
-            std::vector<AssetID>                ids;
-            std::vector<_pending_asset_request> requests;
-        } _pending_assets;
+        // columns: asset, request (stable address, referenced by the reader pool)
+        soa::Table<AssetID, std::unique_ptr<_pending_asset_request>> _pending_assets;
 
         struct _batch_request_handle
         {
@@ -144,39 +158,33 @@ namespace drako::engine
         //Pool<_batch_request_handle>   _batch_handles_pool;   // local allocator
         //Pool<_pending_bundle_request> _bundle_requests_pool; // local allocator for requests
 
-        struct _available_bundles_table
-        {
-            std::vector<AssetBundleID>        ids;
-            std::vector<rio::UniqueInputFile> sources;
-            std::vector<std::size_t>          sizes;
-            std::vector<std::string>          names;
-        } _available_bundles;
+        // columns: bundle, source file, size in bytes, name
+        soa::Table<AssetBundleID, rio::UniqueInputFile, std::size_t, std::string> _available_bundles;
 
-        struct _loaded_bundles_table
-        {
-            std::vector<AssetBundleID>       ids;
-            std::vector<AssetBundleManifest> manifests;
-            std::vector<std::uint16_t>       refcount;
-        } _loaded_bundles;
+        // columns: bundle, manifest, refcount
+        soa::Table<AssetBundleID, AssetBundleManifest, std::uint16_t> _loaded_bundles;
 
-        struct _loaded_assets_table
-        {
-            std::vector<AssetID>                      ids;
-            std::vector<std::unique_ptr<std::byte[]>> data;
-            std::vector<std::uint16_t>                refcount;
-        } _loaded_assets;
+        // columns: asset, data, refcount
+        soa::Table<AssetID, std::unique_ptr<std::byte[]>, std::uint16_t> _loaded_assets;
 
-        struct _available_assets_table
-        {
-            std::vector<AssetID>                      ids;
-            std::vector<std::unique_ptr<std::byte[]>> data;
-            std::vector<std::uint32_t>                refcount;
-            std::vector<AssetLoadInfo>                meta;
-        } _assets;
+        // columns: asset, data, refcount, load info
+        soa::Table<AssetID, std::unique_ptr<std::byte[]>, std::uint32_t, AssetLoadInfo> _assets;
+
+        // declared last, so that reads in flight are drained before their buffers are released
+        AsyncReaderPool _io_service{ { .workers = 2, .submit_queue_size = 256, .output_queue_size = 256 } };
 
         void _handle_bundle_requests();
         void _handle_asset_requests();
 
+        // collects the completed reads of pending assets
+        void _reap_asset_loads();
+
+        // starts the reads of the assets that are neither loaded nor pending
+        void _load_assets(std::span<const AssetID>);
+
+        // moves an asset whose data has been read to the table of loaded assets
+        void _commit_asset(const AssetID, std::size_t index, std::uint32_t refcount);
+
         // check whether an asset is in memory
         [[nodiscard]] bool _loaded(const AssetID) noexcept;
 
@@ -185,6 +193,8 @@ namespace drako::engine
 
         void _inc_ref_count(const AssetID) noexcept;
 
+        void _inc_pending_ref_count(const AssetID) noexcept;
+
         void _dec_ref_count(const AssetID) noexcept;
     };
 
@@ -192,34 +202,35 @@ namespace drako::engine
     inline void AssetSystemRuntime::load_bundle(const AssetBundleID id) noexcept
     {
         assert(id);
-        _bundle_load_list.push_back(id);
+        _bundle_load_list.enque(id);
     }
 
     inline void AssetSystemRuntime::unload_bundle(const AssetBundleID id) noexcept
     {
         assert(id);
-        _bundle_dump_list.push_back(id);
+        _bundle_dump_list.enque(id);
     }
     */
 
     inline void AssetSystemRuntime::acquire_asset(const AssetID a) noexcept
     {
         assert(a);
-        _asset_load_list.push_back(a);
+        _asset_load_list.enque(a);
     }
 
-    inline void AssetSystemRuntime::acquire_asset(const AssetLoadRequest& r) noexcept
+    inline void AssetSystemRuntime::acquire_asset(const AssetLoadRequest& r)
     {
         for (const auto& a : r.assets)
             assert(a);
 
-        _asset_load_requests.push_back(r);
+        _asset_load_requests.enque(_queued_load_request{
+            .assets = { std::begin(r.assets), std::end(r.assets) }, .callback = r.callback });
     }
 
     inline void AssetSystemRuntime::release_asset(const AssetID a) noexcept
     {
         assert(a);
-        _asset_dump_list.push_back(a);
+        _asset_dump_list.enque(a);
     }
 
 } // namespace drako::engine
@@ -2,6 +2,10 @@
 #ifndef DRAKO_RENDER_SYSTEM_HPP
 #define DRAKO_RENDER_SYSTEM_HPP
 
+#include "drako/concurrency/lock.hpp"
+#include "drako/concurrency/lockfree_bip_buffer.hpp"
+#include "drako/concurrency/lockfree_mpsc_queue.hpp"
+#include "drako/core/container/soa.hpp"
 #include "drako/core/typed_handle.hpp"
 #include "drako/graphics/material_types.hpp"
 #include "drako/graphics/mesh_types.hpp"
@@ -12,6 +16,11 @@
 
 #include <glm/mat4x4.hpp>
 
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <type_traits>
 #include <vector>
 
 namespace drako
@@ -26,7 +35,7 @@ namespace drako
 
     struct mesh_create_info
     {
-        mesh data;
+        Mesh data;
     };
 
     struct shader_create_info
@@ -54,6 +63,8 @@ namespace drako
 
         explicit RenderSystem(const vulkan::Context& ctx) noexcept;
 
+        ~RenderSystem() noexcept;
+
         //void create(pipeline_id, const vulkan::graphics_pipeline&) noexcept;
         void create(mesh_id, const mesh_create_info&) noexcept;
         //void create(texture_id, const texture_view&) noexcept;
@@ -63,56 +74,72 @@ namespace drako
 
         void destroy(mesh_id) noexcept;
         void destroy(shader_id) noexcept;
+        void destroy(render_id) noexcept;
 
         void update(const frame_render_soa&) noexcept;
 
     private:
-        template <typename TID, typename TInfo>
-        struct _basic_cmd
+        enum class _cmd : std::uint32_t
+        {
+            create_mesh,
+            create_shader,
+            create_entity,
+        };
+
+        struct _mesh_create_cmd // followed by vertex and index data, unless spilled
         {
-            TInfo info;
-            TID   id;
+            mesh_id       id;
+            std::uint32_t vertex_bytes;
+            std::uint32_t index_bytes;
+            std::byte*    spilled; // heap copy of the data of large meshes, owned by the command
+        };
+        // commands are copied in and out of the ring as raw bytes
+        static_assert(std::is_trivially_copyable_v<_mesh_create_cmd>);
+
+        struct _shader_create_cmd
+        {
+            shader_id          id;
+            shader_create_info info;
+        };
+        static_assert(std::is_trivially_copyable_v<_shader_create_cmd>);
 
-            explicit _basic_cmd(TID _id, const TInfo& _info) noexcept
-                : info{ _info }, id{ _id } {}
+        struct _renderable_create_cmd
+        {
+            render_id              id;
+            renderable_create_info info;
         };
+        static_assert(std::is_trivially_copyable_v<_renderable_create_cmd>);
+
+        // capacity of the first ring of commands
+        static constexpr const std::size_t _command_ring_bytes = 4 * 1024 * 1024;
 
-        using _mesh_create_cmd       = _basic_cmd<mesh_id, mesh_create_info>;
-        using _shader_create_cmd     = _basic_cmd<shader_id, shader_create_info>;
-        using _renderable_create_cmd = _basic_cmd<render_id, renderable_create_info>;
+        // meshes with more data are copied to the heap instead of the command stream
+        static constexpr const std::size_t _inline_mesh_bytes = 64 * 1024;
 
         /* currently available resources */
 
-        struct _avail_mesh_soa
-        {
-            std::vector<mesh_id> id;
-            std::vector<mesh>    meshes;
-        } meshes;
+        // columns: mesh, data
+        soa::Table<mesh_id, Mesh> _meshes;
 
         /* resources scheduled for construction */
 
-        std::vector<_mesh_create_cmd>       _create_meshes;   // TODO: needs to be threadsafe
-        std::vector<_shader_create_cmd>     _create_shaders;  // TODO: needs to be threadsafe
-        std::vector<_renderable_create_cmd> _create_entities; // TODO: needs to be threadsafe
+        // commands of variable size are recorded in place, without an allocation for each of them;
+        // a burst that doesn't fit continues in a larger ring, consumed after the previous ones
+        std::deque<std::unique_ptr<lockfree::CommandRing>> _create_commands;
+        concurrency::spin_lock _create_commands_lock; // guards the chain, rings accept a single producer at a time
 
         /* resources that completed transfert on gpu */
 
-        std::vector<mesh_id> _transferred_meshes; // TODO: needs to be threadsafe
+        lockfree::SR_MW_Queue<mesh_id> _transferred_meshes;
 
         /* resources scheduled for destruction */
 
-        std::vector<mesh_id>   _destroy_meshes;   // TODO: needs to be threadsafe
-        std::vector<shader_id> _destroy_shaders;  // TODO: needs to be threadsafe
-        std::vector<render_id> _destroy_entities; // TODO: needs to be threadsafe
+        lockfree::SR_MW_Queue<mesh_id>   _destroy_meshes;
+        lockfree::SR_MW_Queue<shader_id> _destroy_shaders;
+        lockfree::SR_MW_Queue<render_id> _destroy_entities;
 
-        struct _renderable_table
-        {
-            std::vector<render_id>   ids;
-            std::vector<mesh_id>     meshes;
-            std::vector<material_id> materials;
-            std::vector<pipeline_id> pipelines;
-        };
-        _renderable_table _entities;
+        // columns: entity, mesh, material, pipeline
+        soa::Table<render_id, mesh_id, material_id, pipeline_id> _entities;
 
         vulkan::RenderEngine _renderer;
 
@@ -120,7 +147,15 @@ namespace drako
 
         void _update_entities() noexcept;
 
-        void _create_gpu_mesh(mesh_id, const mesh&);
+        void _execute_commands() noexcept;
+
+        // reserves a command at the end of the chain, called with the lock held
+        [[nodiscard]] std::span<std::byte> _reserve_command(_cmd, std::size_t bytes);
+
+        template <typename Visitor>
+        void _consume_commands(Visitor&&);
+
+        void _create_gpu_mesh(mesh_id, const MeshView&);
         void _destroy_gpu_mesh(mesh_id);
     };
 
@@ -1,21 +1,26 @@
 #include "drako/engine/asset_system.hpp"
 
+#include "drako/core/container/small_vector.hpp"
 #include "drako/devel/asset_bundle_types.hpp"
 #include "drako/devel/project_utils.hpp"
 
 #include <rio/input_file_handle.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <filesystem>
+#include <memory>
+#include <span>
 #include <vector>
 
 namespace drako::engine
 {
     // convert a list of IDs to a list of indices
-    [[nodiscard]] std::vector<std::size_t> _id_to_index(
-        const std::vector<AssetID>& table, const std::vector<AssetID>& assets)
+    [[nodiscard]] std::vector<std::size_t, FrameAllocator<std::size_t>> _id_to_index(
+        std::span<const AssetID> table, std::span<const AssetID> assets, FrameAllocator<std::size_t> alloc)
     {
-        std::vector<std::size_t> indices;
+        std::vector<std::size_t, FrameAllocator<std::size_t>> indices{ alloc };
         indices.reserve(std::size(assets));
 
         for (const auto& a : assets)
@@ -30,22 +35,59 @@ namespace drako::engine
 
     bool AssetSystemRuntime::_loaded(const AssetID id) noexcept
     {
-        const auto& t = _loaded_assets.ids;
+        const auto t = _loaded_assets.column<AssetID>();
         return std::find(std::cbegin(t), std::cend(t), id) != std::cend(t);
     }
 
     bool AssetSystemRuntime::_pending(const AssetID id) noexcept
     {
-        const auto& t = _pending_assets.ids;
+        const auto t = _pending_assets.column<AssetID>();
         return std::find(std::cbegin(t), std::cend(t), id) != std::cend(t);
     }
 
     void AssetSystemRuntime::_inc_ref_count(const AssetID id) noexcept
     {
-        auto&      t     = _loaded_assets;
-        const auto it    = std::find(std::cbegin(t.ids), std::cend(t.ids), id);
-        const auto index = std::distance(std::cbegin(t.ids), it);
-        ++t.refcount[index];
+        const auto ids   = _loaded_assets.column<AssetID>();
+        const auto it    = std::find(std::cbegin(ids), std::cend(ids), id);
+        const auto index = std::distance(std::cbegin(ids), it);
+        ++_loaded_assets.column<std::uint16_t>()[index];
+    }
+
+    void AssetSystemRuntime::_inc_pending_ref_count(const AssetID id) noexcept
+    {
+        const auto ids   = _pending_assets.column<AssetID>();
+        const auto it    = std::find(std::cbegin(ids), std::cend(ids), id);
+        const auto index = std::distance(std::cbegin(ids), it);
+        ++_pending_assets.column<1>()[index]->refcount;
+    }
+
+    void AssetSystemRuntime::_commit_asset(const AssetID id, std::size_t index, std::uint32_t refcount)
+    {
+        _loaded_assets.push_back(id,
+            std::move(_assets.column<std::unique_ptr<std::byte[]>>()[index]),
+            static_cast<std::uint16_t>(refcount));
+    }
+
+    void AssetSystemRuntime::_reap_asset_loads()
+    {
+        std::array<AsyncReaderPool::Completion, 64> completed;
+        for (std::size_t n; (n = _io_service.poll(completed)) > 0;)
+            for (const auto& c : std::span{ completed }.first(n))
+            {
+                const auto requests = _pending_assets.column<1>();
+                const auto it       = std::find_if(std::begin(requests), std::end(requests),
+                    [&](const auto& r) { return std::addressof(r->read) == c.request; });
+                assert(it != std::end(requests));
+
+                const auto& r = **it;
+                if (!c.error && c.bytes == std::size(r.read.dst))
+                    _commit_asset(r.asset, r.index, r.refcount);
+                else // failed load, can be requested again
+                    _assets.column<std::unique_ptr<std::byte[]>>()[r.index].reset();
+
+                // swap and pop, the order of pending requests is irrelevant
+                _pending_assets.erase(static_cast<std::size_t>(std::distance(std::begin(requests), it)));
+            }
     }
 
 
@@ -113,57 +155,92 @@ namespace drako::engine
         */
     }
 
-    void AssetSystemRuntime::_handle_asset_requests()
+    void AssetSystemRuntime::_load_assets(std::span<const AssetID> assets)
     {
-        for (const auto& request : _asset_load_requests)
+        const FrameAllocator<AssetID> alloc{ _frame_arena };
+
+        // most requests miss a handful of assets, which stay inline
+        SmallVector<AssetID, 16, FrameAllocator<AssetID>>             assets_to_load{ alloc };
+        SmallVector<std::uint32_t, 16, FrameAllocator<std::uint32_t>> refcounts{ alloc };
+        for (const auto& asset : assets)
         {
-            std::vector<AssetID> assets_to_load;
-            for (const auto& asset : request.assets)
+            if (_loaded(asset))
+                _inc_ref_count(asset);
+            else
             {
-                if (_loaded(asset))
-                    _inc_ref_count(asset);
+                if (_pending(asset))
+                    _inc_pending_ref_count(asset);
+                else if (const auto it = std::find(std::begin(assets_to_load), std::end(assets_to_load), asset);
+                         it != std::end(assets_to_load))
+                {
+                    // listed more than once by the request, the asset is read only once
+                    ++refcounts[std::distance(std::begin(assets_to_load), it)];
+                }
                 else
                 {
-                    if (_pending(asset))
-                        _inc_ref_count(asset);
-                    else
-                        assets_to_load.push_back(asset);
+                    assets_to_load.push_back(asset);
+                    refcounts.push_back(1);
                 }
             }
+        }
 
-            if (!std::empty(assets_to_load))
-            {
-                // set up a batch handle
-                //auto batch      = _batch_handles_pool.allocate(1);
-                //batch->callback = request.callback;
-                //batch->counter  = std::size(assets_to_load);
-                //batch->handles.reserve(std::size(assets_to_load));
+        if (!std::empty(assets_to_load))
+        {
+            // set up a batch handle
+            //auto batch      = _batch_handles_pool.allocate(1);
+            //batch->callback = request.callback;
+            //batch->counter  = std::size(assets_to_load);
+            //batch->handles.reserve(std::size(assets_to_load));
 
-                const auto indices = _id_to_index(_loaded_assets.ids, assets_to_load);
+            const auto ids     = _assets.column<AssetID>();
+            const auto data    = _assets.column<std::unique_ptr<std::byte[]>>();
+            const auto indices = _id_to_index(ids, assets_to_load, alloc);
 
-                for (const auto& i : indices)
-                    assert(!_assets.data[i]); // asset is not loaded
+            for (const auto& i : indices)
+                assert(!data[i]); // asset is not loaded
 
-//#pragma omp parallel for
-                for (const auto& i : indices)
-                {
-                    const auto& path = _config.asset_data_directory /
-                                       editor::guid_to_datafile(_assets.ids[i]);
-                    rio::UniqueInputFile file{ path };
+            // all the reads are in flight at the same time, completions are reaped by the next updates
+            for (std::size_t k = 0; k < std::size(indices); ++k)
+            {
+                const auto  i    = indices[k];
+                const auto& path = _config.asset_data_directory /
+                                   editor::guid_to_datafile(ids[i]);
+
+                const auto& meta = _assets.column<AssetLoadInfo>()[i];
+                data[i]          = std::make_unique_for_overwrite<std::byte[]>(meta.packed_size_bytes());
 
-                    const auto& meta = _assets.meta[i];
-                    _assets.data[i]  = std::make_unique_for_overwrite<std::byte[]>(meta.packed_size_bytes());
+                auto r = std::make_unique<_pending_asset_request>(_pending_asset_request{
+                    .ticket = {}, .asset = ids[i], .index = i, .file = rio::UniqueInputFile{ path }, .read = {}, .refcount = refcounts[k] });
+                r->read = { .src = r->file.native_handle(),
+                    .dst = { data[i].get(), meta.packed_size_bytes() }, .offset = 0 };
 
-                    rio::read_exact(file, { _assets.data[i].get(), meta.packed_size_bytes() });
-                    _assets.refcount[i] = 1;
+                if (const auto ticket = _io_service.submit(&r->read); ticket)
+                {
+                    r->ticket         = *ticket;
+                    const auto target = r->asset;
+                    _pending_assets.push_back(target, std::move(r));
+                }
+                else // the pool is out of memory, fall back to a blocking read
+                {
+                    rio::read_exact(r->file, r->read.dst);
+                    _commit_asset(r->asset, i, r->refcount);
                 }
             }
         }
     }
 
+    void AssetSystemRuntime::_handle_asset_requests()
+    {
+        _frame_arena.advance(); // temporaries of the previous update are no longer referenced
+
+        _reap_asset_loads();
+
+        _asset_load_requests.drain([&](_queued_load_request&& r) { _load_assets(r.assets); });
+        _asset_load_list.drain([&](AssetID a) { _load_assets({ &a, 1 }); });
+    }
+
     AssetSystemRuntime::AssetSystemRuntime(const BundlesArgs& bundles, const ConfigArgs& config)
         : _config{ config }
-    //, _io_service{ { .workers = 4, .submit_queue_size = 100, .output_queue_size = 100 } }
     //, _asset_requests_pool{ 100 }
     //, _bundle_requests_pool{ 100 }
     {
@@ -192,19 +269,13 @@ namespace drako::engine
                 std::data(view.ids()), view.ids().size_bytes());
         }*/
 
-        _available_bundles.ids   = bundles.ids;
-        _available_bundles.names = bundles.names;
-        //_available_bundles.ids.reserve(std::size(bundles.ids));
-        //_available_bundles.sources.reserve(std::size(bundles.ids));
-        for (const auto& id : bundles.ids)
+        _available_bundles.reserve(std::size(bundles.ids));
+        for (std::size_t i = 0; i < std::size(bundles.ids); ++i)
         {
-            const auto path = bundle_meta_filename(id);
+            const auto path = bundle_meta_filename(bundles.ids[i]);
             const auto size = static_cast<std::size_t>(_fs::file_size(path));
-            _available_bundles.sources.emplace_back(path);
-            _available_bundles.sizes.push_back(size);
+            _available_bundles.emplace_back(bundles.ids[i], path, size, bundles.names[i]);
         }
-        //_available_bundles.sources.shrink_to_fit();
-        //_available_bundles.sizes.shrink_to_fit();
     }
 
     void AssetSystemRuntime::update()
@@ -217,32 +288,32 @@ namespace drako::engine
     {
         std::cout << "[available_bundles]\n[id]\t\t[name]\t\t[size(bytes)]\n";
         const auto& t = _available_bundles;
-        for (auto i = 0; i < std::size(t.ids); ++i)
-            std::cout << t.ids[i] << '\t\t'
-                      << t.names[i] << '\t\t'
-                      << t.sizes[i] << '\n';
+        for (auto i = 0; i < std::size(t); ++i)
+            std::cout << t.column<AssetBundleID>()[i] << '\t\t'
+                      << t.column<std::string>()[i] << '\t\t'
+                      << t.column<std::size_t>()[i] << '\n';
     }
 
     void AssetSystemRuntime::debug_print_loaded_bundles()
     {
         std::cout << "[loaded_bundles]\n[id]\t\t[references]\n";
         const auto& t = _loaded_bundles;
-        for (auto i = 0; i < std::size(t.ids); ++i)
-            std::cout << t.ids[i] << '\t\t'
-                      << t.refcount[i] << '\n';
+        for (auto i = 0; i < std::size(t); ++i)
+            std::cout << t.column<AssetBundleID>()[i] << '\t\t'
+                      << t.column<std::uint16_t>()[i] << '\n';
     }
 
     void AssetSystemRuntime::debug_print_assets()
     {
         std::cout << "Loaded assets (ID | refcount):\n";
         const auto& t = _loaded_assets;
-        for (auto i = 0; i < std::size(t.ids); ++i)
-            std::cout << t.ids[i] << ' ' << t.refcount[i] << '\n';
+        for (auto i = 0; i < std::size(t); ++i)
+            std::cout << t.column<AssetID>()[i] << ' ' << t.column<std::uint16_t>()[i] << '\n';
     }
 
     [[nodiscard]] bool AssetSystemRuntime::debug_check_asset_loaded(std::span<const AssetID> s) noexcept
     {
-        const auto& ids = _loaded_assets.ids;
+        const auto ids = _loaded_assets.column<AssetID>();
         for (const auto& asset : s)
             if (std::find(std::cbegin(ids), std::cend(ids), asset) == std::cend(ids))
                 return false;
@@ -251,7 +322,7 @@ namespace drako::engine
 
     [[nodiscard]] bool AssetSystemRuntime::debug_check_bundle_loaded(std::span<const AssetBundleID> s) noexcept
     {
-        const auto& ids = _loaded_bundles.ids;
+        const auto ids = _loaded_bundles.column<AssetBundleID>();
         for (const auto& bundle : s)
             if (std::find(std::cbegin(ids), std::cend(ids), bundle) == std::cend(ids))
                 return false;
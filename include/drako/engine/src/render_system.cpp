@@ -6,6 +6,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <vector>
 
 namespace drako
@@ -17,20 +22,104 @@ namespace drako
 
     void _this::_update_meshes() noexcept
     {
-        // TODO: impl
+        _transferred_meshes.drain([](mesh_id) {
+            // TODO: impl
+        });
     }
 
     void _this::_update_entities() noexcept
     {
         // TODO: impl
-        for (const auto& e : _create_entities)
+    }
+
+    std::span<std::byte> _this::_reserve_command(_cmd type, std::size_t bytes)
+    {
+        if (const auto payload = _create_commands.back()->reserve(static_cast<std::uint32_t>(type), bytes); !std::empty(payload))
+            return payload;
+
+        // the consumer is behind, the commands that follow go to a larger ring
+        const auto capacity = 2 * _create_commands.back()->capacity();
+        assert(bytes < capacity / 2); // large payloads are spilled by the caller
+        const auto& ring = _create_commands.emplace_back(std::make_unique<lockfree::CommandRing>(capacity));
+        return ring->reserve(static_cast<std::uint32_t>(type), bytes);
+    }
+
+    template <typename Visitor>
+    void _this::_consume_commands(Visitor&& visitor)
+    {
+        for (;;)
         {
-            _entities.ids.push_back(e.id);
+            lockfree::CommandRing* ring;
+            bool                   last;
+            {
+                const std::scoped_lock lock{ _create_commands_lock };
+                ring = _create_commands.front().get();
+                last = std::size(_create_commands) == 1;
+            }
+            ring->consume(visitor);
+            if (last)
+                return;
+
+            // producers moved to the next ring before the check, so this one has been fully consumed
+            std::unique_ptr<lockfree::CommandRing> drained;
+            {
+                const std::scoped_lock lock{ _create_commands_lock };
+                drained = std::move(_create_commands.front());
+                _create_commands.pop_front();
+            }
         }
-        _entities.ids.clear();
     }
 
-    void _this::_create_gpu_mesh(mesh_id id, const mesh& asset)
+    void _this::_execute_commands() noexcept
+    {
+        // payloads are read in place from the command stream
+        _consume_commands([this](std::uint32_t type, std::span<const std::byte> payload) {
+            switch (static_cast<_cmd>(type))
+            {
+                case _cmd::create_mesh:
+                {
+                    _mesh_create_cmd cmd;
+                    std::memcpy(&cmd, std::data(payload), sizeof(cmd));
+                    if (cmd.spilled)
+                    {
+                        const std::unique_ptr<std::byte[]> data{ cmd.spilled };
+                        const std::span<const std::byte>   spilled{ data.get(), cmd.vertex_bytes + cmd.index_bytes };
+                        _create_gpu_mesh(cmd.id, MeshView{ spilled.first(cmd.vertex_bytes), spilled.subspan(cmd.vertex_bytes) });
+                        break;
+                    }
+                    const auto verts = payload.subspan(sizeof(cmd), cmd.vertex_bytes);
+                    const auto index = payload.subspan(sizeof(cmd) + cmd.vertex_bytes, cmd.index_bytes);
+                    _create_gpu_mesh(cmd.id, MeshView{ verts, index });
+                    break;
+                }
+                case _cmd::create_shader:
+                    // TODO: impl
+                    break;
+
+                case _cmd::create_entity:
+                {
+                    _renderable_create_cmd cmd;
+                    std::memcpy(&cmd, std::data(payload), sizeof(cmd));
+                    _entities.push_back(cmd.id, cmd.info.mesh, material_id{}, pipeline_id{});
+                    break;
+                }
+            }
+        });
+
+        // destructions are executed after the creations submitted in the same update
+        _destroy_meshes.drain([this](mesh_id id) { _destroy_gpu_mesh(id); });
+        _destroy_shaders.drain([](shader_id) {
+            // TODO: impl
+        });
+        _destroy_entities.drain([this](render_id id) {
+            // swap and pop, the order of the entities is irrelevant
+            const auto ids = _entities.column<render_id>();
+            if (const auto it = std::find(std::begin(ids), std::end(ids), id); it != std::end(ids))
+                _entities.erase(static_cast<std::size_t>(std::distance(std::begin(ids), it)));
+        });
+    }
+
+    void _this::_create_gpu_mesh(mesh_id id, const MeshView& asset)
     {
         /*
         vulkan::mesh m{ _device, asset };
@@ -40,7 +129,7 @@ namespace drako
 
         const vulkan::memory_transfer info{};
 
-        const auto callback = [this, id]() { _transferred_meshes.push_back(id); };
+        const auto callback = [this, id]() { _transferred_meshes.enque(id); };
         _staging.submit(info, callback);
         */
         // TODO: impl
@@ -53,43 +142,95 @@ namespace drako
     _this::RenderSystem(const vulkan::Context& ctx) noexcept
         : _renderer(ctx)
     {
+        _create_commands.push_back(std::make_unique<lockfree::CommandRing>(_command_ring_bytes));
+    }
+
+    _this::~RenderSystem() noexcept
+    {
+        // release the data of the meshes that were never created
+        _consume_commands([](std::uint32_t type, std::span<const std::byte> payload) {
+            if (static_cast<_cmd>(type) == _cmd::create_mesh)
+            {
+                _mesh_create_cmd cmd;
+                std::memcpy(&cmd, std::data(payload), sizeof(cmd));
+                delete[] cmd.spilled;
+            }
+        });
     }
 
     void _this::create(mesh_id id, const mesh_create_info& m) noexcept
     {
         assert(id);
-        const _mesh_create_cmd cmd{ id, m };
-        _create_meshes.push_back(cmd);
+        const auto verts = m.data.vertex_buffer();
+        const auto index = m.data.index_buffer();
+        const auto bytes = std::size(verts) + std::size(index);
+        assert(std::size(verts) <= UINT32_MAX && std::size(index) <= UINT32_MAX);
+
+        // small meshes are copied once, straight into the command stream,
+        // large ones would fill it up and are copied to the heap before taking the lock
+        std::unique_ptr<std::byte[]> spilled;
+        if (bytes > _inline_mesh_bytes)
+        {
+            spilled = std::make_unique_for_overwrite<std::byte[]>(bytes);
+            std::memcpy(spilled.get(), std::data(verts), std::size(verts));
+            std::memcpy(spilled.get() + std::size(verts), std::data(index), std::size(index));
+        }
+        const _mesh_create_cmd cmd{ .id = id,
+            .vertex_bytes = static_cast<std::uint32_t>(std::size(verts)),
+            .index_bytes  = static_cast<std::uint32_t>(std::size(index)),
+            .spilled      = spilled.get() };
+
+        const std::scoped_lock lock{ _create_commands_lock };
+        auto dst = std::data(_reserve_command(_cmd::create_mesh, sizeof(cmd) + (spilled ? 0 : bytes)));
+        std::memcpy(dst, &cmd, sizeof(cmd));
+        if (!spilled)
+        {
+            std::memcpy(dst += sizeof(cmd), std::data(verts), std::size(verts));
+            std::memcpy(dst += std::size(verts), std::data(index), std::size(index));
+        }
+        _create_commands.back()->commit();
+        spilled.release(); // owned by the command
     }
 
     void _this::create(shader_id id, const shader_create_info& s) noexcept
     {
         assert(id);
         const _shader_create_cmd cmd{ id, s };
-        _create_shaders.push_back(cmd);
+        const std::scoped_lock   lock{ _create_commands_lock };
+        std::memcpy(std::data(_reserve_command(_cmd::create_shader, sizeof(cmd))), &cmd, sizeof(cmd));
+        _create_commands.back()->commit();
     }
 
     void _this::destroy(mesh_id id) noexcept
     {
         assert(id);
-        _destroy_meshes.push_back(id);
+        _destroy_meshes.enque(id);
     }
 
     void _this::destroy(shader_id id) noexcept
     {
         assert(id);
-        _destroy_shaders.push_back(id);
+        _destroy_shaders.enque(id);
+    }
+
+    void _this::destroy(render_id id) noexcept
+    {
+        assert(id);
+        _destroy_entities.enque(id);
     }
 
     void _this::create(render_id id, const renderable_create_info& info) noexcept
     {
         assert(id);
-        _renderable_create_cmd cmd{ id, info };
-        _create_entities.push_back(cmd);
+        const _renderable_create_cmd cmd{ id, info };
+        const std::scoped_lock       lock{ _create_commands_lock };
+        std::memcpy(std::data(_reserve_command(_cmd::create_entity, sizeof(cmd))), &cmd, sizeof(cmd));
+        _create_commands.back()->commit();
     }
 
     void _this::update(const frame_render_soa& data) noexcept
     {
+        _execute_commands();
         _update_meshes();
         _update_entities();
 
@@ -2,6 +2,9 @@
 #ifndef INPUT_SYSTEM_HPP
 #define INPUT_SYSTEM_HPP
 
+#include "drako/concurrency/frame_arena.hpp"
+#include "drako/concurrency/lockfree_mpsc_queue.hpp"
+#include "drako/core/container/soa.hpp"
 #include "drako/core/typed_handle.hpp"
 #include "drako/input/device_system.hpp"
 #include "drako/input/device_types.hpp"
@@ -95,64 +98,32 @@ namespace input
     private:
         DeviceInputState _last_state;
 
-        std::vector<EventID>          _temp_event_buffer;
+        // storage for temporaries of a single update cycle
+        drako::FrameArena _frame_arena{ { .frames = 1, .frame_size = 16 * 1024, .chunk_size = 4 * 1024 } };
+
         std::vector<Action::Callback> _temp_invoke_buffer;
 
 #if defined(_WIN32) || defined(__linux__) || defined(__APPLE__)
         /*vvv Include bindings for the system main keyboard vvv*/
 
-        struct _keyboard_keys_bindings_table
-        {
-            std::vector<BindingID>        binding; // unique id of the binding
-            std::vector<KeyboardKeyID>    key;     // associated physical key on the keyboard
-            std::vector<BooleanControlID> control; // associated virtual control
-            std::vector<std::string>      name;    // debug-only friendly name
-        } _keyboard_keys_bindings;
+        // columns: unique id of the binding, associated physical key on the keyboard,
+        // associated virtual control, debug-only friendly name
+        drako::soa::Table<BindingID, KeyboardKeyID, BooleanControlID, std::string> _keyboard_keys_bindings;
 #endif
 
-        struct _gamepad_button_bindings_table
-        {
-            std::vector<BindingID>        binding; // unique id of the binding instance
-            std::vector<GamepadButtonID>  button;  // associated physical button on the gamepad
-            std::vector<BooleanControlID> control; // associated virtual control
-            std::vector<std::string>      name;    // debug-only friendly name
-        } _gamepad_button_bindings;
+        // columns: unique id of the binding instance, associated physical button on the gamepad,
+        // associated virtual control, debug-only friendly name
+        drako::soa::Table<BindingID, GamepadButtonID, BooleanControlID, std::string> _gamepad_button_bindings;
 
-        struct _gamepad_axes_bindings_table
-        {
-            std::vector<BindingID>     binding; // unique id of the binding instance
-            std::vector<GamepadAxisID> axis;    // associated physical button on the gamepad
-            std::vector<AxisControlID> control; // associated virtual control
-            std::vector<std::string>   name;    // debug-only friendly name
-        } _gamepad_axes_bindings;
+        // columns: unique id of the binding instance, associated physical axis on the gamepad,
+        // associated virtual control, debug-only friendly name
+        drako::soa::Table<BindingID, GamepadAxisID, AxisControlID, std::string> _gamepad_axes_bindings;
 
-        struct _on_press_table
-        {
-            // TODO: vvv these need to be threadsafe
-            //std::vector<on_press>     pending_create;
-            //std::vector<on_press::id> pending_destroy;
-            //std::vector<on_press::id> pending_enable;
-            //std::vector<on_press::id> pending_disable;
-            // ^^^
-
-            std::vector<EventID>          event;
-            std::vector<BooleanControlID> control;
-            std::vector<std::string>      name;
-        } _on_press;
-
-        struct _on_release_table
-        {
-            // TODO: vvv these need to be threadsafe
-            //std::vector<on_release>     pending_create;
-            //std::vector<on_release::id> pending_destroy;
-            //std::vector<on_release::id> pending_enable;
-            //std::vector<on_release::id> pending_disable;
-            // ^^^
-
-            std::vector<EventID>          event;
-            std::vector<BooleanControlID> control;
-            std::vector<std::string>      name;
-        } _on_release;
+        // columns: triggered event, virtual control, debug-only friendly name
+        drako::soa::Table<EventID, BooleanControlID, std::string> _on_press;
+
+        // columns: triggered event, virtual control, debug-only friendly name
+        drako::soa::Table<EventID, BooleanControlID, std::string> _on_release;
 
         /*struct _on_hold_table
         {
@@ -163,20 +134,27 @@ namespace input
             std::vector<float>       elapsed;
         } _on_hold;*/
 
+        struct _action_toggle
+        {
+            Action::ID id;
+            bool       enabled;
+        };
+
         struct _actions_table
         {
-            // TODO: thread safety
-            std::vector<Action>     pending_create;
-            std::vector<Action::ID> pending_destroy;
-            std::vector<Action::ID> pending_enable;
-            std::vector<Action::ID> pending_disable;
-            // ^^^
-
-            std::vector<Action::ID>       action;   // unique id of each action instance
-            std::vector<EventID>          event;    // trigger event
-            std::vector<Action::Callback> callback; // reaction to the trigger
-            std::vector<std::string>      name;     // debug-only friendly name
+            // requests submitted by any thread, drained once per update;
+            // enable and disable share a queue, so that they're applied in submission order
+            drako::lockfree::SR_MW_Queue<Action>         pending_create;
+            drako::lockfree::SR_MW_Queue<Action::ID>     pending_destroy;
+            drako::lockfree::SR_MW_Queue<_action_toggle> pending_toggle;
+
+            // columns: unique id of each action instance, trigger event, reaction to the trigger,
+            // debug-only friendly name, whether the action reacts to its trigger
+            drako::soa::Table<Action::ID, EventID, Action::Callback, std::string, bool> rows;
         } _actions;
+
+        // applies the requests submitted since the last update
+        void _update_actions() noexcept;
     };
 
 } // namespace input
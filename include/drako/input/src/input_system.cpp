@@ -1,8 +1,10 @@
 #include "drako/input/input_system.hpp"
 
+#include "drako/core/container/small_vector.hpp"
 #include "drako/devel/logging.hpp"
 #include "drako/input/device_types.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -11,7 +13,7 @@ namespace input
     void InputSystemRuntime::create(const Action& a)
     {
         assert(a.instance);
-        _actions.pending_create.push_back(a);
+        _actions.pending_create.enque(a);
     }
 
     void InputSystemRuntime::create(const GamepadButtonBinding& b)
@@ -20,29 +22,25 @@ namespace input
         assert(b.button);
         assert(b.control);
 
-        auto& t = _gamepad_button_bindings;
-        t.binding.push_back(b.id);
-        t.button.push_back(b.button);
-        t.control.push_back(b.control);
-        t.name.push_back(b.name);
+        _gamepad_button_bindings.push_back(b.id, b.button, b.control, b.name);
     }
 
     void InputSystemRuntime::destroy(const Action::ID id) noexcept
     {
         assert(id);
-        _actions.pending_destroy.push_back(id);
+        _actions.pending_destroy.enque(id);
     }
 
     void InputSystemRuntime::enable(const Action::ID id) noexcept
     {
         assert(id);
-        _actions.pending_enable.push_back(id);
+        _actions.pending_toggle.enque(_action_toggle{ .id = id, .enabled = true });
     }
 
     void InputSystemRuntime::disable(const Action::ID id) noexcept
     {
         assert(id);
-        _actions.pending_enable.push_back(id);
+        _actions.pending_toggle.enque(_action_toggle{ .id = id, .enabled = false });
     }
 
     /*
@@ -73,12 +71,13 @@ namespace input
 
     void InputSystemRuntime::bind(BindingID b, GamepadButtonID button) noexcept
     {
-        auto& t = _gamepad_button_bindings;
-        if (const auto f = std::find(std::cbegin(t.binding), std::cend(t.binding), b);
-            f != std::cend(t.binding))
+        const auto bindings = _gamepad_button_bindings.column<BindingID>();
+        if (const auto f = std::find(std::cbegin(bindings), std::cend(bindings), b);
+            f != std::cend(bindings))
         {
-            const auto index = static_cast<std::size_t>(std::distance(std::cbegin(t.binding), f));
-            t.button[index]  = button;
+            const auto index = static_cast<std::size_t>(std::distance(std::cbegin(bindings), f));
+
+            _gamepad_button_bindings.column<GamepadButtonID>()[index] = button;
         }
     }
 
@@ -87,10 +86,7 @@ namespace input
         assert(g.control);
         assert(g.event);
 
-        auto& t = _on_press;
-        t.control.push_back(g.control);
-        t.event.push_back(g.event);
-        t.name.push_back(g.name);
+        _on_press.push_back(g.event, g.control, g.name);
     }
 
     void InputSystemRuntime::create_release_gesture(const Gesture& g)
@@ -98,10 +94,33 @@ namespace input
         assert(g.control);
         assert(g.event);
 
-        auto& t = _on_release;
-        t.control.push_back(g.control);
-        t.event.push_back(g.event);
-        t.name.push_back(g.name);
+        _on_release.push_back(g.event, g.control, g.name);
+    }
+
+    void InputSystemRuntime::_update_actions() noexcept
+    {
+        auto& t = _actions;
+
+        // index of an action in the table, if any
+        const auto find = [&t](const Action::ID id) {
+            const auto ids = t.rows.column<Action::ID>();
+            const auto it  = std::find(std::cbegin(ids), std::cend(ids), id);
+            return static_cast<std::size_t>(std::distance(std::cbegin(ids), it));
+        };
+
+        t.pending_create.drain([&t](Action&& a) {
+            t.rows.emplace_back(a.instance, a.event, std::move(a.reaction), std::move(a.name), true);
+        });
+
+        t.pending_destroy.drain([&](const Action::ID id) {
+            if (const auto i = find(id); i < std::size(t.rows))
+                t.rows.erase(i); // swap and pop, the order of the actions is irrelevant
+        });
+
+        t.pending_toggle.drain([&](const _action_toggle& toggle) {
+            if (const auto i = find(toggle.id); i < std::size(t.rows))
+                t.rows.column<bool>()[i] = toggle.enabled;
+        });
     }
 
     void InputSystemRuntime::update() noexcept
@@ -122,20 +141,18 @@ namespace input
         _on_release.pending_destroy.clear();
         */
 
-        for (const auto& a : _actions.pending_create)
-        {
-            _actions.action.push_back(a.instance);
-            _actions.event.push_back(a.event);
-            _actions.name.push_back(a.name);
-            _actions.callback.push_back(a.reaction);
-        }
-        _actions.pending_create.clear();
+        _update_actions();
 
         const auto [state, ec] = query_gamepad_state(GamepadPlayerPort{ 0 });
         if (ec)
             return;
 
-        std::vector<BooleanControlID> pressed, released; // could use alloca() instead
+        _frame_arena.advance(); // temporaries of the previous update are no longer referenced
+        const drako::FrameAllocator<BooleanControlID> alloc{ _frame_arena };
+
+        // few buttons change in a single update, so they stay inline
+        using _controls = drako::SmallVector<BooleanControlID, 16, drako::FrameAllocator<BooleanControlID>>;
+        _controls pressed{ alloc }, released{ alloc };
 
         const auto changed_from_last_update = _last_state.buttons ^ state.buttons;
         {
@@ -152,23 +169,33 @@ namespace input
         }
         _last_state = state;
 
-        _temp_event_buffer.clear(); // could use alloca() instead
-        for (const auto c : pressed)
-            for (auto i = 0; i < std::size(_on_press.control); ++i)
-                if (_on_press.control[i] == c)
-                    _temp_event_buffer.push_back(_on_press.event[i]);
-
-        for (const auto c : released)
-            for (auto i = 0; i < std::size(_on_release.control); ++i)
-                if (_on_release.control[i] == c)
-                    _temp_event_buffer.push_back(_on_release.event[i]);
+        std::vector<EventID, drako::FrameAllocator<EventID>> events{ alloc };
+        {
+            const auto controls = _on_press.column<BooleanControlID>();
+            const auto targets  = _on_press.column<EventID>();
+            for (const auto c : pressed)
+                for (auto i = 0; i < std::size(controls); ++i)
+                    if (controls[i] == c)
+                        events.push_back(targets[i]);
+        }
+        {
+            const auto controls = _on_release.column<BooleanControlID>();
+            const auto targets  = _on_release.column<EventID>();
+            for (const auto c : released)
+                for (auto i = 0; i < std::size(controls); ++i)
+                    if (controls[i] == c)
+                        events.push_back(targets[i]);
+        }
 
         /*vvv join selected actions with matching callbacks from actions table vvv*/
         _temp_invoke_buffer.clear();
-        for (const auto e : _temp_event_buffer)
-            for (auto i = 0; i < std::size(_actions.action); ++i)
-                if (e == _actions.event[i])
-                    _temp_invoke_buffer.push_back(_actions.callback[i]);
+        const auto triggers  = _actions.rows.column<EventID>();
+        const auto callbacks = _actions.rows.column<Action::Callback>();
+        const auto enabled   = _actions.rows.column<bool>();
+        for (const auto e : events)
+            for (auto i = 0; i < std::size(triggers); ++i)
+                if (e == triggers[i] && enabled[i])
+                    _temp_invoke_buffer.push_back(callbacks[i]);
 
         for (auto c : _temp_invoke_buffer)
             std::invoke(c);
@@ -178,10 +205,11 @@ namespace input
     {
         std::cout << "[INFO] Input System [actions] table:\n"
                   << "\t[instance-id]\t[name]\t[event]\n";
-        for (auto i = 0; i < std::size(_actions.action); ++i)
-            std::cout << '\t' << _actions.action[i]
-                      << '\t' << _actions.name[i]
-                      << '\t' << _actions.event[i]
+        const auto& t = _actions.rows;
+        for (auto i = 0; i < std::size(t); ++i)
+            std::cout << '\t' << t.column<Action::ID>()[i]
+                      << '\t' << t.column<std::string>()[i]
+                      << '\t' << t.column<EventID>()[i]
                       << std::endl;
     }
 
@@ -190,11 +218,11 @@ namespace input
         const auto& t = _gamepad_button_bindings;
         std::cout << "[INFO] Input System [gamepad-bindings] table:\n"
                   << "\t[name]\t[id]\t[button]\t[control]\n";
-        for (auto i = 0; i < std::size(t.name); ++i)
-            std::cout << '\t' << t.name[i]
-                      << '\t' << t.binding[i]
-                      << '\t' << t.button[i]
-                      << '\t' << t.control[i]
+        for (auto i = 0; i < std::size(t); ++i)
+            std::cout << '\t' << t.column<std::string>()[i]
+                      << '\t' << t.column<BindingID>()[i]
+                      << '\t' << t.column<GamepadButtonID>()[i]
+                      << '\t' << t.column<BooleanControlID>()[i]
                       << std::endl;
 
         // TODO: also print axis table
@@ -205,9 +233,9 @@ namespace input
         const auto& t = _on_press;
         std::cout << "[INFO] Input System [on-press] table:\n"
                   << "\t[Event ID]\t[Control ID]\n";
-        for (auto i = 0; i < std::size(t.event); ++i)
-            std::cout << '\t' << t.event[i]
-                      << '\t' << t.control[i]
+        for (auto i = 0; i < std::size(t); ++i)
+            std::cout << '\t' << t.column<EventID>()[i]
+                      << '\t' << t.column<BooleanControlID>()[i]
                       << std::endl;
     }
 
@@ -216,9 +244,9 @@ namespace input
         const auto& t = _on_release;
         std::cout << "[INFO] Input System [on-release] table:\n"
                   << "\t[Event ID]\t[Control ID]\n";
-        for (auto i = 0; i < std::size(t.event); ++i)
-            std::cout << '\t' << t.event[i]
-                      << '\t' << t.control[i]
+        for (auto i = 0; i < std::size(t); ++i)
+            std::cout << '\t' << t.column<EventID>()[i]
+                      << '\t' << t.column<BooleanControlID>()[i]
                       << std::endl;
     }
 
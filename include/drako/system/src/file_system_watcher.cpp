@@ -9,6 +9,7 @@
 #include <filesystem>
 #include <system_error>
 #include <thread>
+#include <vector>
 
 #include <iostream>
 
@@ -29,6 +30,16 @@ namespace sys
     {
     }
 
+    // move all the events currently in the queue with a single publish
+    template <typename T>
+    void _drain(drako::lockfree::RingBuffer<T>& q, std::vector<T>& out)
+    {
+        const auto first = std::size(out);
+        out.resize(first + std::size(q));
+        const auto count = q.deque_bulk({ std::data(out) + first, std::size(out) - first });
+        out.resize(first + count);
+    }
+
     void Watcher::_poll()
     {
         const auto filter = FILE_NOTIFY_CHANGE_FILE_NAME
@@ -56,10 +67,14 @@ namespace sys
 
             if (!ok)
             {
-                if (ok == ERROR_OPERATION_ABORTED)
+                const auto error = ::GetLastError();
+                if (error == ERROR_OPERATION_ABORTED)
                     return; // end worker task
-                else
-                    _errors.enque(std::error_code(::GetLastError(), std::system_category()));
+
+                // the failure is usually permanent (e.g. the directory has been removed),
+                // report it and stop instead of looping on the same error
+                _errors.enque(std::error_code(error, std::system_category()));
+                return;
                 //std::cout << std::error_code(::GetLastError(), std::system_category()).message() << '\n';
                 //throw std::system_error(::GetLastError(), std::system_category());
             }
@@ -250,18 +265,10 @@ namespace sys
         */
 
         PollResult pr;
-        for (fs::path p; _created.deque(p);)
-            pr.created.emplace_back(std::move(p));
-
-        for (fs::path p; _removed.deque(p);)
-            pr.removed.emplace_back(std::move(p));
-
-        for (fs::path p; _modified.deque(p);)
-            pr.modified.emplace_back(std::move(p));
-
-        for (std::error_code ec; _errors.deque(ec);)
-            pr.errors.emplace_back(ec);
-
+        _drain(_created, pr.created);
+        _drain(_removed, pr.removed);
+        _drain(_modified, pr.modified);
+        _drain(_errors, pr.errors);
         return pr;
 #endif
     }
@@ -0,0 +1,57 @@
+#include "drako/system/system_info.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace drako::sys
+{
+    [[nodiscard]] std::size_t cpu_topology::physical_core_count() const
+    {
+        std::set<std::pair<std::uint32_t, std::uint32_t>> cores;
+        for (const auto& c : cpus)
+            cores.emplace(c.package, c.core);
+        return std::size(cores);
+    }
+
+    [[nodiscard]] std::size_t cpu_topology::package_count() const
+    {
+        std::set<std::uint32_t> packages;
+        for (const auto& c : cpus)
+            packages.insert(c.package);
+        return std::size(packages);
+    }
+
+    [[nodiscard]] std::vector<std::uint32_t> cpu_topology::smt_siblings(std::uint32_t cpu) const
+    {
+        const auto it = std::find_if(std::cbegin(cpus), std::cend(cpus),
+            [cpu](const auto& c) { return c.id == cpu; });
+        if (it == std::cend(cpus))
+            return {};
+
+        std::vector<std::uint32_t> siblings;
+        for (const auto& c : cpus)
+            if (c.package == it->package && c.core == it->core)
+                siblings.push_back(c.id);
+        return siblings;
+    }
+
+    [[nodiscard]] const cpu_cache_info* cpu_topology::cache(
+        std::uint32_t cpu, std::uint32_t level, cpu_cache_type type) const noexcept
+    {
+        const cpu_cache_info* unified = nullptr;
+        for (const auto& c : caches)
+        {
+            if (c.level != level || std::find(std::cbegin(c.shared_cpu), std::cend(c.shared_cpu), cpu) == std::cend(c.shared_cpu))
+                continue;
+            if (c.type == type)
+                return &c;
+            if (c.type == cpu_cache_type::unified)
+                unified = &c;
+        }
+        return unified;
+    }
+
+} // namespace drako::sys
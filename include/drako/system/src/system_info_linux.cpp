@@ -0,0 +1,389 @@
+#include "drako/system/system_info.hpp"
+
+#include "drako/core/compiler.hpp"
+#include "drako/core/platform.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <sched.h>
+#include <sys/sysinfo.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if !defined(DRAKO_PLT_LINUX)
+#error This source file should be included only on Linux builds
+#endif
+
+namespace drako::sys
+{
+    namespace _fs = std::filesystem;
+
+    const _fs::path _sysfs_cpu  = "/sys/devices/system/cpu";
+    const _fs::path _sysfs_node = "/sys/devices/system/node";
+
+    // reads the first line of a sysfs attribute
+    [[nodiscard]] std::optional<std::string> _read_attribute(const _fs::path& p)
+    {
+        std::ifstream file{ p };
+        std::string   line;
+        if (!file || !std::getline(file, line))
+            return std::nullopt;
+        return line;
+    }
+
+    [[nodiscard]] std::optional<std::uint64_t> _read_number(const _fs::path& p)
+    {
+        const auto text = _read_attribute(p);
+        if (!text)
+            return std::nullopt;
+
+        std::uint64_t value;
+        const auto [last, ec] = std::from_chars(text->data(), text->data() + text->size(), value);
+        if (ec != std::errc{})
+            return std::nullopt;
+
+        // sizes are reported with a unit suffix, as in '32K'
+        switch (last != text->data() + text->size() ? *last : '\0')
+        {
+            case 'K': return value * 1024;
+            case 'M': return value * 1024 * 1024;
+            case 'G': return value * 1024 * 1024 * 1024;
+            default: return value;
+        }
+    }
+
+    // parses a list of processors in the format '0-3,8,10-11'
+    [[nodiscard]] std::vector<std::uint32_t> _parse_cpu_list(std::string_view list)
+    {
+        std::vector<std::uint32_t> cpus;
+        while (!std::empty(list))
+        {
+            const auto comma = list.find(',');
+            const auto range = list.substr(0, comma);
+            list             = (comma == std::string_view::npos) ? std::string_view{} : list.substr(comma + 1);
+
+            std::uint32_t first, last;
+            const auto    end = range.data() + range.size();
+            auto [p, ec]      = std::from_chars(range.data(), end, first);
+            if (ec != std::errc{})
+                continue;
+            last = first;
+            if (p != end && *p == '-')
+                std::from_chars(p + 1, end, last);
+
+            for (auto c = first; c <= last; ++c)
+                cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+    // numeric suffix of names such as 'cpu12' or 'node1'
+    [[nodiscard]] std::optional<std::uint32_t> _index_suffix(std::string_view name, std::string_view prefix)
+    {
+        if (!name.starts_with(prefix) || name.size() == prefix.size())
+            return std::nullopt;
+
+        std::uint32_t index;
+        const auto    end = name.data() + name.size();
+        if (const auto [p, ec] = std::from_chars(name.data() + prefix.size(), end, index); ec != std::errc{} || p != end)
+            return std::nullopt;
+        return index;
+    }
+
+
+    [[nodiscard]] native_cpu_core current_process_cpu() noexcept
+    {
+        const auto cpu = ::sched_getcpu();
+        return native_cpu_core{ static_cast<std::uint32_t>(std::max(cpu, 0)) };
+    }
+
+    [[nodiscard]] std::uint32_t cpu_logical_core_count() noexcept
+    {
+        const auto count = ::get_nprocs();
+        assert(count > 0);
+        return static_cast<std::uint32_t>(count);
+    }
+
+    [[nodiscard]] std::uint32_t cpu_memory_page_size() noexcept
+    {
+        const auto size = ::sysconf(_SC_PAGESIZE);
+        assert(size > 0);
+        return static_cast<std::uint32_t>(size);
+    }
+
+    [[nodiscard]] std::int64_t cpu_counter_value() noexcept
+    {
+        timespec t;
+        ::clock_gettime(CLOCK_MONOTONIC, &t);
+        return static_cast<std::int64_t>(t.tv_sec) * 1'000'000'000 + t.tv_nsec;
+    }
+
+    [[nodiscard]] std::int64_t cpu_counter_frequency() noexcept
+    {
+        return 1'000'000'000; // the monotonic clock counts nanoseconds
+    }
+
+    [[nodiscard]] native_numa_node cpu_numa_node(native_cpu_core core, std::error_code& ec) noexcept
+    {
+        ec.clear();
+
+        // the processor directory contains a link to its memory node
+        const auto cpu_dir = _sysfs_cpu / ("cpu" + std::to_string(core.cpu_number));
+        for (const auto& entry : _fs::directory_iterator{ cpu_dir, ec })
+            if (const auto node = _index_suffix(entry.path().filename().native(), "node"))
+                return native_numa_node{ *node };
+
+        if (!ec && !_fs::exists(_sysfs_node, ec)) // kernel without NUMA support, there is a single node
+            return native_numa_node{ 0 };
+        if (!ec)
+            ec = std::make_error_code(std::errc::no_such_device);
+        return native_numa_node{ 0 };
+    }
+
+    [[nodiscard]] native_numa_node cpu_numa_node(native_cpu_core core)
+    {
+        std::error_code ec;
+        const auto      node = cpu_numa_node(core, ec);
+        if (ec)
+            throw std::system_error(ec);
+        return node;
+    }
+
+
+    [[nodiscard]] std::vector<cpu_numa_node_info> _query_numa_nodes(const std::vector<cpu_logical_core_info>& cpus)
+    {
+        std::vector<cpu_numa_node_info> nodes;
+
+        std::error_code ec;
+        for (const auto& entry : _fs::directory_iterator{ _sysfs_node, ec })
+        {
+            const auto id = _index_suffix(entry.path().filename().native(), "node");
+            if (!id)
+                continue;
+
+            cpu_numa_node_info node{ .id = *id, .cpus = {}, .memory_bytes = 0 };
+            if (const auto list = _read_attribute(entry.path() / "cpulist"))
+                node.cpus = _parse_cpu_list(*list);
+
+            // line format: 'Node 0 MemTotal:  4816632 kB'
+            std::ifstream meminfo{ entry.path() / "meminfo" };
+            for (std::string line; std::getline(meminfo, line);)
+                if (const auto at = line.find("MemTotal:"); at != std::string::npos)
+                {
+                    std::istringstream{ line.substr(at + 9) } >> node.memory_bytes;
+                    node.memory_bytes *= 1024;
+                    break;
+                }
+            nodes.push_back(std::move(node));
+        }
+
+        if (std::empty(nodes)) // kernel without NUMA support, all the processors share the memory
+        {
+            cpu_numa_node_info node{ .id = 0, .cpus = {},
+                .memory_bytes = static_cast<std::size_t>(::sysconf(_SC_PHYS_PAGES)) * cpu_memory_page_size() };
+            for (const auto& c : cpus)
+                node.cpus.push_back(c.id);
+            nodes.push_back(std::move(node));
+        }
+
+        std::sort(std::begin(nodes), std::end(nodes), [](const auto& a, const auto& b) { return a.id < b.id; });
+        return nodes;
+    }
+
+    [[nodiscard]] std::vector<cpu_cache_info> _query_caches_sysfs(const std::vector<cpu_logical_core_info>& cpus)
+    {
+        std::vector<cpu_cache_info> caches;
+        for (const auto& c : cpus)
+        {
+            const auto cache_dir = _sysfs_cpu / ("cpu" + std::to_string(c.id)) / "cache";
+
+            std::error_code ec;
+            for (const auto& entry : _fs::directory_iterator{ cache_dir, ec })
+            {
+                if (!_index_suffix(entry.path().filename().native(), "index"))
+                    continue;
+
+                const auto level = _read_number(entry.path() / "level");
+                const auto type  = _read_attribute(entry.path() / "type");
+                const auto size  = _read_number(entry.path() / "size");
+                const auto list  = _read_attribute(entry.path() / "shared_cpu_list");
+                if (!level || !type || !size || !list)
+                    continue;
+
+                cpu_cache_info cache{ .level = static_cast<std::uint32_t>(*level),
+                    .type                    = cpu_cache_type::unified,
+                    .size                    = static_cast<std::size_t>(*size),
+                    .line_size               = static_cast<std::size_t>(
+                        _read_number(entry.path() / "coherency_line_size").value_or(0)),
+                    .shared_cpu = _parse_cpu_list(*list) };
+                if (*type == "Data")
+                    cache.type = cpu_cache_type::data;
+                else if (*type == "Instruction")
+                    cache.type = cpu_cache_type::instruction;
+
+                // shared caches are listed by each processor that uses them
+                const auto duplicate = std::any_of(std::cbegin(caches), std::cend(caches), [&](const auto& other) {
+                    return std::tie(other.level, other.type, other.shared_cpu) == std::tie(cache.level, cache.type, cache.shared_cpu);
+                });
+                if (!duplicate)
+                    caches.push_back(std::move(cache));
+            }
+        }
+        return caches;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // appends the caches described by a cpuid leaf with the layout of leaf 4
+    void _query_caches_cpuid(unsigned int leaf, const cpu_topology& t, std::vector<cpu_cache_info>& caches)
+    {
+        unsigned int eax, ebx, ecx, edx;
+        for (unsigned int index = 0;; ++index)
+        {
+            __cpuid_count(leaf, index, eax, ebx, ecx, edx);
+            const auto type = eax & 0x1F;
+            if (type == 0) // no more caches
+                break;
+
+            const auto level      = (eax >> 5) & 0x7;
+            const auto sharing    = ((eax >> 14) & 0xFFF) + 1;
+            const auto line_size  = (ebx & 0xFFF) + 1;
+            const auto partitions = ((ebx >> 12) & 0x3FF) + 1;
+            const auto ways       = ((ebx >> 22) & 0x3FF) + 1;
+            const auto sets       = ecx + 1;
+
+            const cpu_cache_info desc{ .level = level,
+                .type      = (type == 1) ? cpu_cache_type::data
+                             : (type == 2) ? cpu_cache_type::instruction
+                                           : cpu_cache_type::unified,
+                .size      = std::size_t{ ways } * partitions * line_size * sets,
+                .line_size = line_size,
+                .shared_cpu = {} };
+
+            // the sharing set isn't reported as processor ids,
+            // so assume that a cache is private to a core unless it serves more threads than a core has
+            for (const auto& c : t.cpus)
+            {
+                const auto siblings = t.smt_siblings(c.id);
+                const auto per_core = sharing <= std::size(siblings);
+                if (per_core ? (siblings.front() != c.id) : std::any_of(std::cbegin(t.cpus), std::cend(t.cpus),
+                        [&](const auto& o) { return o.package == c.package && o.id < c.id; }))
+                    continue; // the cache was already recorded by the first processor of the group
+
+                auto cache = desc;
+                if (per_core)
+                    cache.shared_cpu = siblings;
+                else
+                    for (const auto& o : t.cpus)
+                        if (o.package == c.package)
+                            cache.shared_cpu.push_back(o.id);
+                caches.push_back(std::move(cache));
+            }
+        }
+    }
+
+    // some virtualized environments don't expose the caches in sysfs, the processor still describes them
+    [[nodiscard]] std::vector<cpu_cache_info> _query_caches_cpuid(const cpu_topology& t)
+    {
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid(0, &eax, &ebx, &ecx, &edx) == 0)
+            return {};
+
+        // the vendor string is stored in ebx, edx, ecx
+        char vendor[12];
+        std::memcpy(vendor + 0, &ebx, 4);
+        std::memcpy(vendor + 4, &edx, 4);
+        std::memcpy(vendor + 8, &ecx, 4);
+        const std::string_view vendor_id{ vendor, std::size(vendor) };
+        const auto             amd = vendor_id == "AuthenticAMD" || vendor_id == "HygonGenuine";
+
+        // Intel reports caches in leaf 4, AMD in leaf 0x8000001D with the same layout;
+        // AMD processors accept leaf 4 too but always report it empty,
+        // and only when the topology extensions are supported (leaf 0x80000001, ecx bit 22)
+        const auto basic_leaf    = !amd && eax >= 4;
+        const auto extended_leaf = __get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) != 0 && eax >= 0x8000001D &&
+                                   __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) != 0 && (ecx & (1u << 22)) != 0;
+
+        std::vector<cpu_cache_info> caches;
+        if (basic_leaf)
+            _query_caches_cpuid(4, t, caches);
+        if (std::empty(caches) && extended_leaf)
+            _query_caches_cpuid(0x8000001D, t, caches);
+        return caches;
+    }
+#endif
+
+    [[nodiscard]] std::vector<std::size_t> _query_huge_page_sizes()
+    {
+        std::vector<std::size_t> sizes;
+
+        // directories are named as 'hugepages-2048kB'
+        std::error_code ec;
+        for (const auto& entry : _fs::directory_iterator{ "/sys/kernel/mm/hugepages", ec })
+        {
+            const auto name = entry.path().filename().native();
+            if (!name.starts_with("hugepages-"))
+                continue;
+
+            std::size_t kb;
+            const auto  first = name.data() + std::size(std::string_view{ "hugepages-" });
+            if (const auto [p, e] = std::from_chars(first, name.data() + name.size(), kb); e == std::errc{})
+                sizes.push_back(kb * 1024);
+        }
+        std::sort(std::begin(sizes), std::end(sizes));
+        return sizes;
+    }
+
+    [[nodiscard]] cpu_topology query_cpu_topology()
+    {
+        cpu_topology t;
+        t.page_size = cpu_memory_page_size();
+
+        auto online = _parse_cpu_list(_read_attribute(_sysfs_cpu / "online").value_or(""));
+        if (std::empty(online)) // sysfs not mounted, assume contiguous ids
+            for (std::uint32_t i = 0; i < cpu_logical_core_count(); ++i)
+                online.push_back(i);
+
+        for (const auto id : online)
+        {
+            const auto topology = _sysfs_cpu / ("cpu" + std::to_string(id)) / "topology";
+            t.cpus.push_back({ .id = id,
+                .core      = static_cast<std::uint32_t>(_read_number(topology / "core_id").value_or(id)),
+                .package   = static_cast<std::uint32_t>(_read_number(topology / "physical_package_id").value_or(0)),
+                .numa_node = 0 });
+        }
+
+        t.numa_nodes = _query_numa_nodes(t.cpus);
+        for (const auto& n : t.numa_nodes)
+            for (const auto cpu : n.cpus)
+                if (auto it = std::find_if(std::begin(t.cpus), std::end(t.cpus), [cpu](const auto& c) { return c.id == cpu; });
+                    it != std::end(t.cpus))
+                    it->numa_node = n.id;
+
+        t.caches = _query_caches_sysfs(t.cpus);
+#if defined(__x86_64__) || defined(__i386__)
+        if (std::empty(t.caches))
+            t.caches = _query_caches_cpuid(t);
+#endif
+
+        t.huge_page_sizes = _query_huge_page_sizes();
+        return t;
+    }
+
+} // namespace drako::sys
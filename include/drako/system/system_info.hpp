@@ -4,8 +4,10 @@
 
 #include "drako/core/platform.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <system_error>
+#include <vector>
 
 #if defined(DRAKO_PLT_WIN32)
 #include <Windows.h>
@@ -26,6 +28,15 @@ namespace drako::sys
 
         PROCESSOR_NUMBER cpu_number;
 
+#elif defined(DRAKO_PLT_LINUX)
+
+        constexpr explicit native_cpu_core(std::uint32_t cpu) noexcept
+            : cpu_number{ cpu }
+        {
+        }
+
+        std::uint32_t cpu_number; // index of the logical processor in cpu_set_t masks
+
 #else
 #error Platform not supported
 #endif
@@ -65,6 +76,15 @@ namespace drako::sys
 
         uint32_t guid;
 
+#elif defined(DRAKO_PLT_LINUX)
+
+        constexpr explicit native_numa_node(std::uint32_t id) noexcept
+            : guid{ id }
+        {
+        }
+
+        uint32_t guid;
+
 #else
 #error Platform not supported
 #endif
@@ -75,6 +95,74 @@ namespace drako::sys
     [[nodiscard]] native_numa_node cpu_numa_node(native_cpu_core);
     [[nodiscard]] native_numa_node cpu_numa_node(native_cpu_core, std::error_code&) noexcept;
 
+
+    // Descriptor of a logical processor.
+    struct cpu_logical_core_info
+    {
+        std::uint32_t id;        // index used by affinity masks
+        std::uint32_t core;      // physical core, unique only inside the package
+        std::uint32_t package;   // physical socket
+        std::uint32_t numa_node; // memory node local to the processor
+    };
+
+    enum class cpu_cache_type
+    {
+        data,
+        instruction,
+        unified
+    };
+
+    // Descriptor of a cache, shared by one or more logical processors.
+    struct cpu_cache_info
+    {
+        std::uint32_t              level;      // 1 for L1, 2 for L2, ...
+        cpu_cache_type             type;       // kind of content
+        std::size_t                size;       // capacity as bytes
+        std::size_t                line_size;  // size of a cache line as bytes
+        std::vector<std::uint32_t> shared_cpu; // logical processors served by the cache
+    };
+
+    // Descriptor of a NUMA node.
+    struct cpu_numa_node_info
+    {
+        std::uint32_t              id;
+        std::vector<std::uint32_t> cpus;         // local logical processors
+        std::size_t                memory_bytes; // local memory, zero if unknown
+    };
+
+    // Layout of processors, caches and memory nodes of the machine.
+    struct cpu_topology
+    {
+        std::vector<cpu_logical_core_info> cpus;       // online logical processors, sorted by id
+        std::vector<cpu_cache_info>        caches;     // each cache appears once
+        std::vector<cpu_numa_node_info>    numa_nodes; // sorted by id
+        std::size_t                        page_size = 0;
+        std::vector<std::size_t>           huge_page_sizes; // sorted in ascending order
+
+        // Gets the number of logical processors.
+        [[nodiscard]] std::size_t logical_core_count() const noexcept { return std::size(cpus); }
+
+        // Gets the number of physical cores, each one runs one or more logical processors.
+        [[nodiscard]] std::size_t physical_core_count() const;
+
+        // Gets the number of physical sockets.
+        [[nodiscard]] std::size_t package_count() const;
+
+        // Gets the logical processors that run on the same physical core, including the given one.
+        [[nodiscard]] std::vector<std::uint32_t> smt_siblings(std::uint32_t cpu) const;
+
+        // Gets the cache of a specific level that serves a logical processor, nullptr if not found.
+        // Unified caches are preferred for data lookups, instruction caches are returned only on request.
+        [[nodiscard]] const cpu_cache_info* cache(std::uint32_t cpu, std::uint32_t level,
+            cpu_cache_type type = cpu_cache_type::data) const noexcept;
+    };
+
+    // Discovers the topology of the machine.
+    //
+    // On Linux the layout is read from sysfs, cache descriptors fall back to cpuid when sysfs doesn't expose them.
+    //
+    [[nodiscard]] cpu_topology query_cpu_topology();
+
 } // namespace drako::sys
 
 #endif // !DRAKO_SYSTEM_INFO_HPP
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "drako/system/system_info.hpp"
+
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <set>
+
+using namespace drako::sys;
+
+GTEST_TEST(SystemInfo, Topology)
+{
+    const auto t = query_cpu_topology();
+
+    ASSERT_GT(t.logical_core_count(), 0);
+    EXPECT_EQ(t.logical_core_count(), cpu_logical_core_count());
+    EXPECT_LE(t.physical_core_count(), t.logical_core_count());
+    EXPECT_LE(t.package_count(), t.physical_core_count());
+    EXPECT_EQ(t.page_size, cpu_memory_page_size());
+    EXPECT_TRUE(std::is_sorted(std::cbegin(t.huge_page_sizes), std::cend(t.huge_page_sizes)));
+
+    // each processor belongs to exactly one memory node
+    ASSERT_FALSE(std::empty(t.numa_nodes));
+    std::multiset<std::uint32_t> assigned;
+    for (const auto& n : t.numa_nodes)
+        assigned.insert(std::cbegin(n.cpus), std::cend(n.cpus));
+    for (const auto& c : t.cpus)
+    {
+        EXPECT_EQ(assigned.count(c.id), 1);
+        EXPECT_EQ(cpu_numa_node(native_cpu_core{ c.id }).guid, c.numa_node);
+
+        const auto siblings = t.smt_siblings(c.id);
+        EXPECT_NE(std::find(std::cbegin(siblings), std::cend(siblings), c.id), std::cend(siblings));
+    }
+
+    // the first level data cache is private to a physical core
+    for (const auto& c : t.cpus)
+        if (const auto l1 = t.cache(c.id, 1); l1 != nullptr)
+        {
+            EXPECT_GT(l1->size, 0);
+            EXPECT_LE(std::size(l1->shared_cpu), std::size(t.smt_siblings(c.id)));
+        }
+}
+
+#endif